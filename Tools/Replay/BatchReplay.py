@@ -0,0 +1,214 @@
+#!/usr/bin/env python
+'''
+run Replay over a directory of logs and a matrix of parameter sets in
+parallel, and summarise the check-solution errors
+
+Each job is a separate Replay process run in its own scratch
+directory, so the output logs of concurrent jobs do not collide. Logs
+are mapped read-only by Replay, so concurrent jobs on the same log
+share the page cache.
+
+Parameter sets come from --param (applied to every job), --matrix
+(NAME=V1,V2,... , the cartesian product of all --matrix options is
+used) and --param-sets (a file with one parameter set per line, as
+NAME=VALUE pairs separated by spaces or commas)
+'''
+
+import glob
+import itertools
+import multiprocessing
+import optparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+parser = optparse.OptionParser("BatchReplay [options]")
+parser.add_option("--logdir", type='string', default='testlogs', help='directory of logs to use')
+parser.add_option("--pattern", type='string', default='*-checked.bin', help='glob pattern of logs in logdir')
+parser.add_option("--replay", type='string', default='./Replay.elf', help='path to Replay binary')
+parser.add_option("-j", "--jobs", type=int, default=multiprocessing.cpu_count(), help='number of parallel Replay processes')
+parser.add_option("--param", action='append', default=[], help='NAME=VALUE applied to every job')
+parser.add_option("--matrix", action='append', default=[], help='NAME=V1,V2,... values to sweep')
+parser.add_option("--param-sets", type='string', default=None, help='file with one parameter set per line')
+parser.add_option("--tolerance-euler", type=float, default=3, help="tolerance for euler angles in degrees")
+parser.add_option("--tolerance-pos", type=float, default=2, help="tolerance for position in meters")
+parser.add_option("--tolerance-vel", type=float, default=2, help="tolerance for velocity in meters/second")
+parser.add_option("--output", type='string', default='batch_results.txt', help='tab separated per-job results')
+parser.add_option("--keep-logs", action='store_true', default=False, help='keep the output logs of each job')
+
+opts, args = parser.parse_args()
+
+# names of the errors reported by Replay::report_checks(), in order
+error_names = ["Roll error", "Pitch error", "Yaw error", "Position error", "Velocity error"]
+error_re = re.compile(r'^(%s):\s+([-0-9.naif]+)' % '|'.join(error_names))
+
+
+def parse_param_list(items):
+    '''parse a list of NAME=VALUE strings into a list of (name, value)'''
+    ret = []
+    for item in items:
+        if '=' not in item:
+            print("Bad parameter '%s', expected NAME=VALUE" % item)
+            sys.exit(1)
+        name, value = item.split('=', 1)
+        ret.append((name.strip(), float(value)))
+    return ret
+
+
+def get_param_sets():
+    '''return the list of parameter sets to run, each a list of (name, value)'''
+    common = parse_param_list(opts.param)
+
+    sets = []
+    if opts.param_sets is not None:
+        for line in open(opts.param_sets):
+            line = line.split('#')[0].strip()
+            if len(line) == 0:
+                continue
+            sets.append(parse_param_list(re.split(r'[\s,]+', line)))
+
+    if len(opts.matrix) > 0:
+        axes = []
+        for m in opts.matrix:
+            if '=' not in m:
+                print("Bad matrix '%s', expected NAME=V1,V2,..." % m)
+                sys.exit(1)
+            name, values = m.split('=', 1)
+            axes.append([(name.strip(), float(v)) for v in values.split(',')])
+        matrix_sets = [list(p) for p in itertools.product(*axes)]
+        if len(sets) == 0:
+            sets = matrix_sets
+        else:
+            sets = [s + p for s in sets for p in matrix_sets]
+
+    if len(sets) == 0:
+        sets = [[]]
+    return [common + s for s in sets]
+
+
+def param_set_name(pset):
+    '''short description of a parameter set'''
+    if len(pset) == 0:
+        return "defaults"
+    return ",".join(["%s=%g" % (n, v) for (n, v) in pset])
+
+
+def get_log_list():
+    '''get a list of log files to process'''
+    if os.path.isfile(opts.logdir):
+        return [os.path.abspath(opts.logdir)]
+    pattern = os.path.join(opts.logdir, opts.pattern)
+    file_list = sorted(glob.glob(pattern))
+    if len(file_list) == 0:
+        print("No logs to process matching %s" % pattern)
+        sys.exit(1)
+    return [os.path.abspath(f) for f in file_list]
+
+
+def run_job(job):
+    '''run Replay on one log with one parameter set. Runs in a worker process'''
+    (logfile, pset) = job
+    replay = os.path.abspath(opts.replay)
+    cmd = [replay, "--", "--check",
+           "--tolerance-euler=%f" % opts.tolerance_euler,
+           "--tolerance-pos=%f" % opts.tolerance_pos,
+           "--tolerance-vel=%f" % opts.tolerance_vel]
+    for (name, value) in pset:
+        cmd.append("--parm=%s=%s" % (name, repr(value)))
+    cmd.append(logfile)
+
+    workdir = tempfile.mkdtemp(prefix="replay-")
+    try:
+        p = subprocess.Popen(cmd, cwd=workdir, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        output = p.communicate()[0]
+        returncode = p.returncode
+    finally:
+        if opts.keep_logs:
+            print("Output of %s with %s kept in %s" % (logfile, param_set_name(pset), workdir))
+        else:
+            shutil.rmtree(workdir, ignore_errors=True)
+
+    if not isinstance(output, str):
+        output = output.decode('utf-8', 'replace')
+
+    errors = {}
+    for line in output.splitlines():
+        m = error_re.match(line.strip())
+        if m is not None:
+            errors[m.group(1)] = float(m.group(2))
+
+    if len(errors) != len(error_names):
+        status = "FPE" if returncode < 0 else "ERROR"
+    elif "Checks passed" in output:
+        status = "PASS"
+    else:
+        status = "FAIL"
+    return (logfile, pset, status, [errors.get(n, None) for n in error_names])
+
+
+def format_error(e):
+    if e is None:
+        return "-"
+    return "%.3f" % e
+
+
+def summarise(results, param_sets):
+    '''print a summary table, one row per parameter set'''
+    print("")
+    print("%-40s %5s %5s %5s %9s %9s %9s %9s %9s" % (
+        "ParamSet", "Pass", "Fail", "Err", "MaxRoll", "MaxPitch", "MaxYaw", "MaxPos", "MaxVel"))
+    for pset in param_sets:
+        name = param_set_name(pset)
+        rows = [r for r in results if r[1] == pset]
+        npass = len([r for r in rows if r[2] == "PASS"])
+        nfail = len([r for r in rows if r[2] == "FAIL"])
+        nerr = len(rows) - npass - nfail
+        maxes = []
+        for i in range(len(error_names)):
+            values = [r[3][i] for r in rows if r[3][i] is not None]
+            maxes.append(max(values) if len(values) else None)
+        print("%-40s %5u %5u %5u %9s %9s %9s %9s %9s" % (
+            name[:40], npass, nfail, nerr,
+            format_error(maxes[0]), format_error(maxes[1]), format_error(maxes[2]),
+            format_error(maxes[3]), format_error(maxes[4])))
+
+
+def write_results(results):
+    '''write per-job results as tab separated values'''
+    f = open(opts.output, "w")
+    f.write("Log\tParams\tStatus\t%s\n" % "\t".join(error_names))
+    for (logfile, pset, status, errors) in results:
+        f.write("%s\t%s\t%s\t%s\n" % (logfile, param_set_name(pset), status,
+                                      "\t".join([format_error(e) for e in errors])))
+    f.close()
+    print("Wrote %s" % opts.output)
+
+
+def batch_replay():
+    log_list = get_log_list()
+    param_sets = get_param_sets()
+    jobs = [(log, pset) for pset in param_sets for log in log_list]
+    print("Running %u jobs (%u logs x %u parameter sets) on %u workers" % (
+        len(jobs), len(log_list), len(param_sets), opts.jobs))
+
+    pool = multiprocessing.Pool(processes=opts.jobs)
+    results = []
+    for r in pool.imap_unordered(run_job, jobs):
+        results.append(r)
+        print("[%u/%u] %s %s %s" % (len(results), len(jobs), r[2], os.path.basename(r[0]), param_set_name(r[1])))
+    pool.close()
+    pool.join()
+
+    results.sort(key=lambda r: (param_set_name(r[1]), r[0]))
+    write_results(results)
+    summarise(results, param_sets)
+
+    if len([r for r in results if r[2] != "PASS"]) != 0:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    batch_replay()
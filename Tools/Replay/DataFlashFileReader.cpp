@@ -1,7 +1,10 @@
 #include "DataFlashFileReader.h"
 
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -20,6 +23,19 @@ uint64_t now() {
 }
 
 DataFlashFileReader::DataFlashFileReader() :
+    mapped(MAP_FAILED),
+    mapped_size(0),
+    log_data(nullptr),
+    log_size(0),
+    log_offset(0),
+    compressed(false),
+    block_raw_len(0),
+    block_raw_ofs(0),
+    index(nullptr),
+    index_count(0),
+    index_pos(0),
+    range_start_us(0),
+    range_end_us(UINT64_MAX),
     start_micros(now())
 {}
 
@@ -29,6 +45,14 @@ DataFlashFileReader::~DataFlashFileReader()
     const uint64_t delta = micros - start_micros;
     ::printf("Replay counts: %" PRIu64 " bytes  %u entries\n", bytes_read, message_count);
     ::printf("Replay rates: %" PRIu64 " bytes/second  %" PRIu64 " messages/second\n", bytes_read*1000000/delta, message_count*1000000/delta);
+
+    free(index);
+    if (mapped != MAP_FAILED) {
+        munmap(mapped, mapped_size);
+    }
+    if (fd != -1) {
+        close(fd);
+    }
 }
 
 bool DataFlashFileReader::open_log(const char *logfile)
@@ -37,14 +61,215 @@ bool DataFlashFileReader::open_log(const char *logfile)
     if (fd == -1) {
         return false;
     }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::printf("%s is empty\n", logfile);
+        return false;
+    }
+
+    // compressed logs start with a block header rather than a message
+    uint8_t magic[2];
+    compressed = (::read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+                  magic[0] == DF_COMPRESS_MAGIC1 &&
+                  magic[1] == DF_COMPRESS_MAGIC2);
+    ::lseek(fd, 0, SEEK_SET);
+    if (compressed) {
+        ::printf("Reading compressed log\n");
+        return true;
+    }
+
+    mapped_size = st.st_size;
+    mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, mapped_size, MADV_SEQUENTIAL);
+
+    log_data = (const uint8_t *)mapped;
+    log_size = mapped_size;
+    return true;
+}
+
+/*
+  read and decode the next block of a compressed log
+ */
+bool DataFlashFileReader::read_block()
+{
+    DataFlash_Compress_Header hdr;
+    if (::read(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return false;
+    }
+    if (!DataFlash_Compress::header_valid(hdr)) {
+        ::printf("bad compressed block header\n");
+        return false;
+    }
+    if (::read(fd, block_data, hdr.data_len) != hdr.data_len) {
+        return false;
+    }
+    const int32_t len = DataFlash_Compress::decode_block(hdr, block_data, block_raw, sizeof(block_raw));
+    if (len < 0) {
+        ::printf("corrupt compressed block at offset %u\n", (unsigned)hdr.raw_offset);
+        return false;
+    }
+    block_raw_len = len;
+    block_raw_ofs = 0;
     return true;
 }
 
 ssize_t DataFlashFileReader::read_input(void *buffer, const size_t count)
 {
-    uint64_t ret = ::read(fd, buffer, count);
-    bytes_read += ret;
-    return ret;
+    if (compressed) {
+        uint8_t *dest = (uint8_t *)buffer;
+        size_t done = 0;
+        while (done < count) {
+            if (block_raw_ofs >= block_raw_len && !read_block()) {
+                break;
+            }
+            const uint32_t n = MIN((uint32_t)(count - done), block_raw_len - block_raw_ofs);
+            memcpy(&dest[done], &block_raw[block_raw_ofs], n);
+            block_raw_ofs += n;
+            done += n;
+        }
+        bytes_read += done;
+        return done;
+    }
+
+    size_t n = count;
+    if (log_offset + n > log_size) {
+        n = log_size - log_offset;
+    }
+    memcpy(buffer, &log_data[log_offset], n);
+    log_offset += n;
+    bytes_read += n;
+    return n;
+}
+
+/*
+  timestamp of a message in microseconds, or zero if it has none
+ */
+uint64_t DataFlashFileReader::message_time_us(const struct log_Format &f, const uint8_t *msg, uint8_t length)
+{
+    uint64_t time_us = 0;
+    if (f.format[0] == 'Q' && strncmp(f.labels, "TimeUS", 6) == 0 && length >= 11) {
+        memcpy(&time_us, &msg[3], sizeof(uint64_t));
+    } else if (f.format[0] == 'I' && strncmp(f.labels, "TimeMS", 6) == 0 && length >= 7) {
+        uint32_t time_ms;
+        memcpy(&time_ms, &msg[3], sizeof(time_ms));
+        time_us = time_ms * 1000ULL;
+    }
+    return time_us;
+}
+
+/*
+  true for messages which set up the log, which are delivered whatever
+  the time range
+ */
+bool DataFlashFileReader::message_is_setup(const struct log_Format &f, uint64_t time_us)
+{
+    return (time_us == 0 ||
+            strncmp(f.name, "FMT", 4) == 0 ||
+            strncmp(f.name, "PARM", 4) == 0 ||
+            strncmp(f.name, "MSG", 4) == 0);
+}
+
+/*
+  build an index of every message in the log with its type, offset and
+  timestamp. This only looks at message headers and timestamp fields
+ */
+bool DataFlashFileReader::build_index()
+{
+    if (index != nullptr) {
+        return true;
+    }
+    if (compressed) {
+        // not mapped, the time range is applied as messages are read
+        return true;
+    }
+    struct log_Format *fmts = (struct log_Format *)calloc(LOGREADER_MAX_FORMATS, sizeof(struct log_Format));
+    if (fmts == nullptr) {
+        return false;
+    }
+    uint32_t alloced = 0;
+    size_t ofs = 0;
+    const char *stop_reason = nullptr;
+    while (ofs + 3 <= log_size) {
+        const uint8_t *msg = &log_data[ofs];
+        if (msg[0] != HEAD_BYTE1 || msg[1] != HEAD_BYTE2) {
+            stop_reason = "bad message header";
+            break;
+        }
+        uint8_t length;
+        if (msg[2] == LOG_FORMAT_MSG) {
+            if (ofs + sizeof(struct log_Format) > log_size) {
+                stop_reason = "truncated format message";
+                break;
+            }
+            struct log_Format f;
+            memcpy(&f, msg, sizeof(f));
+            memcpy(&fmts[f.type], &f, sizeof(f));
+            length = sizeof(f);
+        } else {
+            length = fmts[msg[2]].length;
+        }
+        if (length < 3) {
+            stop_reason = "message with no format";
+            break;
+        }
+        if (ofs + length > log_size) {
+            stop_reason = "truncated message";
+            break;
+        }
+
+        if (index_count == alloced) {
+            if (alloced >= UINT32_MAX / 2) {
+                stop_reason = "too many messages";
+                break;
+            }
+            const uint32_t new_alloced = alloced ? alloced * 2 : 65536;
+            struct index_entry *new_index = (struct index_entry *)realloc(index, new_alloced * sizeof(index[0]));
+            if (new_index == nullptr) {
+                stop_reason = "out of memory";
+                break;
+            }
+            index = new_index;
+            alloced = new_alloced;
+        }
+
+        struct index_entry &e = index[index_count++];
+        e.offset = ofs;
+        e.type = msg[2];
+        const struct log_Format &f = fmts[msg[2]];
+        e.time_us = (msg[2] == LOG_FORMAT_MSG) ? 0 : message_time_us(f, msg, length);
+        e.setup = message_is_setup(f, e.time_us);
+
+        ofs += length;
+    }
+    free(fmts);
+    ::printf("Indexed %u messages\n", (unsigned)index_count);
+    if (stop_reason != nullptr) {
+        ::printf("Index stopped at offset %" PRIu64 " of %" PRIu64 " (%s), later messages will not be replayed\n",
+                 (uint64_t)ofs, (uint64_t)log_size, stop_reason);
+    }
+    return index != nullptr;
+}
+
+bool DataFlashFileReader::set_time_range(uint64_t start_us, uint64_t end_us)
+{
+    if (!build_index()) {
+        return false;
+    }
+    range_start_us = start_us;
+    range_end_us = end_us;
+
+    // continue from the message we would have read next
+    index_pos = 0;
+    while (index_pos < index_count && index[index_pos].offset < log_offset) {
+        index_pos++;
+    }
+    return true;
 }
 
 void DataFlashFileReader::format_type(uint16_t type, char dest[5])
@@ -63,49 +288,85 @@ void DataFlashFileReader::get_packet_counts(uint64_t dest[])
 
 bool DataFlashFileReader::update(char type[5])
 {
-    uint8_t hdr[3];
-    if (read_input(hdr, 3) != 3) {
-        return false;
-    }
-    if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
-        printf("bad log header\n");
-        return false;
-    }
-
-    packet_counts[hdr[2]]++;
+    while (true) {
+        if (index != nullptr) {
+            // skip timestamped messages outside the requested time range
+            while (true) {
+                if (index_pos >= index_count) {
+                    return false;
+                }
+                const struct index_entry &e = index[index_pos++];
+                if (e.setup) {
+                    log_offset = e.offset;
+                    break;
+                }
+                if (e.time_us > range_end_us) {
+                    return false;
+                }
+                if (e.time_us >= range_start_us) {
+                    log_offset = e.offset;
+                    break;
+                }
+            }
+        }
 
-    if (hdr[2] == LOG_FORMAT_MSG) {
-        struct log_Format f;
-        memcpy(&f, hdr, 3);
-        if (read_input(&f.type, sizeof(f)-3) != sizeof(f)-3) {
+        uint8_t hdr[3];
+        if (read_input(hdr, 3) != 3) {
+            return false;
+        }
+        if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
+            printf("bad log header\n");
             return false;
         }
-        memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
-        strncpy(type, "FMT", 3);
-        type[3] = 0;
 
-        message_count++;
-        return handle_log_format_msg(f);
-    }
+        packet_counts[hdr[2]]++;
 
-    const struct log_Format &f = formats[hdr[2]];
-    if (f.length == 0) {
-        // can't just throw these away as the format specifies the
-        // number of bytes in the message
-        ::printf("No format defined for type (%d)\n", hdr[2]);
-        exit(1);
-    }
+        if (hdr[2] == LOG_FORMAT_MSG) {
+            struct log_Format f;
+            memcpy(&f, hdr, 3);
+            if (read_input(&f.type, sizeof(f)-3) != sizeof(f)-3) {
+                return false;
+            }
+            memcpy(&formats[f.type], &f, sizeof(formats[f.type]));
+            strncpy(type, "FMT", 3);
+            type[3] = 0;
 
-    uint8_t msg[f.length];
+            message_count++;
+            return handle_log_format_msg(f);
+        }
 
-    memcpy(msg, hdr, 3);
-    if (read_input(&msg[3], f.length-3) != f.length-3) {
-        return false;
-    }
+        const struct log_Format &f = formats[hdr[2]];
+        if (f.length == 0) {
+            // can't just throw these away as the format specifies the
+            // number of bytes in the message
+            ::printf("No format defined for type (%d)\n", hdr[2]);
+            exit(1);
+        }
+
+        uint8_t msg[f.length];
+
+        memcpy(msg, hdr, 3);
+        if (read_input(&msg[3], f.length-3) != f.length-3) {
+            return false;
+        }
+
+        if (index == nullptr) {
+            // logs without an index have the time range applied here
+            const uint64_t time_us = message_time_us(f, msg, f.length);
+            if (!message_is_setup(f, time_us)) {
+                if (time_us > range_end_us) {
+                    return false;
+                }
+                if (time_us < range_start_us) {
+                    continue;
+                }
+            }
+        }
 
-    strncpy(type, f.name, 4);
-    type[4] = 0;
+        strncpy(type, f.name, 4);
+        type[4] = 0;
 
-    message_count++;
-    return handle_msg(f,msg);
+        message_count++;
+        return handle_msg(f,msg);
+    }
 }
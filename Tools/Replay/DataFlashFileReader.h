@@ -1,6 +1,7 @@
 #pragma once
 
 #include <DataFlash/DataFlash.h>
+#include <DataFlash/DataFlash_Compress.h>
 
 #define LOGREADER_MAX_FORMATS 255 // must be >= highest MESSAGE
 
@@ -14,6 +15,13 @@ public:
     bool open_log(const char *logfile);
     bool update(char type[5]);
 
+    /*
+      only deliver timestamped messages between start_us and end_us
+      (inclusive). Messages which set up the log, such as formats and
+      parameters, are always delivered. This builds the message index
+     */
+    bool set_time_range(uint64_t start_us, uint64_t end_us);
+
     virtual bool handle_log_format_msg(const struct log_Format &f) = 0;
     virtual bool handle_msg(const struct log_Format &f, uint8_t *msg) = 0;
 
@@ -21,13 +29,47 @@ public:
     void get_packet_counts(uint64_t dest[]);
 
 protected:
-    int fd = -1;
-
     struct log_Format formats[LOGREADER_MAX_FORMATS] {};
 
 private:
     ssize_t read_input(void *buf, size_t count);
 
+    // uncompressed logs are mapped into memory
+    int fd = -1;
+    void *mapped;
+    size_t mapped_size;
+    const uint8_t *log_data;
+    size_t log_size;
+    size_t log_offset;
+
+    // compressed logs are read and decoded a block at a time
+    bool compressed;
+    bool read_block();
+    uint8_t block_data[DF_COMPRESS_BOUND(DF_COMPRESS_BLOCK_MAX)];
+    uint8_t block_raw[DF_COMPRESS_BLOCK_MAX];
+    uint32_t block_raw_len;
+    uint32_t block_raw_ofs;
+
+    /*
+      one entry per message, built in a single pass over a mapped
+      log. Compressed logs are not indexed, the time range is applied
+      to them as they are read
+     */
+    struct index_entry {
+        uint64_t time_us;   // zero for messages without a timestamp
+        uint64_t offset;
+        uint8_t type;
+        bool setup;         // always delivered, whatever the time range
+    };
+    static uint64_t message_time_us(const struct log_Format &f, const uint8_t *msg, uint8_t length);
+    static bool message_is_setup(const struct log_Format &f, uint64_t time_us);
+    struct index_entry *index;
+    uint32_t index_count;
+    uint32_t index_pos;
+    uint64_t range_start_us;
+    uint64_t range_end_us;
+    bool build_index();
+
     uint64_t bytes_read = 0;
     uint32_t message_count = 0;
     uint64_t start_micros;
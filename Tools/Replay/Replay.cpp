@@ -153,6 +153,8 @@ void Replay::usage(void)
     ::printf("\t--no-params        don't use parameters from the log\n");
     ::printf("\t--no-fpe           do not generate floating point exceptions\n");
     ::printf("\t--packet-counts    print packet counts at end of processing\n");
+    ::printf("\t--start SECONDS    skip sensor data logged before this time since boot\n");
+    ::printf("\t--end SECONDS      stop at this time since boot\n");
 }
 
 
@@ -169,6 +171,8 @@ enum {
     OPT_PARAM_FILE,
     OPT_NO_FPE,
     OPT_PACKET_COUNTS,
+    OPT_START,
+    OPT_END,
 };
 
 void Replay::flush_dataflash(void) {
@@ -226,6 +230,8 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
         {"no-params",       false,  0, OPT_NOPARAMS},
         {"no-fpe",          false,  0, OPT_NO_FPE},
         {"packet-counts",   false,  0, OPT_PACKET_COUNTS},
+        {"start",           true,   0, OPT_START},
+        {"end",             true,   0, OPT_END},
         {0, false, 0, 0}
     };
 
@@ -313,6 +319,14 @@ void Replay::_parse_command_line(uint8_t argc, char * const argv[])
             packet_counts = true;
             break;
 
+        case OPT_START:
+            start_time_us = atof(gopt.optarg) * 1.0e6;
+            break;
+
+        case OPT_END:
+            end_time_us = atof(gopt.optarg) * 1.0e6;
+            break;
+
         case 'h':
         default:
             usage();
@@ -532,6 +546,13 @@ void Replay::setup()
         exit(1);
     }
 
+    if (start_time_us != 0 || end_time_us != UINT64_MAX) {
+        if (!logreader.set_time_range(start_time_us, end_time_us)) {
+            ::printf("Failed to index log\n");
+            exit(1);
+        }
+    }
+
     _vehicle.setup();
 
     inhibit_gyro_cal();
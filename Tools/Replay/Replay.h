@@ -150,6 +150,8 @@ private:
     uint32_t output_counter = 0;
     uint64_t last_timestamp = 0;
     bool packet_counts = false;
+    uint64_t start_time_us = 0;
+    uint64_t end_time_us = UINT64_MAX;
 
     struct {
         float max_roll_error;
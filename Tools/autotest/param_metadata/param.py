@@ -92,6 +92,7 @@ known_units = {
              'dB'      : 'decibel'               ,
 # compound
 
+             'B'       : 'bytes'                    ,
              'kB'      : 'kilobytes'                ,
              'm.m/s/s' : 'square meter per square second',
              'deg/m/s' : 'degrees per meter per second'  ,
@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+'''
+expand a DataFlash log written with LOG_FILE_COMPRESS into a normal
+log which any log analysis tool can read. Logs which are not
+compressed are copied unchanged.
+
+The block format is described in libraries/DataFlash/DataFlash_Compress.h
+'''
+
+import struct
+import sys
+import zlib
+import optparse
+
+MAGIC = b'DZ'
+HEADER = struct.Struct('<2sBBHHII')
+FLAG_COMPRESSED = 1
+MIN_MATCH = 4
+
+
+def get_length(src, ip, length):
+    '''read a length extension'''
+    while True:
+        b = ord(src[ip:ip+1])
+        ip += 1
+        length += b
+        if b != 255:
+            return ip, length
+
+
+def decompress(src):
+    '''decode the payload of a compressed block'''
+    dst = bytearray()
+    ip = 0
+    while ip < len(src):
+        token = ord(src[ip:ip+1])
+        ip += 1
+        lit_len = token >> 4
+        if lit_len == 15:
+            ip, lit_len = get_length(src, ip, lit_len)
+        dst += src[ip:ip+lit_len]
+        ip += lit_len
+        if ip >= len(src):
+            break
+        offset = ord(src[ip:ip+1]) | (ord(src[ip+1:ip+2]) << 8)
+        ip += 2
+        if offset == 0 or offset > len(dst):
+            raise ValueError("bad match offset")
+        match_len = token & 0x0F
+        if match_len == 15:
+            ip, match_len = get_length(src, ip, match_len)
+        match_len += MIN_MATCH
+        # byte at a time as the match may overlap the output
+        start = len(dst) - offset
+        for i in range(match_len):
+            dst.append(dst[start+i])
+    return dst
+
+
+def crc32(data):
+    '''crc_crc32() from AP_Math, which has no initial or final inversion'''
+    return (zlib.crc32(bytes(data), 0xFFFFFFFF) ^ 0xFFFFFFFF) & 0xFFFFFFFF
+
+
+def expand(infile, outfile):
+    data = infile.read()
+    if data[:2] != MAGIC:
+        outfile.write(data)
+        return None
+    ofs = 0
+    nblocks = 0
+    while ofs + HEADER.size <= len(data):
+        (magic, flags, reserved, raw_len, data_len,
+         raw_offset, crc) = HEADER.unpack_from(data, ofs)
+        if magic != MAGIC:
+            print("bad block header at %u" % ofs)
+            break
+        ofs += HEADER.size
+        payload = data[ofs:ofs+data_len]
+        ofs += data_len
+        if len(payload) != data_len:
+            print("truncated block at raw offset %u" % raw_offset)
+            break
+        if crc32(payload) != crc:
+            print("corrupt block at raw offset %u" % raw_offset)
+            break
+        if flags & FLAG_COMPRESSED:
+            raw = decompress(payload)
+        else:
+            raw = payload
+        if len(raw) != raw_len:
+            print("bad block length at raw offset %u" % raw_offset)
+            break
+        outfile.write(raw)
+        nblocks += 1
+    return nblocks
+
+
+parser = optparse.OptionParser("dataflash_decompress.py [options] INFILE OUTFILE")
+opts, args = parser.parse_args()
+
+if len(args) != 2:
+    parser.print_help()
+    sys.exit(1)
+
+with open(args[0], 'rb') as infile:
+    with open(args[1], 'wb') as outfile:
+        nblocks = expand(infile, outfile)
+if nblocks is None:
+    print("Log is not compressed, copied it unchanged")
+else:
+    print("Expanded %u blocks" % nblocks)
@@ -344,9 +344,12 @@ void AC_Avoid::adjust_velocity_polygon_fence(float kP, float accel_cmss, Vector2
     // Note: first point in list is the return-point (which copter does not use)
     uint16_t num_points;
     const Vector2f* boundary = _fence.get_polygon_points(num_points);
+    if (boundary == nullptr || num_points < 2) {
+        return;
+    }
 
-    // adjust velocity using polygon
-    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, boundary, num_points, true, _fence.get_margin(), dt);
+    // adjust velocity using polygon, skipping the return point
+    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, &boundary[1], num_points-1, _fence.get_polygon_index(), true, _fence.get_margin(), dt);
 }
 
 /*
@@ -372,7 +375,7 @@ void AC_Avoid::adjust_velocity_beacon_fence(float kP, float accel_cmss, Vector2f
     }
 
     // adjust velocity using beacon
-    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, boundary, num_points, true, _fence.get_margin(), dt);
+    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, boundary, num_points, nullptr, true, _fence.get_margin(), dt);
 }
 
 /*
@@ -393,13 +396,13 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector2f &d
     // get boundary from proximity sensor
     uint16_t num_points;
     const Vector2f *boundary = _proximity.get_boundary_points(num_points);
-    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, boundary, num_points, false, _margin, dt);
+    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, boundary, num_points, nullptr, false, _margin, dt);
 }
 
 /*
  * Adjusts the desired velocity for the polygon fence.
  */
-void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, const Vector2f* boundary, uint16_t num_points, bool earth_frame, float margin, float dt)
+void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, const Vector2f* boundary, uint16_t num_points, const PolygonIndex *index, bool earth_frame, float margin, float dt)
 {
     // exit if there are no points
     if (boundary == nullptr || num_points == 0) {
@@ -417,7 +420,11 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
         position_xy = position_xy * 100.0f;  // m to cm
     }
 
-    if (_fence.boundary_breached(position_xy, num_points, boundary)) {
+    if (index != nullptr) {
+        if (index->outside(position_xy)) {
+            return;
+        }
+    } else if (Polygon_outside(position_xy, boundary, num_points)) {
         return;
     }
 
@@ -439,47 +446,36 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
     const float speed = safe_vel.length();
     const Vector2f stopping_point_plus_margin = position_xy + safe_vel*((2.0f + margin_cm + get_stopping_distance(kP, accel_cmss, speed))/speed);
 
-    uint16_t i, j;
-    for (i = 0, j = num_points-1; i < num_points; j = i++) {
-        // end points of current edge
-        Vector2f start = boundary[j];
-        Vector2f end = boundary[i];
+    if (index != nullptr && accel_cmss > 0.0f) {
+        // only edges which could limit the velocity need checking:
+        // those we could reach before stopping when sliding, or those
+        // crossing the path to the stopping point otherwise. A little
+        // extra is allowed for rounding
+        Vector2f min, max;
         if ((AC_Avoid::BehaviourType)_behavior.get() == BEHAVIOR_SLIDE) {
-            // vector from current position to closest point on current edge
-            Vector2f limit_direction = Vector2f::closest_point(position_xy, start, end) - position_xy;
-            // distance to closest point
-            const float limit_distance_cm = limit_direction.length();
-            if (!is_zero(limit_distance_cm)) {
-                // We are strictly inside the given edge.
-                // Adjust velocity to not violate this edge.
-                limit_direction /= limit_distance_cm;
-                limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
-            } else {
-                // We are exactly on the edge - treat this as a fence breach.
-                // i.e. do not adjust velocity.
+            const float radius_cm = margin_cm + MAX(get_stopping_distance(kP, accel_cmss, speed), speed * dt) + 1.0f;
+            min = position_xy - Vector2f(radius_cm, radius_cm);
+            max = position_xy + Vector2f(radius_cm, radius_cm);
+        } else {
+            min = Vector2f(MIN(position_xy.x, stopping_point_plus_margin.x) - 1.0f,
+                           MIN(position_xy.y, stopping_point_plus_margin.y) - 1.0f);
+            max = Vector2f(MAX(position_xy.x, stopping_point_plus_margin.x) + 1.0f,
+                           MAX(position_xy.y, stopping_point_plus_margin.y) + 1.0f);
+        }
+        PolygonIndex::BoxQuery query(*index, min, max);
+        uint16_t edge;
+        while (query.next(edge)) {
+            if (!limit_velocity_edge(kP, accel_cmss, safe_vel, position_xy, stopping_point_plus_margin,
+                                     index->edge_start(edge), index->edge_end(edge), margin_cm, dt)) {
                 return;
             }
-        } else {
-            // find intersection with line segment
-            Vector2f intersection;
-            if (Vector2f::segment_intersection(position_xy, stopping_point_plus_margin, start, end, intersection)) {
-                // vector from current position to point on current edge
-                Vector2f limit_direction = intersection - position_xy;
-                const float limit_distance_cm = limit_direction.length();
-                if (!is_zero(limit_distance_cm)) {
-                    if (limit_distance_cm <= margin_cm) {
-                        // we are within the margin so stop vehicle
-                        safe_vel.zero();
-                    } else {
-                        // vehicle inside the given edge, adjust velocity to not violate this edge
-                        limit_direction /= limit_distance_cm;
-                        limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
-                    }
-                } else {
-                    // We are exactly on the edge - treat this as a fence breach.
-                    // i.e. do not adjust velocity.
-                    return;
-                }
+        }
+    } else {
+        uint16_t i, j;
+        for (i = 0, j = num_points-1; i < num_points; j = i++) {
+            if (!limit_velocity_edge(kP, accel_cmss, safe_vel, position_xy, stopping_point_plus_margin,
+                                     boundary[j], boundary[i], margin_cm, dt)) {
+                return;
             }
         }
     }
@@ -494,6 +490,53 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
     }
 }
 
+/*
+ * Limits the velocity to stay inside the edge from start to end.
+ * Returns false if the vehicle is exactly on the edge, which is treated
+ * as a fence breach so the velocity should not be adjusted.
+ */
+bool AC_Avoid::limit_velocity_edge(float kP, float accel_cmss, Vector2f &safe_vel, const Vector2f &position_xy,
+                                   const Vector2f &stopping_point_plus_margin, const Vector2f &start, const Vector2f &end,
+                                   float margin_cm, float dt) const
+{
+    if ((AC_Avoid::BehaviourType)_behavior.get() == BEHAVIOR_SLIDE) {
+        // vector from current position to closest point on current edge
+        Vector2f limit_direction = Vector2f::closest_point(position_xy, start, end) - position_xy;
+        // distance to closest point
+        const float limit_distance_cm = limit_direction.length();
+        if (is_zero(limit_distance_cm)) {
+            // We are exactly on the edge
+            return false;
+        }
+        // We are strictly inside the given edge.
+        // Adjust velocity to not violate this edge.
+        limit_direction /= limit_distance_cm;
+        limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
+        return true;
+    }
+
+    // find intersection with line segment
+    Vector2f intersection;
+    if (Vector2f::segment_intersection(position_xy, stopping_point_plus_margin, start, end, intersection)) {
+        // vector from current position to point on current edge
+        Vector2f limit_direction = intersection - position_xy;
+        const float limit_distance_cm = limit_direction.length();
+        if (is_zero(limit_distance_cm)) {
+            // We are exactly on the edge
+            return false;
+        }
+        if (limit_distance_cm <= margin_cm) {
+            // we are within the margin so stop vehicle
+            safe_vel.zero();
+        } else {
+            // vehicle inside the given edge, adjust velocity to not violate this edge
+            limit_direction /= limit_distance_cm;
+            limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
+        }
+    }
+    return true;
+}
+
 /*
  * Computes distance required to stop, given current speed.
  *
@@ -111,10 +111,18 @@ private:
 
     /*
      * Adjusts the desired velocity given an array of boundary points
+     *   index is an optional PolygonIndex of the boundary, used to skip edges too far away to matter
      *   earth_frame should be true if boundary is in earth-frame, false for body-frame
      *   margin is the distance (in meters) that the vehicle should stop short of the polygon
      */
-    void adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, const Vector2f* boundary, uint16_t num_points, bool earth_frame, float margin, float dt);
+    void adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, const Vector2f* boundary, uint16_t num_points, const PolygonIndex *index, bool earth_frame, float margin, float dt);
+
+    /*
+     * Limits safe_vel to stay inside the polygon edge from start to end, returning false if on the edge
+     */
+    bool limit_velocity_edge(float kP, float accel_cmss, Vector2f &safe_vel, const Vector2f &position_xy,
+                             const Vector2f &stopping_point_plus_margin, const Vector2f &start, const Vector2f &end,
+                             float margin_cm, float dt) const;
 
     /*
      * Computes distance required to stop, given current speed.
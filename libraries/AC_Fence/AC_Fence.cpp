@@ -255,7 +255,7 @@ bool AC_Fence::check_fence_polygon()
     }
 
     position = position * 100.0f;  // m to cm
-    if (_poly_loader.boundary_breached(position, _boundary_num_points, _boundary, true)) {
+    if (polygon_breached(position)) {
         // check if this is a new breach
         if (_breached_fences & AC_FENCE_TYPE_POLYGON) {
             // not a new breach
@@ -383,7 +383,7 @@ bool AC_Fence::check_destination_within_fence(const Location_Class& loc)
         // check ekf has a good location
         Vector2f posNE;
         if (loc.get_vector_xy_from_origin_NE(posNE)) {
-            if (_poly_loader.boundary_breached(posNE, _boundary_num_points, _boundary, true)) {
+            if (polygon_breached(posNE)) {
                 return false;
             }
         }
@@ -469,6 +469,15 @@ bool AC_Fence::boundary_breached(const Vector2f& location, uint16_t num_points,
     return _poly_loader.boundary_breached(location, num_points, points, true);
 }
 
+/// returns true if location is outside the loaded polygon
+bool AC_Fence::polygon_breached(const Vector2f& location) const
+{
+    if (_boundary_index.valid()) {
+        return _boundary_index.outside(location);
+    }
+    return _poly_loader.boundary_breached(location, _boundary_num_points, _boundary, true);
+}
+
 /// handler for polygon fence messages with GCS
 void AC_Fence::handle_msg(GCS_MAVLINK &link, mavlink_message_t* msg)
 {
@@ -548,15 +557,17 @@ bool AC_Fence::load_polygon_from_eeprom(bool force_reload)
     // sanity check total
     _total = constrain_int16(_total, 0, _poly_loader.max_points());
 
+    // the index refers to the points about to be overwritten
+    _boundary_index.clear();
+
     // load each point from eeprom
     Vector2l temp_latlon;
+    const LocationOrigin origin(ekf_origin);
     for (uint16_t index=0; index<_total; index++) {
         // load boundary point as lat/lon point
         _poly_loader.load_point_from_eeprom(index, temp_latlon);
-        // move into location structure and convert to offset from ekf origin
-        temp_loc.lat = temp_latlon.x;
-        temp_loc.lng = temp_latlon.y;
-        _boundary[index] = location_diff(ekf_origin, temp_loc) * 100.0f;
+        // convert to offset from ekf origin
+        _boundary[index] = origin.diff_ne(temp_latlon.x, temp_latlon.y) * 100.0f;
     }
     _boundary_num_points = _total;
     _boundary_loaded = true;
@@ -564,6 +575,12 @@ bool AC_Fence::load_polygon_from_eeprom(bool force_reload)
     // update validity of polygon
     _boundary_valid = _poly_loader.boundary_valid(_boundary_num_points, _boundary, true);
 
+    // index the boundary for breach checks and avoidance, skipping the
+    // return point. Without the index we fall back to checking every edge
+    if (_boundary_valid) {
+        _boundary_index.build(&_boundary[1], _boundary_num_points - 1);
+    }
+
     return true;
 }
 
@@ -30,7 +30,12 @@
 
 #define VEHICLE_TIMEOUT_MS              5000   // if no updates in this time, drop it from the list
 #define ADSB_VEHICLE_LIST_SIZE_DEFAULT  25
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+// about 60kB at the maximum, for ground receivers near busy airports
+#define ADSB_VEHICLE_LIST_SIZE_MAX      1000
+#else
 #define ADSB_VEHICLE_LIST_SIZE_MAX      100
+#endif
 #define ADSB_CHAN_TIMEOUT_MS            15000
 #define ADSB_SQUAWK_OCTAL_DEFAULT       1200
 
@@ -58,7 +63,7 @@ const AP_Param::GroupInfo AP_ADSB::var_info[] = {
 
     // @Param: LIST_MAX
     // @DisplayName: ADSB vehicle list size
-    // @Description: ADSB list size of nearest vehicles. Longer lists take longer to refresh with lower SRx_ADSB values.
+    // @Description: ADSB list size of nearest vehicles. Longer lists take longer to refresh with lower SRx_ADSB values. Each vehicle takes about 60 bytes of RAM. SITL and Linux boards allow up to 1000 vehicles.
     // @Range: 1 100
     // @User: Advanced
     AP_GROUPINFO("LIST_MAX",   2, AP_ADSB, in_state.list_size_param, ADSB_VEHICLE_LIST_SIZE_DEFAULT),
@@ -148,12 +153,19 @@ void AP_ADSB::init(void)
         in_state.list_size = in_state.list_size_param;
         in_state.vehicle_list = new adsb_vehicle_t[in_state.list_size];
 
+        if (in_state.vehicle_list != nullptr &&
+            !in_state.icao_index.init(in_state.list_size)) {
+            delete [] in_state.vehicle_list;
+            in_state.vehicle_list = nullptr;
+        }
+
         if (in_state.vehicle_list == nullptr) {
             // dynamic RAM allocation of _vehicle_list[] failed, disable gracefully
             hal.console->printf("Unable to initialize ADS-B vehicle list\n");
             _enabled.set_and_notify(0);
         }
     }
+    in_state.icao_index.clear();
 
     furthest_vehicle_distance = 0;
     furthest_vehicle_index = 0;
@@ -172,6 +184,7 @@ void AP_ADSB::deinit(void)
         delete [] in_state.vehicle_list;
         in_state.vehicle_list = nullptr;
     }
+    in_state.icao_index.deinit();
 }
 
 /*
@@ -282,19 +295,21 @@ void AP_ADSB::update(void)
  */
 void AP_ADSB::determine_furthest_aircraft(void)
 {
-    float max_distance = 0;
+    float max_distance_sq = 0;
     uint16_t max_distance_index = 0;
+    const LocationOrigin my_origin(_my_loc);
 
     for (uint16_t index = 0; index < in_state.vehicle_count; index++) {
-        float distance = _my_loc.get_distance(get_location(in_state.vehicle_list[index]));
-        if (max_distance < distance || index == 0) {
-            max_distance = distance;
+        const mavlink_adsb_vehicle_t &info = in_state.vehicle_list[index].info;
+        const float distance_sq = my_origin.diff_ne(info.lat, info.lon).length_squared();
+        if (max_distance_sq < distance_sq || index == 0) {
+            max_distance_sq = distance_sq;
             max_distance_index = index;
         }
     } // for index
 
     furthest_vehicle_index = max_distance_index;
-    furthest_vehicle_distance = max_distance;
+    furthest_vehicle_distance = sqrtf(max_distance_sq);
 }
 
 /*
@@ -323,8 +338,10 @@ void AP_ADSB::delete_vehicle(const uint16_t index)
             furthest_vehicle_distance = 0;
             furthest_vehicle_index = 0;
         }
+        in_state.icao_index.remove(in_state.vehicle_list[index].info.ICAO_address);
         if (index != (in_state.vehicle_count-1)) {
             in_state.vehicle_list[index] = in_state.vehicle_list[in_state.vehicle_count-1];
+            in_state.icao_index.insert(in_state.vehicle_list[index].info.ICAO_address, index);
         }
         // TODO: is memset needed? When we decrement the index we essentially forget about it
         memset(&in_state.vehicle_list[in_state.vehicle_count-1], 0, sizeof(adsb_vehicle_t));
@@ -339,13 +356,7 @@ void AP_ADSB::delete_vehicle(const uint16_t index)
  */
 bool AP_ADSB::find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const
 {
-    for (uint16_t i = 0; i < in_state.vehicle_count; i++) {
-        if (in_state.vehicle_list[i].info.ICAO_address == vehicle.info.ICAO_address) {
-            *index = i;
-            return true;
-        }
-    }
-    return false;
+    return in_state.icao_index.find(vehicle.info.ICAO_address, *index);
 }
 
 /*
@@ -437,13 +448,22 @@ void AP_ADSB::handle_vehicle(const mavlink_message_t* packet)
 }
 
 /*
- * Copy a vehicle's data into the list
+ * Copy a vehicle's data into the list. index may be vehicle_count to
+ * append, otherwise it replaces the vehicle at that index
  */
 void AP_ADSB::set_vehicle(const uint16_t index, const adsb_vehicle_t &vehicle)
 {
-    if (index < in_state.list_size) {
-        in_state.vehicle_list[index] = vehicle;
+    if (index >= in_state.list_size) {
+        return;
+    }
+    const uint32_t icao = vehicle.info.ICAO_address;
+    if (index >= in_state.vehicle_count) {
+        in_state.icao_index.insert(icao, index);
+    } else if (in_state.vehicle_list[index].info.ICAO_address != icao) {
+        in_state.icao_index.remove(in_state.vehicle_list[index].info.ICAO_address);
+        in_state.icao_index.insert(icao, index);
     }
+    in_state.vehicle_list[index] = vehicle;
 }
 
 void AP_ADSB::send_adsb_vehicle(const mavlink_channel_t chan)
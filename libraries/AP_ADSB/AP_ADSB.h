@@ -29,6 +29,8 @@
 
 #include <AP_Buffer/AP_Buffer.h>
 
+#include "ICAOTable.h"
+
 class AP_ADSB {
 public:
     AP_ADSB()
@@ -90,7 +92,7 @@ private:
     // compares current vector against vehicle_list to detect threats
     void determine_furthest_aircraft(void);
 
-    // return index of given vehicle if ICAO_ADDRESS matches. return -1 if no match
+    // find index of given vehicle if ICAO_ADDRESS matches. return false if no match
     bool find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const;
 
     // remove a vehicle from the list
@@ -132,6 +134,7 @@ private:
         uint16_t    list_size = 1; // start with tiny list, then change to param-defined size. This ensures it doesn't fail on start
         adsb_vehicle_t *vehicle_list = nullptr;
         uint16_t    vehicle_count;
+        ICAOTable   icao_index; // ICAO_address to vehicle_list index
         AP_Int32    list_radius;
 
         // streamrate stuff
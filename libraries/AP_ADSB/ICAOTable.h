@@ -0,0 +1,196 @@
+#pragma once
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#define ICAO_TABLE_MAX_ENTRIES 16384
+
+/*
+  map from ICAO address to an index in a vehicle list, so a packet
+  can find its vehicle without scanning the list.
+
+  Open addressing with linear probing in a power of two table of at
+  least twice the number of entries, so probe runs stay short.
+  Removal shifts the rest of the run back instead of leaving
+  tombstones, so the table never degrades however many vehicles come
+  and go
+ */
+class ICAOTable {
+public:
+    ICAOTable() {}
+    ~ICAOTable() {
+        delete [] _slots;
+    }
+
+    /* Do not allow copies */
+    ICAOTable(const ICAOTable &other) = delete;
+    ICAOTable &operator=(const ICAOTable&) = delete;
+
+    // allocate room for max_entries addresses. Returns false if out of memory
+    bool init(uint16_t max_entries);
+
+    // free the table
+    void deinit();
+
+    // forget all addresses
+    void clear();
+
+    uint16_t count() const { return _count; }
+
+    // find the index of an address. Returns false if it is not in the table
+    bool find(uint32_t icao, uint16_t &index) const;
+
+    // add an address or change the index of one already in the
+    // table. Returns false if the table is full or not allocated
+    bool insert(uint32_t icao, uint16_t index);
+
+    // remove an address. Returns false if it was not in the table
+    bool remove(uint32_t icao);
+
+private:
+    // ICAO addresses are 24 bits, so this can't be a real one
+    static const uint32_t empty_slot = 0xFFFFFFFF;
+
+    struct slot_t {
+        uint32_t icao;
+        uint16_t index;
+    };
+
+    // first slot to probe for an address. Addresses are allocated in
+    // blocks by country so the low bits alone cluster badly;
+    // Fibonacci hashing spreads them over the table
+    uint16_t home_slot(uint32_t icao) const {
+        return (uint32_t)(icao * 2654435769U) >> _shift;
+    }
+
+    // slot holding an address, or the empty slot ending its probe run
+    uint16_t probe(uint32_t icao) const;
+
+    slot_t *_slots = nullptr;
+    uint16_t _mask = 0;
+    uint8_t _shift;
+    uint16_t _count = 0;
+};
+
+inline bool ICAOTable::init(uint16_t max_entries)
+{
+    if (max_entries == 0 || max_entries > ICAO_TABLE_MAX_ENTRIES) {
+        return false;
+    }
+    deinit();
+
+    uint8_t bits = 2;
+    while ((1U << bits) < 2U * max_entries) {
+        bits++;
+    }
+    _slots = new slot_t[1U << bits];
+    if (_slots == nullptr) {
+        return false;
+    }
+    _mask = (1U << bits) - 1;
+    _shift = 32 - bits;
+    clear();
+    return true;
+}
+
+inline void ICAOTable::deinit()
+{
+    delete [] _slots;
+    _slots = nullptr;
+    _mask = 0;
+    _count = 0;
+}
+
+inline void ICAOTable::clear()
+{
+    if (_slots == nullptr) {
+        return;
+    }
+    for (uint32_t i=0; i<=_mask; i++) {
+        _slots[i].icao = empty_slot;
+    }
+    _count = 0;
+}
+
+inline uint16_t ICAOTable::probe(uint32_t icao) const
+{
+    uint16_t i = home_slot(icao);
+    while (_slots[i].icao != icao && _slots[i].icao != empty_slot) {
+        i = (i + 1) & _mask;
+    }
+    return i;
+}
+
+inline bool ICAOTable::find(uint32_t icao, uint16_t &index) const
+{
+    if (_slots == nullptr || icao == empty_slot) {
+        return false;
+    }
+    const slot_t &s = _slots[probe(icao)];
+    if (s.icao != icao) {
+        return false;
+    }
+    index = s.index;
+    return true;
+}
+
+inline bool ICAOTable::insert(uint32_t icao, uint16_t index)
+{
+    if (_slots == nullptr || icao == empty_slot) {
+        return false;
+    }
+    slot_t &s = _slots[probe(icao)];
+    if (s.icao != icao) {
+        // keep at least one slot empty so every probe run ends
+        if (_count >= _mask) {
+            return false;
+        }
+        s.icao = icao;
+        _count++;
+    }
+    s.index = index;
+    return true;
+}
+
+inline bool ICAOTable::remove(uint32_t icao)
+{
+    if (_slots == nullptr || icao == empty_slot) {
+        return false;
+    }
+    uint16_t hole = probe(icao);
+    if (_slots[hole].icao != icao) {
+        return false;
+    }
+
+    // move back any later entry in the run whose home slot is not
+    // between the hole and where it sits now, so it stays reachable
+    uint16_t i = hole;
+    while (true) {
+        i = (i + 1) & _mask;
+        if (_slots[i].icao == empty_slot) {
+            break;
+        }
+        const uint16_t home = home_slot(_slots[i].icao);
+        if (((i - home) & _mask) >= ((i - hole) & _mask)) {
+            _slots[hole] = _slots[i];
+            hole = i;
+        }
+    }
+    _slots[hole].icao = empty_slot;
+    _count--;
+    return true;
+}
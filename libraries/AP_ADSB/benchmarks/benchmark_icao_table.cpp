@@ -0,0 +1,78 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_ADSB/ICAOTable.h>
+
+#define NUM_VEHICLES 1000
+
+static uint32_t test_icao(uint16_t i)
+{
+    return 0xA00000 + (i % 4) * 0x40000 + i / 4;
+}
+
+// the scan AP_ADSB used to find a vehicle for each packet
+static void BM_ICAOLinearFind(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    static uint32_t list[NUM_VEHICLES];
+    for (uint16_t i=0; i<n; i++) {
+        list[i] = test_icao(i);
+    }
+
+    uint32_t count = 0;
+    while (state.KeepRunning()) {
+        const uint32_t icao = test_icao((count++ * 7919) % n);
+        uint16_t index = 0;
+        for (uint16_t i=0; i<n; i++) {
+            if (list[i] == icao) {
+                index = i;
+                break;
+            }
+        }
+        gbenchmark_escape(&index);
+    }
+}
+
+static void BM_ICAOTableFind(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    ICAOTable table;
+    table.init(n);
+    for (uint16_t i=0; i<n; i++) {
+        table.insert(test_icao(i), i);
+    }
+
+    uint32_t count = 0;
+    while (state.KeepRunning()) {
+        uint16_t index = 0;
+        table.find(test_icao((count++ * 7919) % n), index);
+        gbenchmark_escape(&index);
+    }
+}
+
+// a vehicle timing out and a new one arriving
+static void BM_ICAOTableReplace(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    ICAOTable table;
+    table.init(n);
+    for (uint16_t i=0; i<n; i++) {
+        table.insert(test_icao(i), i);
+    }
+
+    uint32_t count = 0;
+    while (state.KeepRunning()) {
+        // alternate between two sets of addresses
+        const uint16_t i = count % n;
+        const uint16_t old_set = (count / n) & 1;
+        table.remove(test_icao(i + old_set * n));
+        table.insert(test_icao(i + (1 - old_set) * n), i);
+        count++;
+    }
+}
+
+// argument is the number of vehicles tracked
+BENCHMARK(BM_ICAOLinearFind)->Arg(25)->Arg(100)->Arg(1000);
+BENCHMARK(BM_ICAOTableFind)->Arg(25)->Arg(100)->Arg(1000);
+BENCHMARK(BM_ICAOTableReplace)->Arg(25)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,93 @@
+#include <AP_gtest.h>
+
+#include <AP_ADSB/ICAOTable.h>
+
+#define NUM_VEHICLES 1000
+
+// addresses in a few dense country blocks, as real traffic is
+static uint32_t test_icao(uint16_t i)
+{
+    return 0xA00000 + (i % 4) * 0x40000 + i / 4;
+}
+
+TEST(ICAOTable, InsertFind)
+{
+    ICAOTable table;
+    ASSERT_TRUE(table.init(NUM_VEHICLES));
+
+    for (uint16_t i=0; i<NUM_VEHICLES; i++) {
+        EXPECT_TRUE(table.insert(test_icao(i), i));
+    }
+    EXPECT_EQ(NUM_VEHICLES, table.count());
+
+    for (uint16_t i=0; i<NUM_VEHICLES; i++) {
+        uint16_t index = 0xFFFF;
+        EXPECT_TRUE(table.find(test_icao(i), index));
+        EXPECT_EQ(i, index);
+    }
+    uint16_t index;
+    EXPECT_FALSE(table.find(0x123456, index));
+    EXPECT_FALSE(table.find(0xFFFFFFFF, index));
+
+    // changing the index of an address doesn't add another
+    EXPECT_TRUE(table.insert(test_icao(10), 500));
+    EXPECT_TRUE(table.find(test_icao(10), index));
+    EXPECT_EQ(500, index);
+    EXPECT_EQ(NUM_VEHICLES, table.count());
+}
+
+TEST(ICAOTable, RemoveKeepsOthersReachable)
+{
+    ICAOTable table;
+    ASSERT_TRUE(table.init(NUM_VEHICLES));
+    bool present[NUM_VEHICLES] {};
+
+    // churn the table the way traffic comes and goes
+    uint32_t seed = 1;
+    for (uint32_t n=0; n<20000; n++) {
+        seed = seed * 1103515245 + 12345;
+        const uint16_t i = (seed >> 16) % NUM_VEHICLES;
+        if (present[i]) {
+            EXPECT_TRUE(table.remove(test_icao(i)));
+        } else {
+            EXPECT_TRUE(table.insert(test_icao(i), i));
+        }
+        present[i] = !present[i];
+    }
+
+    uint16_t count = 0;
+    for (uint16_t i=0; i<NUM_VEHICLES; i++) {
+        uint16_t index;
+        EXPECT_EQ(present[i], table.find(test_icao(i), index));
+        if (present[i]) {
+            EXPECT_EQ(i, index);
+            count++;
+        }
+    }
+    EXPECT_EQ(count, table.count());
+    EXPECT_FALSE(table.remove(0x123456));
+}
+
+TEST(ICAOTable, Full)
+{
+    ICAOTable table;
+    ASSERT_TRUE(table.init(2));
+    // a table for two vehicles has four slots and keeps one empty
+    EXPECT_TRUE(table.insert(1, 0));
+    EXPECT_TRUE(table.insert(2, 1));
+    EXPECT_TRUE(table.insert(3, 2));
+    EXPECT_FALSE(table.insert(4, 3));
+    EXPECT_TRUE(table.remove(2));
+    EXPECT_TRUE(table.insert(4, 3));
+
+    table.clear();
+    EXPECT_EQ(0, table.count());
+    uint16_t index;
+    EXPECT_FALSE(table.find(1, index));
+
+    table.deinit();
+    EXPECT_FALSE(table.insert(1, 0));
+    EXPECT_FALSE(table.init(0));
+}
+
+AP_GTEST_MAIN()
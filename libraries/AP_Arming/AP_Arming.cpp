@@ -571,7 +571,19 @@ bool AP_Arming::arm_checks(ArmingMethod method)
             return false;
         }
     }
-    
+
+    // wait for any parameter saves to be handed to the storage
+    // driver. The driver may still be writing them out in the
+    // background
+    if ((checks_to_perform & ARMING_CHECK_ALL) ||
+        (checks_to_perform & ARMING_CHECK_SYSTEM)) {
+        AP_Param::flush();
+        if (AP_Param::save_pending()) {
+            check_failed(ARMING_CHECK_SYSTEM, true, "Parameter save pending");
+            return false;
+        }
+    }
+
     // note that this will prepare DataFlash to start logging
     // so should be the last check to be done before arming
     if ((checks_to_perform & ARMING_CHECK_ALL) ||
@@ -274,15 +274,14 @@ void AP_Avoidance::get_adsb_samples()
     }
 }
 
-float closest_approach_xy(const Location &my_loc,
+// delta_pos_ne is our position relative to the obstacle in metres
+float closest_approach_xy(const Vector2f &delta_pos_ne,
                           const Vector3f &my_vel,
-                          const Location &obstacle_loc,
                           const Vector3f &obstacle_vel,
                           const uint8_t time_horizon)
 {
 
     Vector2f delta_vel_ne = Vector2f(obstacle_vel[0] - my_vel[0], obstacle_vel[1] - my_vel[1]);
-    Vector2f delta_pos_ne = location_diff(obstacle_loc, my_loc);
 
     Vector2f line_segment_ne = delta_vel_ne * time_horizon;
 
@@ -328,21 +327,23 @@ float closest_approach_z(const Location &my_loc,
 }
 
 void AP_Avoidance::update_threat_level(const Location &my_loc,
+                                       const LocationOrigin &my_origin,
                                        const Vector3f &my_vel,
                                        AP_Avoidance::Obstacle &obstacle)
 {
 
     Location &obstacle_loc = obstacle._location;
     Vector3f &obstacle_vel = obstacle._velocity;
+    const Vector2f delta_pos_ne = -my_origin.diff_ne(obstacle_loc);
 
     obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
 
     const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
-    float closest_xy = closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, _fail_time_horizon + obstacle_age/1000);
+    float closest_xy = closest_approach_xy(delta_pos_ne, my_vel, obstacle_vel, _fail_time_horizon + obstacle_age/1000);
     if (closest_xy < _fail_distance_xy) {
         obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_HIGH;
     } else {
-        closest_xy = closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, _warn_time_horizon + obstacle_age/1000);
+        closest_xy = closest_approach_xy(delta_pos_ne, my_vel, obstacle_vel, _warn_time_horizon + obstacle_age/1000);
         if (closest_xy < _warn_distance_xy) {
             obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_LOW;
         }
@@ -371,7 +372,7 @@ void AP_Avoidance::update_threat_level(const Location &my_loc,
     // level is none - but only *once the GCS has been informed*!
     obstacle.closest_approach_xy = closest_xy;
     obstacle.closest_approach_z = closest_z;
-    float current_distance = get_distance(my_loc, obstacle_loc);
+    float current_distance = delta_pos_ne.length();
     obstacle.distance_to_closest_approach = current_distance - closest_xy;
     Vector2f net_velocity_ne = Vector2f(my_vel[0] - obstacle_vel[0], my_vel[1] - obstacle_vel[1]);
     obstacle.time_to_closest_approach = 0.0f;
@@ -454,13 +455,14 @@ void AP_Avoidance::check_for_threats()
     // is most likely our own position and/or velocity have changed
     // determine the current most-serious-threat
     _current_most_serious_threat = -1;
+    const LocationOrigin my_origin(my_loc);
     for (uint8_t i=0; i<_obstacle_count; i++) {
 
         AP_Avoidance::Obstacle &obstacle = _obstacles[i];
         const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
         debug("i=%d src_id=%d timestamp=%u age=%d", i, obstacle.src_id, obstacle.timestamp_ms, obstacle_age);
 
-        update_threat_level(my_loc, my_vel, obstacle);
+        update_threat_level(my_loc, my_origin, my_vel, obstacle);
         debug("   threat-level=%d", obstacle.threat_level);
 
         // ignore any really old data:
@@ -161,6 +161,7 @@ private:
 
     void check_for_threats();
     void update_threat_level(const Location &my_loc,
+                             const LocationOrigin &my_origin,
                              const Vector3f &my_vel,
                              AP_Avoidance::Obstacle &obstacle);
 
@@ -203,9 +204,8 @@ private:
 
 float closest_distance_between_radial_and_point(const Vector2f &w,
                                                 const Vector2f &p);
-float closest_approach_xy(const Location &my_loc,
+float closest_approach_xy(const Vector2f &delta_pos_ne,
                           const Vector3f &my_vel,
-                          const Location &obstacle_loc,
                           const Vector3f &obstacle_vel,
                           uint8_t time_horizon);
 
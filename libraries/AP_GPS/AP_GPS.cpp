@@ -642,11 +642,19 @@ void AP_GPS::update_instance(uint8_t instance)
             data_should_be_logged = true;
         }
     } else {
+        // use the time the solution arrived on the UART when the
+        // driver knows it, as the main loop may read it much later
+        uint32_t msg_time_ms = tnow;
+        const uint32_t uart_timestamp_ms = state[instance].uart_timestamp_ms;
+        if (uart_timestamp_ms != 0 &&
+            tnow - uart_timestamp_ms < tnow - timing[instance].last_message_time_ms) {
+            msg_time_ms = uart_timestamp_ms;
+        }
         // delta will only be correct after parsing two messages
-        timing[instance].delta_time_ms = tnow - timing[instance].last_message_time_ms;
-        timing[instance].last_message_time_ms = tnow;
+        timing[instance].delta_time_ms = msg_time_ms - timing[instance].last_message_time_ms;
+        timing[instance].last_message_time_ms = msg_time_ms;
         if (state[instance].status >= GPS_OK_FIX_2D) {
-            timing[instance].last_fix_time_ms = tnow;
+            timing[instance].last_fix_time_ms = msg_time_ms;
         }
 
         data_should_be_logged = true;
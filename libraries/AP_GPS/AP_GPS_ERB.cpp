@@ -126,6 +126,8 @@ AP_GPS_ERB::read(void)
             }
 
             if (_parse_gps()) {
+                // header and checksum
+                solution_complete(_payload_length + 7);
                 parsed = true;
             }
             break;
@@ -121,6 +121,7 @@ bool AP_GPS_NMEA::read(void)
         }
 #endif
         if (_decode(c)) {
+            solution_complete(_sentence_length);
             parsed = true;
         }
     }
@@ -131,6 +132,10 @@ bool AP_GPS_NMEA::_decode(char c)
 {
     bool valid_sentence = false;
 
+    if (_sentence_length < UINT8_MAX) {
+        _sentence_length++;
+    }
+
     switch (c) {
     case ',': // term terminators
         _parity ^= c;
@@ -151,6 +156,7 @@ bool AP_GPS_NMEA::_decode(char c)
         return valid_sentence;
 
     case '$': // sentence begin
+        _sentence_length = 1;
         _term_number = _term_offset = 0;
         _parity = 0;
         _sentence_type = _GPS_SENTENCE_OTHER;
@@ -125,6 +125,7 @@ private:
     uint8_t _sentence_type;                                     ///< the sentence type currently being processed
     uint8_t _term_number;                                       ///< term index within the current sentence
     uint8_t _term_offset;                                       ///< character offset with the term being received
+    uint8_t _sentence_length;                                   ///< characters received since the start of the sentence
     bool _gps_data_good;                                        ///< set when the sentence indicates data is good
 
     // The result of parsing terms within a message is stored temporarily until
@@ -69,7 +69,11 @@ AP_GPS_SBF::read(void)
     uint32_t available_bytes = port->available();
     for (uint32_t i = 0; i < available_bytes; i++) {
         uint8_t temp = port->read();
-        ret |= parse(temp);
+        if (parse(temp)) {
+            // the block length includes the header
+            solution_complete(sbf_msg.length);
+            ret = true;
+        }
     }
 
     if (gps._auto_config != AP_GPS::GPS_AUTO_CONFIG_DISABLE) {
@@ -357,11 +357,20 @@ AP_GPS_UBLOX::read(void)
         }
     }
 
+    // process the bytes received, reading them a chunk at a time
+    uint8_t chunk[64];
+    uint8_t chunk_len = 0;
     numc = port->available();
     for (int16_t i = 0; i < numc; i++) {        // Process bytes received
 
         // read the next byte
-        data = port->read();
+        if (i % sizeof(chunk) == 0) {
+            chunk_len = port->read(chunk, MIN(numc - i, (int16_t)sizeof(chunk)));
+        }
+        if (i % sizeof(chunk) >= chunk_len) {
+            break;
+        }
+        data = chunk[i % sizeof(chunk)];
 
 	reset:
         switch(_step) {
@@ -456,6 +465,8 @@ AP_GPS_UBLOX::read(void)
             }
 
             if (_parse_gps()) {
+                // header and checksum, plus the rest of the chunk
+                solution_complete(_payload_length + 8 + (chunk_len - 1 - i % sizeof(chunk)));
                 parsed = true;
             }
             break;
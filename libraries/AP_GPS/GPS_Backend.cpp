@@ -36,6 +36,16 @@ AP_GPS_Backend::AP_GPS_Backend(AP_GPS &_gps, AP_GPS::GPS_State &_state, AP_HAL::
     state.have_speed_accuracy = false;
     state.have_horizontal_accuracy = false;
     state.have_vertical_accuracy = false;
+    state.uart_timestamp_ms = 0;
+}
+
+/*
+  record when the packet completing a solution arrived on the UART
+ */
+void AP_GPS_Backend::solution_complete(uint16_t nbytes)
+{
+    const uint64_t receive_us = port != nullptr ? port->receive_time_constraint_us(nbytes) : 0;
+    state.uart_timestamp_ms = receive_us != 0 ? uint32_t(receive_us / 1000U) : AP_HAL::millis();
 }
 
 int32_t AP_GPS_Backend::swap_int32(int32_t v) const
@@ -69,6 +69,14 @@ protected:
     AP_GPS &gps;                        ///< access to frontend (for parameters)
     AP_GPS::GPS_State &state;           ///< public state for this instance
 
+    /*
+      called by drivers on the packet that completes a solution, with
+      the packet length plus any bytes after it already taken from the
+      UART. Records when the packet arrived, so the frontend does not
+      depend on when the main loop got to it
+     */
+    void solution_complete(uint16_t nbytes);
+
     // common utility functions
     int32_t swap_int32(int32_t v) const;
     int16_t swap_int16(int16_t v) const;
@@ -0,0 +1,128 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  throughput of passing IMU sized samples from a producer thread to
+  the benchmark thread, through an ObjectBuffer protected by a
+  semaphore as the drivers use it, and through an SPSCObjectBuffer.
+  The argument is the number of samples pushed and popped per call
+ */
+#include <AP_gbenchmark.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+#define BENCH_BUFFER_SIZE 64
+
+struct bench_sample {
+    uint32_t timestamp_us;
+    float accel[3];
+    float gyro[3];
+};
+
+struct locked_queue {
+    ObjectBuffer<bench_sample> buf{BENCH_BUFFER_SIZE};
+    HAL_Semaphore sem;
+
+    bool push(const bench_sample *s, uint32_t n) {
+        sem.take_blocking();
+        bool ret = buf.push(s, n);
+        sem.give();
+        return ret;
+    }
+    uint32_t pop(bench_sample *s, uint32_t n) {
+        sem.take_blocking();
+        uint32_t count = 0;
+        while (count < n && buf.pop(s[count])) {
+            count++;
+        }
+        sem.give();
+        return count;
+    }
+};
+
+struct lockfree_queue {
+    SPSCObjectBuffer<bench_sample> buf{BENCH_BUFFER_SIZE};
+
+    bool push(const bench_sample *s, uint32_t n) {
+        return buf.push(s, n);
+    }
+    uint32_t pop(bench_sample *s, uint32_t n) {
+        return buf.pop(s, n);
+    }
+};
+
+template <class Q>
+struct producer_args {
+    Q queue;
+    uint32_t batch;
+    volatile bool stop;
+};
+
+template <class Q>
+static void *producer(void *arg)
+{
+    producer_args<Q> *args = (producer_args<Q> *)arg;
+    bench_sample s[BENCH_BUFFER_SIZE] {};
+    while (!args->stop) {
+        if (!args->queue.push(s, args->batch)) {
+            sched_yield();
+        }
+    }
+    return nullptr;
+}
+
+template <class Q>
+static void transfer(benchmark::State& state)
+{
+    producer_args<Q> args;
+    args.batch = state.range(0);
+    args.stop = false;
+
+    pthread_t thread;
+    pthread_create(&thread, nullptr, producer<Q>, &args);
+
+    bench_sample s[BENCH_BUFFER_SIZE];
+    uint64_t count = 0;
+    while (state.KeepRunning()) {
+        uint32_t n = args.queue.pop(s, args.batch);
+        if (n == 0) {
+            sched_yield();
+        }
+        count += n;
+        gbenchmark_escape(s);
+    }
+
+    args.stop = true;
+    pthread_join(thread, nullptr);
+    state.SetItemsProcessed(count);
+}
+
+static void BM_ObjectBufferLocked(benchmark::State& state)
+{
+    transfer<locked_queue>(state);
+}
+
+static void BM_ObjectBufferSPSC(benchmark::State& state)
+{
+    transfer<lockfree_queue>(state);
+}
+
+BENCHMARK(BM_ObjectBufferLocked)->Arg(1)->Arg(8);
+BENCHMARK(BM_ObjectBufferSPSC)->Arg(1)->Arg(8);
+
+BENCHMARK_MAIN()
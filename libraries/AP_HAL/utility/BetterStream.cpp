@@ -25,6 +25,18 @@ size_t AP_HAL::BetterStream::write(const uint8_t *buffer, size_t size)
     return size;
 }
 
+size_t AP_HAL::BetterStream::read(uint8_t *buffer, size_t size)
+{
+    for (size_t i=0; i<size; i++) {
+        const int16_t c = read();
+        if (c == -1) {
+            return i;
+        }
+        buffer[i] = (uint8_t)c;
+    }
+    return size;
+}
+
 size_t AP_HAL::BetterStream::write(const char *str)
 {
     return write((const uint8_t *)str, strlen(str));
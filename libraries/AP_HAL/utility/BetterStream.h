@@ -43,6 +43,11 @@ public:
      * -1 if nothing available, uint8_t value otherwise. */
     virtual int16_t read() = 0;
 
+    /* read up to size bytes into buffer, returning the number of bytes
+     * read. Drivers with a receive buffer override this to copy whole
+     * spans rather than a byte at a time */
+    virtual size_t read(uint8_t *buffer, size_t size);
+
     /* NB txspace was traditionally a member of BetterStream in the
      * FastSerial library. As far as concerns go, it belongs with available() */
     virtual uint32_t txspace() = 0;
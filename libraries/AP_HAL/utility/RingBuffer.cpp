@@ -250,3 +250,108 @@ int16_t ByteBuffer::peek(uint32_t ofs) const
     }
     return buf[(head+ofs)%size];
 }
+
+SPSCByteBuffer::SPSCByteBuffer(uint32_t _size)
+{
+    buf = (uint8_t*)calloc(1, _size);
+    size = buf ? _size : 0;
+}
+
+SPSCByteBuffer::~SPSCByteBuffer(void)
+{
+    free(buf);
+}
+
+uint32_t SPSCByteBuffer::available(void) const
+{
+    reader_tail = tail.load(std::memory_order_acquire);
+    return count(head.load(std::memory_order_relaxed), reader_tail);
+}
+
+uint32_t SPSCByteBuffer::space(void) const
+{
+    writer_head = head.load(std::memory_order_acquire);
+    return size - count(writer_head, tail.load(std::memory_order_relaxed));
+}
+
+/*
+  copy len bytes starting at index _head, which must be available
+ */
+void SPSCByteBuffer::copy_out(uint32_t _head, uint8_t *data, uint32_t len) const
+{
+    const uint32_t ofs = buf_offset(_head);
+    uint32_t n = size - ofs;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(data, &buf[ofs], n);
+    if (len > n) {
+        memcpy(data + n, &buf[0], len - n);
+    }
+}
+
+uint32_t SPSCByteBuffer::write(const uint8_t *data, uint32_t len)
+{
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    uint32_t _space = size - count(writer_head, _tail);
+    if (_space < len) {
+        writer_head = head.load(std::memory_order_acquire);
+        _space = size - count(writer_head, _tail);
+    }
+    if (len > _space) {
+        len = _space;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    const uint32_t ofs = buf_offset(_tail);
+    uint32_t n = size - ofs;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(&buf[ofs], data, n);
+    if (len > n) {
+        memcpy(&buf[0], data + n, len - n);
+    }
+
+    tail.store(next_index(_tail, len), std::memory_order_release);
+    return len;
+}
+
+uint32_t SPSCByteBuffer::peekbytes(uint8_t *data, uint32_t len) const
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    uint32_t _available = count(_head, reader_tail);
+    if (_available < len) {
+        reader_tail = tail.load(std::memory_order_acquire);
+        _available = count(_head, reader_tail);
+    }
+    if (len > _available) {
+        len = _available;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    copy_out(_head, data, len);
+    return len;
+}
+
+uint32_t SPSCByteBuffer::read(uint8_t *data, uint32_t len)
+{
+    len = peekbytes(data, len);
+    if (len > 0) {
+        head.store(next_index(head.load(std::memory_order_relaxed), len), std::memory_order_release);
+    }
+    return len;
+}
+
+bool SPSCByteBuffer::advance(uint32_t n)
+{
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    if (count(_head, reader_tail) < n && available() < n) {
+        return false;
+    }
+    head.store(next_index(_head, n), std::memory_order_release);
+    return true;
+}
@@ -199,6 +199,156 @@ private:
 };
 
 
+#ifndef AP_CACHE_LINE_SIZE
+#define AP_CACHE_LINE_SIZE 64
+#endif
+
+/*
+  Circular buffer of bytes for exactly one writer thread and one reader
+  thread, without locking.
+
+  The writer owns tail and the reader owns head. Each side publishes
+  its index with a release store after copying the data, and loads the
+  other side's index with an acquire load, so data is always visible
+  before the index covering it. The indices are kept on separate cache
+  lines, and each side keeps its own copy of the other's index, only
+  reloading it when the buffer looks full (writer) or empty (reader).
+
+  write() and space() may only be called by the writer, and read(),
+  peekbytes(), advance(), available() and empty() only by the reader.
+ */
+class SPSCByteBuffer {
+public:
+    SPSCByteBuffer(uint32_t size);
+    ~SPSCByteBuffer(void);
+
+    // return size of ringbuffer
+    uint32_t get_size(void) const { return size; }
+
+    // reader: number of bytes available to be read
+    uint32_t available(void) const;
+
+    // reader: true if available() is zero
+    bool empty(void) const { return available() == 0; }
+
+    // reader: read bytes from ringbuffer. Returns number of bytes read
+    uint32_t read(uint8_t *data, uint32_t len);
+
+    // reader: read len bytes without advancing the read pointer
+    uint32_t peekbytes(uint8_t *data, uint32_t len) const;
+
+    // reader: advance the read pointer (discarding bytes)
+    bool advance(uint32_t n);
+
+    // writer: number of bytes space available to write
+    uint32_t space(void) const;
+
+    // writer: write bytes to ringbuffer. Returns number of bytes written
+    uint32_t write(const uint8_t *data, uint32_t len);
+
+private:
+    uint8_t *buf;
+    uint32_t size;
+
+    // indexes run from 0 to 2*size-1, so a full buffer can be told
+    // from an empty one without keeping a spare byte
+    uint32_t count(uint32_t _head, uint32_t _tail) const {
+        return _tail >= _head ? _tail - _head : 2*size - _head + _tail;
+    }
+    uint32_t next_index(uint32_t idx, uint32_t n) const {
+        idx += n;
+        return idx >= 2*size ? idx - 2*size : idx;
+    }
+    uint32_t buf_offset(uint32_t idx) const {
+        return idx >= size ? idx - size : idx;
+    }
+    void copy_out(uint32_t _head, uint8_t *data, uint32_t len) const;
+
+    // reader side
+    std::atomic<uint32_t> head{0};
+    mutable uint32_t reader_tail = 0;
+    uint8_t reader_pad[AP_CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>) - sizeof(uint32_t)];
+
+    // writer side
+    std::atomic<uint32_t> tail{0};
+    mutable uint32_t writer_head = 0;
+    uint8_t writer_pad[AP_CACHE_LINE_SIZE - sizeof(std::atomic<uint32_t>) - sizeof(uint32_t)];
+};
+
+/*
+  ring buffer class for objects of fixed size, for exactly one writer
+  thread and one reader thread, without locking. See SPSCByteBuffer
+  for which calls belong to which thread. There is no push_force() as
+  only the reader may discard objects
+ */
+template <class T>
+class SPSCObjectBuffer {
+public:
+    SPSCObjectBuffer(uint32_t _size) :
+        buffer(_size * sizeof(T))
+    {}
+
+    // return size of ringbuffer in objects, zero if allocation failed
+    uint32_t get_size(void) const {
+        return buffer.get_size() / sizeof(T);
+    }
+
+    // reader: return number of objects available to be read
+    uint32_t available(void) const {
+        return buffer.available() / sizeof(T);
+    }
+
+    // writer: return number of objects that could be written
+    uint32_t space(void) const {
+        return buffer.space() / sizeof(T);
+    }
+
+    // reader: true is available() == 0
+    bool empty(void) const {
+        return buffer.empty();
+    }
+
+    // writer: push one object
+    bool push(const T &object) {
+        return push(&object, 1);
+    }
+
+    // writer: push N objects. Either all or none are pushed
+    bool push(const T *object, uint32_t n) {
+        if (buffer.space() < n*sizeof(T)) {
+            return false;
+        }
+        return buffer.write((const uint8_t*)object, n*sizeof(T)) == n*sizeof(T);
+    }
+
+    // reader: throw away an object
+    bool pop(void) {
+        return buffer.advance(sizeof(T));
+    }
+
+    // reader: pop earliest object off the queue
+    bool pop(T &object) {
+        return pop(&object, 1) == 1;
+    }
+
+    // reader: pop up to N objects. Returns number of objects popped
+    uint32_t pop(T *object, uint32_t n) {
+        const uint32_t avail = available();
+        if (n > avail) {
+            n = avail;
+        }
+        return buffer.read((uint8_t*)object, n*sizeof(T)) / sizeof(T);
+    }
+
+    // reader: peek copies an object out without advancing the read pointer
+    bool peek(T &object) const {
+        return buffer.peekbytes((uint8_t*)&object, sizeof(T)) == sizeof(T);
+    }
+
+private:
+    SPSCByteBuffer buffer;
+};
+
 
 /*
   ring buffer class for objects of fixed size with pointer
@@ -0,0 +1,169 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_gtest.h>
+
+#include <pthread.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+// number of values passed between the threads in each stress test
+#define STRESS_COUNT 500000U
+
+struct sample {
+    uint32_t seq;
+    uint32_t check;
+    float value[3];
+};
+
+TEST(SPSCByteBuffer, FillAndWrap)
+{
+    SPSCByteBuffer buf(10);
+    uint8_t data[10];
+    uint8_t out[10];
+
+    for (uint8_t i=0; i<sizeof(data); i++) {
+        data[i] = i;
+    }
+
+    // fill completely, no spare byte is needed
+    EXPECT_EQ(10U, buf.space());
+    EXPECT_EQ(10U, buf.write(data, 10));
+    EXPECT_EQ(0U, buf.space());
+    EXPECT_EQ(0U, buf.write(data, 1));
+    EXPECT_EQ(10U, buf.available());
+
+    // wrap around several times with odd sized reads and writes
+    for (uint16_t n=0; n<100; n++) {
+        EXPECT_EQ(7U, buf.read(out, 7));
+        EXPECT_EQ(3U, buf.available());
+        EXPECT_EQ(7U, buf.write(data, 7));
+        EXPECT_EQ(10U, buf.available());
+    }
+
+    EXPECT_TRUE(buf.advance(3));
+    EXPECT_FALSE(buf.advance(8));
+    EXPECT_EQ(7U, buf.peekbytes(out, 10));
+    EXPECT_EQ(0, memcmp(out, data, 7));
+    EXPECT_EQ(7U, buf.read(out, 10));
+    EXPECT_TRUE(buf.empty());
+}
+
+TEST(SPSCObjectBuffer, Batch)
+{
+    SPSCObjectBuffer<sample> buf(8);
+    sample in[8] {};
+    sample out[8];
+
+    for (uint8_t i=0; i<8; i++) {
+        in[i].seq = i;
+    }
+
+    EXPECT_TRUE(buf.push(in, 5));
+    // a batch that does not fit is not pushed at all
+    EXPECT_FALSE(buf.push(in, 4));
+    EXPECT_EQ(5U, buf.available());
+
+    EXPECT_EQ(5U, buf.pop(out, 8));
+    for (uint8_t i=0; i<5; i++) {
+        EXPECT_EQ(i, out[i].seq);
+    }
+    EXPECT_FALSE(buf.pop(out[0]));
+}
+
+static void *byte_producer(void *arg)
+{
+    SPSCByteBuffer *buf = (SPSCByteBuffer *)arg;
+    uint32_t seq = 0;
+    uint8_t chunk[37];
+    while (seq < STRESS_COUNT) {
+        // vary the write size so writes wrap at all offsets
+        const uint32_t len = 1 + seq % sizeof(chunk);
+        uint32_t n = 0;
+        while (n < len && seq + n < STRESS_COUNT) {
+            chunk[n] = (seq + n) & 0xFF;
+            n++;
+        }
+        const uint32_t written = buf->write(chunk, n);
+        seq += written;
+    }
+    return nullptr;
+}
+
+TEST(SPSCByteBuffer, Stress)
+{
+    SPSCByteBuffer buf(1021);
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, nullptr, byte_producer, &buf));
+
+    uint32_t seq = 0;
+    uint8_t chunk[53];
+    while (seq < STRESS_COUNT) {
+        const uint32_t n = buf.read(chunk, 1 + seq % sizeof(chunk));
+        for (uint32_t i=0; i<n; i++) {
+            ASSERT_EQ((seq + i) & 0xFF, chunk[i]);
+        }
+        seq += n;
+    }
+
+    pthread_join(thread, nullptr);
+    EXPECT_TRUE(buf.empty());
+}
+
+static void *object_producer(void *arg)
+{
+    SPSCObjectBuffer<sample> *buf = (SPSCObjectBuffer<sample> *)arg;
+    uint32_t seq = 0;
+    sample batch[5];
+    while (seq < STRESS_COUNT) {
+        uint32_t n = 1 + seq % 5;
+        if (seq + n > STRESS_COUNT) {
+            n = STRESS_COUNT - seq;
+        }
+        for (uint32_t i=0; i<n; i++) {
+            batch[i].seq = seq + i;
+            batch[i].check = ~(seq + i);
+            batch[i].value[0] = batch[i].value[1] = batch[i].value[2] = seq + i;
+        }
+        if (buf->push(batch, n)) {
+            seq += n;
+        }
+    }
+    return nullptr;
+}
+
+TEST(SPSCObjectBuffer, Stress)
+{
+    SPSCObjectBuffer<sample> buf(127);
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, nullptr, object_producer, &buf));
+
+    uint32_t seq = 0;
+    sample batch[7];
+    while (seq < STRESS_COUNT) {
+        const uint32_t n = buf.pop(batch, 1 + seq % 7);
+        for (uint32_t i=0; i<n; i++) {
+            // a torn object would show as a mismatch between fields
+            ASSERT_EQ(seq + i, batch[i].seq);
+            ASSERT_EQ(~(seq + i), batch[i].check);
+            ASSERT_FLOAT_EQ((float)(seq + i), batch[i].value[2]);
+        }
+        seq += n;
+    }
+
+    pthread_join(thread, nullptr);
+    EXPECT_TRUE(buf.empty());
+}
+
+AP_GTEST_MAIN()
@@ -504,6 +504,23 @@ int16_t UARTDriver::read()
     return byte;
 }
 
+size_t UARTDriver::read(uint8_t *buffer, size_t size)
+{
+    if (_uart_owner_thd != chThdGetSelfX()){
+        return 0;
+    }
+    if (!_initialised) {
+        return 0;
+    }
+
+    const size_t ret = _readbuf.read(buffer, size);
+    if (!_rts_is_active) {
+        update_rts_line();
+    }
+
+    return ret;
+}
+
 /* Empty implementations of Print virtual methods */
 size_t UARTDriver::write(uint8_t c)
 {
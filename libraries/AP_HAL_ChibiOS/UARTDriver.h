@@ -44,6 +44,7 @@ public:
     uint32_t available() override;
     uint32_t txspace() override;
     int16_t read() override;
+    size_t read(uint8_t *buffer, size_t size) override;
     void _timer_tick(void) override;
 
     size_t write(uint8_t c);
@@ -107,6 +107,14 @@ int16_t UARTDriver::read() {
     return usart_getc(_usart_device);
 }
 
+size_t UARTDriver::read(uint8_t *buffer, size_t size) {
+    const size_t n = MIN(size, available());
+    for (size_t i=0; i<n; i++) {
+        buffer[i] = usart_getc(_usart_device);
+    }
+    return n;
+}
+
 size_t UARTDriver::write(uint8_t c) {
 
     if (!_initialized) { 
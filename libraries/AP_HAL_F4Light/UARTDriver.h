@@ -47,6 +47,7 @@ public:
     uint32_t available() override;
     uint32_t inline  txspace() override {    return usart_txfifo_freebytes(_usart_device); }
     int16_t read() override;
+    size_t read(uint8_t *buffer, size_t size) override;
 
     size_t write(uint8_t c);
     size_t write(const uint8_t *buffer, size_t size);
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <sys/select.h>
+#include <time.h>
 
 #include <AP_Param/AP_Param.h>
 #include <SITL/SIM_JSBSim.h>
@@ -117,6 +118,10 @@ void SITL_State::_sitl_setup(const char *home_str)
  */
 void SITL_State::_setup_fdm(void)
 {
+    if (_batch_mode) {
+        // RC input comes from the model and SIM parameters
+        return;
+    }
     if (!_sitl_rc_in.bind("0.0.0.0", _rcin_port)) {
         fprintf(stderr, "SITL: socket bind failed on RC in port : %d - %s\n", _rcin_port, strerror(errno));
         fprintf(stderr, "Aborting launch...\n");
@@ -138,11 +143,18 @@ void SITL_State::_fdm_input_step(void)
 
     _fdm_input_local();
 
-    /* make sure we die if our parent dies */
-    if (kill(_parent_pid, 0) != 0) {
+    /* make sure we die if our parent dies. In batch mode this is
+       checked less often, as the syscall is a noticeable part of a
+       step when running unsynchronised */
+    if ((!_batch_mode || (_update_count % 1000) == 0) &&
+        kill(_parent_pid, 0) != 0) {
         exit(1);
     }
 
+    if (_batch_mode) {
+        _batch_report();
+    }
+
     if (_scheduler->interrupts_are_blocked() || _sitl == nullptr) {
         return;
     }
@@ -186,6 +198,33 @@ void SITL_State::_fdm_input_step(void)
 }
 
 
+/*
+  report the achieved speedup of a batch instance every 10 seconds of
+  wall clock time
+ */
+void SITL_State::_batch_report(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint64_t wall_us = ts.tv_sec*1000000ULL + ts.tv_nsec/1000U;
+    const uint64_t sim_us = AP_HAL::micros64();
+
+    if (_batch_start_wall_us == 0) {
+        _batch_start_wall_us = _batch_report_wall_us = wall_us;
+        _batch_start_sim_us = _batch_report_sim_us = sim_us;
+        return;
+    }
+    if (wall_us - _batch_report_wall_us < 10000000ULL) {
+        return;
+    }
+    const float speedup = float(sim_us - _batch_report_sim_us) / (wall_us - _batch_report_wall_us);
+    const float average = float(sim_us - _batch_start_sim_us) / (wall_us - _batch_start_wall_us);
+    printf("SITL[%u]: sim time %.1fs speedup %.1f average %.1f\n",
+           (unsigned)_instance, sim_us * 1.0e-6, (double)speedup, (double)average);
+    _batch_report_wall_us = wall_us;
+    _batch_report_sim_us = sim_us;
+}
+
 void SITL_State::wait_clock(uint64_t wait_time_usec)
 {
     while (AP_HAL::micros64() < wait_time_usec) {
@@ -221,6 +260,10 @@ void SITL_State::_check_rc_input(void)
         uint16_t pwm[16];
     } pwm_pkt;
 
+    if (_batch_mode) {
+        return;
+    }
+
     size = _sitl_rc_in.recv(&pwm_pkt, sizeof(pwm_pkt), 0);
     switch (size) {
     case 8*2:
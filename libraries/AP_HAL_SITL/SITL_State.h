@@ -140,6 +140,8 @@ private:
     uint16_t _airspeed_sensor(float airspeed);
     uint16_t _ground_sonar();
     void _fdm_input_step(void);
+    void _batch_fork(void);
+    void _batch_report(void);
 
     void wait_clock(uint64_t wait_time_usec);
 
@@ -220,6 +222,14 @@ private:
     const char *defaults_path = HAL_PARAM_DEFAULTS_PATH;
 
     const char *_home_str;
+
+    // headless batch mode, see --batch and --batch-instances
+    bool _batch_mode;
+    uint8_t _batch_instances;
+    uint64_t _batch_start_wall_us;
+    uint64_t _batch_start_sim_us;
+    uint64_t _batch_report_wall_us;
+    uint64_t _batch_report_sim_us;
 };
 
 #endif // CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -9,6 +9,10 @@
 #include <stdio.h>
 #include <signal.h>
 #include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <AP_HAL/utility/getopt_cpp.h>
 
 #include <SITL/SIM_Multicopter.h>
@@ -75,6 +79,8 @@ void SITL_State::_usage(void)
            "\t--sim-port-in PORT       set port num for simulator in\n"
            "\t--sim-port-out PORT      set port num for simulator out\n"
            "\t--irlock-port PORT       set port num for irlock\n"
+           "\t--batch                  headless mode: no RC input or FlightGear sockets, no wall clock sync\n"
+           "\t--batch-instances N      with --batch, fork N instances starting at the -I instance, each in its own directory\n"
         );
 }
 
@@ -157,6 +163,13 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     uint16_t simulator_port_out = SIM_OUT_PORT;
     _irlock_port = IRLOCK_PORT;
 
+    // options that write to storage are applied once the instance
+    // directory is known, so forked batch instances do not share files
+    bool wipe = false;
+    const char *speedup_str = nullptr;
+    const char *param_defaults[16];
+    uint8_t num_param_defaults = 0;
+
     enum long_options {
         CMDLINE_GIMBAL = 1,
         CMDLINE_FGVIEW,
@@ -176,6 +189,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_SIM_PORT_IN,
         CMDLINE_SIM_PORT_OUT,
         CMDLINE_IRLOCK_PORT,
+        CMDLINE_BATCH,
+        CMDLINE_BATCH_INSTANCES,
     };
 
     const struct GetOptLong::option options[] = {
@@ -209,6 +224,8 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"sim-port-in",     true,   0, CMDLINE_SIM_PORT_IN},
         {"sim-port-out",    true,   0, CMDLINE_SIM_PORT_OUT},
         {"irlock-port",     true,   0, CMDLINE_IRLOCK_PORT},
+        {"batch",           false,  0, CMDLINE_BATCH},
+        {"batch-instances", true,   0, CMDLINE_BATCH_INSTANCES},
         {0, false, 0, 0}
     };
 
@@ -226,17 +243,14 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     while ((opt = gopt.getoption()) != -1) {
         switch (opt) {
         case 'w':
-            AP_Param::erase_all();
-            unlink("dataflash.bin");
+            wipe = true;
             break;
         case 'u':
             AP_Param::set_hide_disabled_groups(false);
             break;
         case 's':
             speedup = strtof(gopt.optarg, nullptr);
-            char speedup_string[18];
-            snprintf(speedup_string, sizeof(speedup_string), "SIM_SPEEDUP=%s", gopt.optarg);
-            _set_param_default(speedup_string);
+            speedup_str = gopt.optarg;
             break;
         case 'r':
             _framerate = (unsigned)atoi(gopt.optarg);
@@ -244,30 +258,15 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case 'C':
             HALSITL::UARTDriver::_console = true;
             break;
-        case 'I': {
+        case 'I':
             _instance = atoi(gopt.optarg);
-            if (_base_port == BASE_PORT) {
-                _base_port += _instance * 10;
-            }
-            if (_rcin_port == RCIN_PORT) {
-                _rcin_port += _instance * 10;
-            }
-            if (_fg_view_port == FG_VIEW_PORT) {
-                _fg_view_port += _instance * 10;
-            }
-            if (simulator_port_in == SIM_IN_PORT) {
-                simulator_port_in += _instance * 10;
-            }
-            if (simulator_port_out == SIM_OUT_PORT) {
-                simulator_port_out += _instance * 10;
-            }
-            if (_irlock_port == IRLOCK_PORT) {
-                _irlock_port += _instance * 10;
-            }
-        }
-        break;
+            break;
         case 'P':
-            _set_param_default(gopt.optarg);
+            if (num_param_defaults == ARRAY_SIZE(param_defaults)) {
+                printf("Too many parameters\n");
+                exit(1);
+            }
+            param_defaults[num_param_defaults++] = gopt.optarg;
             break;
         case 'S':
             _synthetic_clock_mode = true;
@@ -323,6 +322,12 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_IRLOCK_PORT:
             _irlock_port = atoi(gopt.optarg);
             break;
+        case CMDLINE_BATCH:
+            _batch_mode = true;
+            break;
+        case CMDLINE_BATCH_INSTANCES:
+            _batch_instances = atoi(gopt.optarg);
+            break;
         default:
             _usage();
             exit(1);
@@ -334,6 +339,55 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         exit(1);
     }
 
+    if (_batch_mode) {
+        _use_fg_view = false;
+        if (_batch_instances > 1) {
+            // the instances run in their own directories
+            char path[PATH_MAX];
+            if (realpath(autotest_dir, path) != nullptr) {
+                autotest_dir = strdup(path);
+            }
+            // only returns in the forked instances
+            _batch_fork();
+        }
+    } else if (_batch_instances > 1) {
+        printf("--batch-instances needs --batch\n");
+        exit(1);
+    }
+
+    // ports not given on the command line are offset by the instance
+    if (_base_port == BASE_PORT) {
+        _base_port += _instance * 10;
+    }
+    if (_rcin_port == RCIN_PORT) {
+        _rcin_port += _instance * 10;
+    }
+    if (_fg_view_port == FG_VIEW_PORT) {
+        _fg_view_port += _instance * 10;
+    }
+    if (simulator_port_in == SIM_IN_PORT) {
+        simulator_port_in += _instance * 10;
+    }
+    if (simulator_port_out == SIM_OUT_PORT) {
+        simulator_port_out += _instance * 10;
+    }
+    if (_irlock_port == IRLOCK_PORT) {
+        _irlock_port += _instance * 10;
+    }
+
+    if (wipe) {
+        AP_Param::erase_all();
+        unlink("dataflash.bin");
+    }
+    if (speedup_str != nullptr) {
+        char speedup_string[18];
+        snprintf(speedup_string, sizeof(speedup_string), "SIM_SPEEDUP=%s", speedup_str);
+        _set_param_default(speedup_string);
+    }
+    for (uint8_t i=0; i<num_param_defaults; i++) {
+        _set_param_default(param_defaults[i]);
+    }
+
     for (uint8_t i=0; i < ARRAY_SIZE(model_constructors); i++) {
         if (strncasecmp(model_constructors[i].name, model_str, strlen(model_constructors[i].name)) == 0) {
             printf("Creating model %s at speed %.1f\n", model_str, speedup);
@@ -342,6 +396,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
             sitl_model->set_speedup(speedup);
             sitl_model->set_instance(_instance);
             sitl_model->set_autotest_dir(autotest_dir);
+            if (_batch_mode) {
+                sitl_model->disable_time_sync();
+            }
             _synthetic_clock_mode = true;
             break;
         }
@@ -380,4 +437,58 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     _sitl_setup(home_str);
 }
 
+/*
+  fork the instances of a batch run, each in its own directory so they
+  have separate eeprom, logs and terrain. Only returns in the forked
+  instances; the parent waits for all of them and exits
+ */
+void SITL_State::_batch_fork(void)
+{
+    // a defaults path given on the command line is relative to where
+    // we started
+    char path[PATH_MAX];
+    if (defaults_path != nullptr && realpath(defaults_path, path) != nullptr) {
+        defaults_path = strdup(path);
+    }
+
+    const uint8_t first_instance = _instance;
+    for (uint8_t i=0; i<_batch_instances; i++) {
+        const pid_t pid = fork();
+        if (pid == -1) {
+            fprintf(stderr, "SITL: fork failed - %s\n", strerror(errno));
+            exit(1);
+        }
+        if (pid == 0) {
+            _instance = first_instance + i;
+            char dir[16];
+            snprintf(dir, sizeof(dir), "instance%u", (unsigned)_instance);
+            if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || chdir(dir) != 0) {
+                fprintf(stderr, "SITL: unable to use directory %s - %s\n", dir, strerror(errno));
+                exit(1);
+            }
+            return;
+        }
+    }
+
+    uint8_t failures = 0;
+    uint8_t remaining = _batch_instances;
+    while (remaining > 0) {
+        int status;
+        const pid_t pid = wait(&status);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        remaining--;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failures++;
+        }
+    }
+    failures += remaining;
+    printf("SITL: %u of %u batch instances failed\n", (unsigned)failures, (unsigned)_batch_instances);
+    exit(failures == 0 ? 0 : 1);
+}
+
 #endif
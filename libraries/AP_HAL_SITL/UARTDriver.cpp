@@ -151,6 +151,14 @@ int16_t UARTDriver::read(void)
     return c;
 }
 
+size_t UARTDriver::read(uint8_t *buffer, size_t size)
+{
+    if (available() <= 0) {
+        return 0;
+    }
+    return _readbuffer.read(buffer, size);
+}
+
 void UARTDriver::flush(void)
 {
 }
@@ -445,6 +445,10 @@ const AP_Param::GroupInfo AP_InertialSensor::var_info[] = {
     // @Values: 1:FirstIMUOnly,3:FirstAndSecondIMU,7:FirstSecondAndThirdIMU,127:AllIMUs
     // @Bitmask: 0:FirstIMU,1:SecondIMU,2:ThirdIMU
     AP_GROUPINFO("ENABLE_MASK",  40, AP_InertialSensor, _enable_mask, 0x7F),
+
+    // @Group: FFT_
+    // @Path: ../AP_InertialSensor/GyroFFT.cpp
+    AP_SUBGROUPINFO(gyro_fft, "FFT_",  41, AP_InertialSensor, AP_InertialSensor::GyroFFT),
     
     /*
       NOTE: parameter indexes have gaps above. When adding new
@@ -649,6 +653,9 @@ AP_InertialSensor::init(uint16_t sample_rate)
 
     // initialise IMU batch logging
     batchsampler.init();
+
+    // start in-flight gyro spectral analysis
+    gyro_fft.init();
 }
 
 bool AP_InertialSensor::_add_backend(AP_InertialSensor_Backend *backend)
@@ -1260,6 +1267,9 @@ void AP_InertialSensor::update(void)
             _delta_velocity_valid[i] = false;
             _delta_angle_valid[i] = false;
         }
+        // pick up new peaks before the backends update their filters
+        gyro_fft.update();
+
         for (uint8_t i=0; i<_backend_count; i++) {
             _backends[i]->update();
         }
@@ -1333,8 +1343,10 @@ void AP_InertialSensor::update(void)
         }
     }
 
-    // apply notch filter to primary gyro
-    _gyro[_primary_gyro] = _notch_filter.apply(_gyro[_primary_gyro]);
+    // apply notch filter to every gyro, so each keeps its own filter
+    // state when the primary changes
+    static_assert(INS_MAX_INSTANCES <= NOTCH_FILTER_MAX_VECTORS, "notch filter too small for all gyros");
+    _notch_filter.apply(_gyro, _gyro_count);
     
     _last_update_usec = AP_HAL::micros();
     
@@ -14,6 +14,7 @@
  */
 #define INS_MAX_INSTANCES 3
 #define INS_MAX_BACKENDS  6
+#define INS_MAX_NOTCHES   4
 #define INS_VIBRATION_CHECK_INSTANCES 2
 
 #define DEFAULT_IMU_LOG_BAT_MASK 0
@@ -22,8 +23,11 @@
 
 #include <AP_AccelCal/AP_AccelCal.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
 #include <AP_Math/AP_Math.h>
+#include <AP_Math/fft.h>
 #include <Filter/LowPassFilter2p.h>
+#include <Filter/BiquadFilterBank.h>
 #include <Filter/LowPassFilter.h>
 #include <Filter/NotchFilter.h>
 
@@ -351,6 +355,104 @@ public:
     };
     BatchSampler batchsampler{*this};
 
+    /*
+      spectral analysis of the raw gyro stream of the first IMU. A
+      thread takes a windowed FFT of each axis, tracks the strongest
+      peaks and the backends place a notch on each of them after the
+      gyro low pass
+     */
+    class GyroFFT {
+    public:
+        GyroFFT(const AP_InertialSensor &imu) :
+            _imu(imu) {
+            AP_Param::setup_object_defaults(this, var_info);
+        };
+
+        /* Do not allow copies */
+        GyroFFT(const GyroFFT &other) = delete;
+        GyroFFT &operator=(const GyroFFT&) = delete;
+
+        void init();
+
+        // called by the backends for each raw gyro sample
+        void sample(uint8_t instance, const Vector3f &gyro);
+
+        // called by the main thread to pick up new peaks
+        void update();
+
+        // incremented each time the notch frequencies change
+        uint8_t notch_seq() const { return _notch_seq; }
+
+        // fill in notch coefficients for the current peaks at the
+        // given sample rate, returning the number of notches
+        uint8_t get_notches(float sample_freq_hz, BiquadCoefficients *coeffs) const;
+
+        // class level parameters
+        static const struct AP_Param::GroupInfo var_info[];
+
+        // Parameters
+        AP_Int8 _enable;
+        AP_Int16 _window_size;
+        AP_Int16 _min_hz;
+        AP_Int16 _max_hz;
+        AP_Int8 _num_peaks;
+        AP_Int8 _bandwidth_pct;
+        AP_Float _attenuation_dB;
+
+    private:
+        struct peaks {
+            float freq_hz[INS_MAX_NOTCHES];
+            uint8_t count;
+        };
+
+        // handed from the FFT thread to the main thread once per frame
+        struct frame_result {
+            struct peaks peaks;
+            bool changed;
+            float frame_us_avg;
+            uint32_t frame_us_max;
+        };
+
+        void thread();
+        bool run_frame();
+        uint8_t find_peaks(float *freq_hz);
+        void Log_Write(const struct frame_result &result) const;
+
+        bool _running;
+
+        // sample decimation, owned by the backend thread
+        uint16_t _decimation;
+        uint16_t _decimation_count;
+        Vector3f _decimation_sum;
+
+        // analysis state, owned by the FFT thread
+        RealFFT _fft;
+        float _sample_rate_hz;
+        uint16_t _hop;
+        uint16_t _new_samples;
+        uint16_t _history_idx;
+        float *_history[3];
+        float *_frame;
+        float *_power;
+        float *_power_sum;
+        struct peaks _tracked;
+        struct peaks _notched;      // peaks the notches were last placed at
+        uint32_t _last_peak_ms;
+        uint32_t _frame_us_max;
+        float _frame_us_avg;
+        bool _unsent_change;
+
+        // peaks as seen by the main thread
+        struct peaks _current;
+        uint8_t _notch_seq;
+
+        SPSCObjectBuffer<Vector3f> *_samples;
+        SPSCObjectBuffer<struct frame_result> *_peaks;
+
+        const AP_InertialSensor &_imu;
+    };
+    GyroFFT gyro_fft{*this};
+
 private:
     // load backend drivers
     bool _add_backend(AP_InertialSensor_Backend *backend);
@@ -396,13 +498,14 @@ private:
 
     // Low Pass filters for gyro and accel
     LowPassFilter2pVector3f _accel_filter[INS_MAX_INSTANCES];
-    LowPassFilter2pVector3f _gyro_filter[INS_MAX_INSTANCES];
+    // low pass in section 0, followed by the GyroFFT notches
+    BiquadFilterBank<3, 1+INS_MAX_NOTCHES> _gyro_filter[INS_MAX_INSTANCES];
     Vector3f _accel_filtered[INS_MAX_INSTANCES];
     Vector3f _gyro_filtered[INS_MAX_INSTANCES];
     bool _new_accel_data[INS_MAX_INSTANCES];
     bool _new_gyro_data[INS_MAX_INSTANCES];
 
-    // optional notch filter on gyro
+    // optional notch filter on all gyros
     NotchFilterVector3fParam _notch_filter;
 
     // Most recent gyro reading
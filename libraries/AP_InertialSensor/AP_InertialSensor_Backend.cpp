@@ -169,6 +169,9 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
     }
     _imu._gyro_last_sample_us[instance] = sample_us;
 
+    // feed the dynamic notch analysis before any filtering
+    _imu.gyro_fft.sample(instance, gyro);
+
 #if AP_MODULE_SUPPORTED
     // call gyro_sample hook if any
     AP_Module::call_hook_gyro_sample(instance, dt, gyro);
@@ -433,10 +436,20 @@ void AP_InertialSensor_Backend::update_gyro(uint8_t instance)
         _imu._new_gyro_data[instance] = false;
     }
 
-    // possibly update filter frequency
-    if (_last_gyro_filter_hz[instance] != _gyro_filter_cutoff()) {
-        _imu._gyro_filter[instance].set_cutoff_frequency(_gyro_raw_sample_rate(instance), _gyro_filter_cutoff());
+    // possibly update filter frequency or dynamic notches
+    if (_last_gyro_filter_hz[instance] != _gyro_filter_cutoff() ||
+        _last_gyro_notch_seq[instance] != _imu.gyro_fft.notch_seq()) {
+        const float sample_rate = _gyro_raw_sample_rate(instance);
+        BiquadCoefficients sections[1+INS_MAX_NOTCHES];
+        // the low pass stays in section 0 so it keeps its state as
+        // notches come and go, passing through when disabled
+        if (!BiquadCoefficients::lowpass(sample_rate, _gyro_filter_cutoff(), sections[0])) {
+            sections[0] = {1, 0, 0, 0, 0};
+        }
+        const uint8_t count = 1 + _imu.gyro_fft.get_notches(sample_rate, &sections[1]);
+        _imu._gyro_filter[instance].set_sections(sections, count);
         _last_gyro_filter_hz[instance] = _gyro_filter_cutoff();
+        _last_gyro_notch_seq[instance] = _imu.gyro_fft.notch_seq();
     }
 }
 
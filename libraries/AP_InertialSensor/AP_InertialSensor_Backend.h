@@ -234,6 +234,7 @@ protected:
     // support for updating filter at runtime
     int8_t _last_accel_filter_hz[INS_MAX_INSTANCES];
     int8_t _last_gyro_filter_hz[INS_MAX_INSTANCES];
+    uint8_t _last_gyro_notch_seq[INS_MAX_INSTANCES];
 
     void set_gyro_orientation(uint8_t instance, enum Rotation rotation) {
         _imu._gyro_orientation[instance] = rotation;
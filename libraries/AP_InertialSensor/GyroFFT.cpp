@@ -0,0 +1,360 @@
+#include "AP_InertialSensor.h"
+#include <DataFlash/DataFlash.h>
+#include <GCS_MAVLink/GCS.h>
+
+extern const AP_HAL::HAL& hal;
+
+// a peak must stand this far above the mean power of the band
+#define FFT_PEAK_THRESHOLD      4.0f
+// how long to keep notches in place after their peaks are lost
+#define FFT_PEAK_HOLD_MS        1000
+// weight given to a new peak frequency
+#define FFT_PEAK_SMOOTHING      0.3f
+// notches are moved once a peak has moved this fraction of the
+// frequency the notch was placed at
+#define FFT_PEAK_MOVE_RATIO     0.02f
+// analysis rate in multiples of the highest frequency of interest
+#define FFT_OVERSAMPLING        2.5f
+// notches are kept below this fraction of the filter sample rate
+#define FFT_NOTCH_MAX_RATIO     0.45f
+// the deepest call chain of the thread, thread() -> run_frame() ->
+// find_peaks(), uses 272 bytes by -fstack-usage on SITL. This leaves
+// room for the scheduler delay and an exception frame. Nothing on the
+// thread may log or print
+#define FFT_THREAD_STACK        1024
+
+// Class level parameters
+const AP_Param::GroupInfo AP_InertialSensor::GyroFFT::var_info[] = {
+    // @Param: ENABLE
+    // @DisplayName: Gyro FFT enable
+    // @Description: Enable in-flight spectral analysis of the first gyro and placement of dynamic notch filters on the strongest vibration peaks
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO_FLAGS("ENABLE", 1, AP_InertialSensor::GyroFFT, _enable, 0, AP_PARAM_FLAG_ENABLE),
+
+    // @Param: WINDOW
+    // @DisplayName: FFT window size
+    // @Description: Number of samples in each FFT frame. Must be a power of two. Larger windows give finer frequency resolution at a higher cost per frame and a slower response
+    // @Values: 32:32,64:64,128:128,256:256,512:512
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("WINDOW", 2, AP_InertialSensor::GyroFFT, _window_size, 128),
+
+    // @Param: MINHZ
+    // @DisplayName: Minimum peak frequency
+    // @Description: Lowest frequency at which a vibration peak is tracked
+    // @Range: 10 400
+    // @Units: Hz
+    // @User: Advanced
+    AP_GROUPINFO("MINHZ", 3, AP_InertialSensor::GyroFFT, _min_hz, 50),
+
+    // @Param: MAXHZ
+    // @DisplayName: Maximum peak frequency
+    // @Description: Highest frequency at which a vibration peak is tracked. The gyro stream is decimated to about 2.5 times this frequency before analysis
+    // @Range: 20 1000
+    // @Units: Hz
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("MAXHZ", 4, AP_InertialSensor::GyroFFT, _max_hz, 450),
+
+    // @Param: PEAKS
+    // @DisplayName: Number of peaks
+    // @Description: Number of vibration peaks to track, each of which gets a notch filter
+    // @Range: 1 4
+    // @User: Advanced
+    AP_GROUPINFO("PEAKS", 5, AP_InertialSensor::GyroFFT, _num_peaks, 2),
+
+    // @Param: BW
+    // @DisplayName: Notch bandwidth
+    // @Description: Bandwidth of each dynamic notch as a percentage of its centre frequency
+    // @Range: 10 100
+    // @Units: %
+    // @User: Advanced
+    AP_GROUPINFO("BW", 6, AP_InertialSensor::GyroFFT, _bandwidth_pct, 40),
+
+    // @Param: ATT
+    // @DisplayName: Notch attenuation
+    // @Description: Attenuation of each dynamic notch at its centre frequency
+    // @Range: 5 50
+    // @Units: dB
+    // @User: Advanced
+    AP_GROUPINFO("ATT", 7, AP_InertialSensor::GyroFFT, _attenuation_dB, 15),
+
+    AP_GROUPEND
+};
+
+void AP_InertialSensor::GyroFFT::init()
+{
+    if (_enable == 0 || _imu.get_gyro_count() == 0) {
+        return;
+    }
+
+    const float raw_rate = _imu._gyro_raw_sample_rates[0];
+    const float max_hz = constrain_float(_max_hz, 20, 1000);
+    if (raw_rate < 2 * max_hz) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "FFT: gyro rate %.0fHz too low", (double)raw_rate);
+        return;
+    }
+    _decimation = MAX(1U, uint16_t(raw_rate / (FFT_OVERSAMPLING * max_hz)));
+    _sample_rate_hz = raw_rate / _decimation;
+
+    const uint16_t n = constrain_int16(_window_size, 32, 512);
+    if (!_fft.init(n)) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "FFT: bad window size %u", (unsigned)n);
+        return;
+    }
+    _hop = n / 2;
+
+    for (uint8_t axis=0; axis<3; axis++) {
+        _history[axis] = (float *)calloc(n, sizeof(float));
+    }
+    _frame = (float *)calloc(n, sizeof(float));
+    _power = (float *)calloc(n/2+1, sizeof(float));
+    _power_sum = (float *)calloc(n/2+1, sizeof(float));
+    _samples = new SPSCObjectBuffer<Vector3f>(n);
+    _peaks = new SPSCObjectBuffer<struct frame_result>(4);
+    if (_history[0] == nullptr || _history[1] == nullptr || _history[2] == nullptr ||
+        _frame == nullptr || _power == nullptr || _power_sum == nullptr ||
+        _samples == nullptr || _samples->get_size() != n ||
+        _peaks == nullptr || _peaks->get_size() != 4) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "FFT: failed to allocate buffers");
+        return;
+    }
+
+    if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_InertialSensor::GyroFFT::thread, void),
+                                      "FFT", FFT_THREAD_STACK, AP_HAL::Scheduler::PRIORITY_IO, 0)) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "FFT: failed to start thread");
+        return;
+    }
+    _running = true;
+    gcs().send_text(MAV_SEVERITY_INFO, "FFT: %u point at %.0fHz", (unsigned)n, (double)_sample_rate_hz);
+}
+
+/*
+  decimate the raw samples of the first gyro down to the analysis
+  rate with a boxcar average, which also acts as an anti-alias filter
+ */
+void AP_InertialSensor::GyroFFT::sample(uint8_t instance, const Vector3f &gyro)
+{
+    if (!_running || instance != 0) {
+        return;
+    }
+    _decimation_sum += gyro;
+    if (++_decimation_count < _decimation) {
+        return;
+    }
+    // if the FFT thread falls behind the sample is dropped
+    _samples->push(_decimation_sum / _decimation_count);
+    _decimation_sum.zero();
+    _decimation_count = 0;
+}
+
+void AP_InertialSensor::GyroFFT::thread()
+{
+    // poll at twice the rate at which frames become due
+    const uint32_t wait_ms = MAX(1U, uint32_t(500 * _hop / _sample_rate_hz));
+    while (true) {
+        if (!run_frame()) {
+            hal.scheduler->delay(wait_ms);
+        }
+    }
+}
+
+/*
+  collect new samples and, once half a window has arrived, analyse the
+  latest window. Frames overlap by half to make up for the Hann window
+ */
+bool AP_InertialSensor::GyroFFT::run_frame()
+{
+    const uint16_t n = _fft.size();
+    Vector3f v;
+    while (_new_samples < _hop && _samples->pop(v)) {
+        _history[0][_history_idx] = v.x;
+        _history[1][_history_idx] = v.y;
+        _history[2][_history_idx] = v.z;
+        _history_idx = (_history_idx + 1) % n;
+        _new_samples++;
+    }
+    if (_new_samples < _hop) {
+        return false;
+    }
+    _new_samples = 0;
+
+    const uint32_t start_us = AP_HAL::micros();
+
+    // sum the spectra of the three axes, oldest sample first
+    memset(_power_sum, 0, (n/2+1) * sizeof(float));
+    for (uint8_t axis=0; axis<3; axis++) {
+        const uint16_t tail = n - _history_idx;
+        memcpy(_frame, &_history[axis][_history_idx], tail * sizeof(float));
+        memcpy(&_frame[tail], _history[axis], _history_idx * sizeof(float));
+        _fft.power_spectrum(_frame, _power);
+        for (uint16_t k=0; k<=n/2; k++) {
+            _power_sum[k] += _power[k];
+        }
+    }
+
+    float freq_hz[INS_MAX_NOTCHES];
+    const uint8_t count = find_peaks(freq_hz);
+    const uint32_t now_ms = AP_HAL::millis();
+    if (count > 0) {
+        if (count == _tracked.count) {
+            for (uint8_t i=0; i<count; i++) {
+                _tracked.freq_hz[i] += FFT_PEAK_SMOOTHING * (freq_hz[i] - _tracked.freq_hz[i]);
+            }
+        } else {
+            memcpy(_tracked.freq_hz, freq_hz, sizeof(freq_hz));
+            _tracked.count = count;
+        }
+        _last_peak_ms = now_ms;
+    } else if (_tracked.count > 0 && now_ms - _last_peak_ms > FFT_PEAK_HOLD_MS) {
+        _tracked.count = 0;
+    }
+
+    // recomputing the notches costs the main thread, so small
+    // movements of a steady peak leave them where they are
+    bool changed = (_tracked.count != _notched.count);
+    for (uint8_t i=0; i<_tracked.count && !changed; i++) {
+        changed = fabsf(_tracked.freq_hz[i] - _notched.freq_hz[i]) > FFT_PEAK_MOVE_RATIO * _notched.freq_hz[i];
+    }
+    if (changed) {
+        _notched = _tracked;
+    }
+
+    const uint32_t cost_us = AP_HAL::micros() - start_us;
+    _frame_us_max = MAX(_frame_us_max, cost_us);
+    _frame_us_avg += 0.05f * (cost_us - _frame_us_avg);
+
+    // the main thread logs each frame. If it falls behind the frame
+    // is dropped, but a change of peaks is carried to the next one,
+    // which hands over the peaks the notches are placed at
+    _unsent_change |= changed;
+    if (_peaks->space() > 0) {
+        struct frame_result result;
+        result.peaks = _unsent_change ? _notched : _tracked;
+        result.changed = _unsent_change;
+        result.frame_us_avg = _frame_us_avg;
+        result.frame_us_max = _frame_us_max;
+        _peaks->push(result);
+        _unsent_change = false;
+    }
+    return true;
+}
+
+/*
+  find the strongest local maxima of the summed spectrum between
+  MINHZ and MAXHZ, refined by fitting a parabola through each peak
+  bin and its neighbours. Frequencies are returned in ascending order
+ */
+uint8_t AP_InertialSensor::GyroFFT::find_peaks(float *freq_hz)
+{
+    const uint16_t n = _fft.size();
+    const float bin_hz = _sample_rate_hz / n;
+    const uint16_t kmin = MAX(2, uint16_t(_min_hz / bin_hz));
+    const uint16_t kmax = MIN(n/2 - 1, uint16_t(_max_hz / bin_hz) + 1);
+    const uint8_t max_peaks = constrain_int16(_num_peaks, 1, INS_MAX_NOTCHES);
+    if (kmax <= kmin) {
+        return 0;
+    }
+
+    float mean = 0;
+    for (uint16_t k=kmin; k<=kmax; k++) {
+        mean += _power_sum[k];
+    }
+    mean /= (kmax - kmin + 1);
+    const float threshold = FFT_PEAK_THRESHOLD * mean;
+
+    // strongest peaks so far, in descending order of power
+    uint16_t bins[INS_MAX_NOTCHES];
+    uint8_t count = 0;
+    for (uint16_t k=kmin; k<=kmax; k++) {
+        const float p = _power_sum[k];
+        if (p <= threshold || p < _power_sum[k-1] || p <= _power_sum[k+1]) {
+            continue;
+        }
+        if (count == max_peaks && p <= _power_sum[bins[count-1]]) {
+            continue;
+        }
+        // insertion sort, dropping the weakest when full
+        uint8_t i = (count < max_peaks) ? count++ : count - 1;
+        for (; i > 0 && _power_sum[bins[i-1]] < p; i--) {
+            bins[i] = bins[i-1];
+        }
+        bins[i] = k;
+    }
+
+    for (uint8_t i=0; i<count; i++) {
+        const uint16_t k = bins[i];
+        const float a = _power_sum[k-1];
+        const float b = _power_sum[k];
+        const float c = _power_sum[k+1];
+        const float denom = a - 2 * b + c;
+        const float delta = is_zero(denom) ? 0 : constrain_float(0.5f * (a - c) / denom, -0.5f, 0.5f);
+        freq_hz[i] = (k + delta) * bin_hz;
+    }
+
+    // keep notch assignment stable as peaks swap in strength
+    for (uint8_t i=1; i<count; i++) {
+        const float f = freq_hz[i];
+        uint8_t j = i;
+        for (; j > 0 && freq_hz[j-1] > f; j--) {
+            freq_hz[j] = freq_hz[j-1];
+        }
+        freq_hz[j] = f;
+    }
+    return count;
+}
+
+void AP_InertialSensor::GyroFFT::update()
+{
+    if (!_running) {
+        return;
+    }
+    bool changed = false;
+    struct frame_result result;
+    while (_peaks->pop(result)) {
+        if (result.changed) {
+            _current = result.peaks;
+            changed = true;
+        }
+        Log_Write(result);
+    }
+    if (changed) {
+        _notch_seq++;
+    }
+}
+
+void AP_InertialSensor::GyroFFT::Log_Write(const struct frame_result &result) const
+{
+    DataFlash_Class *df = DataFlash_Class::instance();
+    if (df == nullptr) {
+        return;
+    }
+    const struct peaks &p = result.peaks;
+    df->Log_Write("FFT", "TimeUS,NPk,F1,F2,F3,F4,Cost,MaxCost", "QBffffII",
+                  AP_HAL::micros64(),
+                  p.count,
+                  (double)(p.count > 0 ? p.freq_hz[0] : 0),
+                  (double)(p.count > 1 ? p.freq_hz[1] : 0),
+                  (double)(p.count > 2 ? p.freq_hz[2] : 0),
+                  (double)(p.count > 3 ? p.freq_hz[3] : 0),
+                  (uint32_t)result.frame_us_avg,
+                  result.frame_us_max);
+}
+
+uint8_t AP_InertialSensor::GyroFFT::get_notches(float sample_freq_hz, BiquadCoefficients *coeffs) const
+{
+    uint8_t count = 0;
+    for (uint8_t i=0; i<_current.count; i++) {
+        const float centre = _current.freq_hz[i];
+        if (centre > FFT_NOTCH_MAX_RATIO * sample_freq_hz) {
+            continue;
+        }
+        const float bandwidth = centre * constrain_int16(_bandwidth_pct, 10, 100) * 0.01f;
+        if (BiquadCoefficients::notch(sample_freq_hz, centre, bandwidth, _attenuation_dB, coeffs[count])) {
+            count++;
+        }
+    }
+    return count;
+}
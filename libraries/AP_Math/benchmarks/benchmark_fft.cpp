@@ -0,0 +1,27 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/fft.h>
+
+// cost of one frame of the gyro spectrum, argument is the window size
+static void BM_RealFFTPowerSpectrum(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    RealFFT fft;
+    fft.init(n);
+
+    float samples[REAL_FFT_MAX_SIZE];
+    float power[REAL_FFT_MAX_SIZE/2+1];
+    for (uint16_t i=0; i<n; i++) {
+        samples[i] = sinf(0.37f * i) + 0.5f * cosf(1.9f * i);
+    }
+
+    while (state.KeepRunning()) {
+        fft.power_spectrum(samples, power);
+        gbenchmark_escape(power);
+    }
+}
+
+BENCHMARK(BM_RealFFTPowerSpectrum)->Arg(32)->Arg(128)->Arg(512);
+
+BENCHMARK_MAIN()
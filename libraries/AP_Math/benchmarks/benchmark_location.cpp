@@ -0,0 +1,64 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+#define NUM_LOCATIONS 64
+
+static void make_locations(Location &origin, Location *locs)
+{
+    origin = {};
+    origin.lat = -353632610;
+    origin.lng = 1491652300;
+    for (uint16_t i=0; i<NUM_LOCATIONS; i++) {
+        locs[i] = origin;
+        locs[i].lat += ((i * 7919) % 40000) - 20000;
+        locs[i].lng += ((i * 104729) % 60000) - 30000;
+    }
+}
+
+// offsets, distances and bearings of a list of locations one at a time
+static void BM_LocationSingle(benchmark::State& state)
+{
+    Location origin;
+    Location locs[NUM_LOCATIONS];
+    make_locations(origin, locs);
+    Vector2f ne[NUM_LOCATIONS];
+    float distance[NUM_LOCATIONS];
+    int32_t bearing[NUM_LOCATIONS];
+
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<NUM_LOCATIONS; i++) {
+            ne[i] = location_diff(origin, locs[i]);
+            distance[i] = get_distance(origin, locs[i]);
+            bearing[i] = get_bearing_cd(origin, locs[i]);
+        }
+        gbenchmark_escape(ne);
+        gbenchmark_escape(distance);
+        gbenchmark_escape(bearing);
+    }
+}
+
+// the same through one LocationOrigin
+static void BM_LocationOrigin(benchmark::State& state)
+{
+    Location origin;
+    Location locs[NUM_LOCATIONS];
+    make_locations(origin, locs);
+    Vector2f ne[NUM_LOCATIONS];
+    float distance[NUM_LOCATIONS];
+    int32_t bearing[NUM_LOCATIONS];
+
+    while (state.KeepRunning()) {
+        const LocationOrigin lo(origin);
+        lo.diff_ne(locs, NUM_LOCATIONS, ne);
+        lo.distance_bearing(locs, NUM_LOCATIONS, distance, bearing);
+        gbenchmark_escape(ne);
+        gbenchmark_escape(distance);
+        gbenchmark_escape(bearing);
+    }
+}
+
+BENCHMARK(BM_LocationSingle);
+BENCHMARK(BM_LocationOrigin);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,55 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+#define MAX_POINTS 1000
+
+// a closed star shaped polygon of n points in cm
+static void make_polygon(Vector2f *V, uint16_t n)
+{
+    for (uint16_t i=0; i<n-1; i++) {
+        const float angle = M_2PI * i / (n - 1);
+        const float radius = 50000 + 20000 * sinf(7 * angle);
+        V[i] = Vector2f(radius * cosf(angle), radius * sinf(angle));
+    }
+    V[n-1] = V[0];
+}
+
+static Vector2f test_point(uint32_t i)
+{
+    return Vector2f(((i * 7919) % 120000) - 60000.0f, ((i * 104729) % 120000) - 60000.0f);
+}
+
+static void BM_PolygonOutside(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    static Vector2f V[MAX_POINTS];
+    make_polygon(V, n);
+
+    uint32_t i = 0;
+    while (state.KeepRunning()) {
+        bool outside = Polygon_outside(test_point(i++), V, n);
+        gbenchmark_escape(&outside);
+    }
+}
+
+static void BM_PolygonIndexOutside(benchmark::State& state)
+{
+    const uint16_t n = state.range(0);
+    static Vector2f V[MAX_POINTS];
+    make_polygon(V, n);
+    PolygonIndex index;
+    index.build(V, n);
+
+    uint32_t i = 0;
+    while (state.KeepRunning()) {
+        bool outside = index.outside(test_point(i++));
+        gbenchmark_escape(&outside);
+    }
+}
+
+// argument is the number of polygon points
+BENCHMARK(BM_PolygonOutside)->Arg(16)->Arg(100)->Arg(1000);
+BENCHMARK(BM_PolygonIndexOutside)->Arg(16)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,156 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fft.h"
+#include "AP_Math.h"
+
+#include <stdlib.h>
+
+RealFFT::~RealFFT()
+{
+    free(_window);
+    free(_cos);
+    free(_sin);
+    free(_re);
+    free(_im);
+}
+
+bool RealFFT::init(uint16_t n)
+{
+    if (n < REAL_FFT_MIN_SIZE || n > REAL_FFT_MAX_SIZE || (n & (n - 1)) != 0) {
+        return false;
+    }
+    if (n == _n) {
+        return true;
+    }
+
+    free(_window);
+    free(_cos);
+    free(_sin);
+    free(_re);
+    free(_im);
+    _n = 0;
+
+    const uint16_t half = n / 2;
+    _window = (float *)calloc(n, sizeof(float));
+    _cos = (float *)calloc(half, sizeof(float));
+    _sin = (float *)calloc(half, sizeof(float));
+    _re = (float *)calloc(half, sizeof(float));
+    _im = (float *)calloc(half, sizeof(float));
+    if (_window == nullptr || _cos == nullptr || _sin == nullptr ||
+        _re == nullptr || _im == nullptr) {
+        return false;
+    }
+
+    for (uint16_t i=0; i<n; i++) {
+        // periodic Hann window
+        _window[i] = 0.5f * (1.0f - cosf(M_2PI * i / n));
+    }
+    for (uint16_t k=0; k<half; k++) {
+        _cos[k] = cosf(M_2PI * k / n);
+        _sin[k] = sinf(M_2PI * k / n);
+    }
+    _n = n;
+    return true;
+}
+
+/*
+  in-place radix-2 decimation in time FFT of the n/2 values in _re
+  and _im. The twiddle for a butterfly span of len is every
+  (n/len)'th entry of the table for n
+ */
+void RealFFT::complex_fft(void)
+{
+    const uint16_t m = _n / 2;
+
+    // bit reversal permutation
+    for (uint16_t i=1, j=0; i<m; i++) {
+        uint16_t bit = m >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float t = _re[i]; _re[i] = _re[j]; _re[j] = t;
+            t = _im[i]; _im[i] = _im[j]; _im[j] = t;
+        }
+    }
+
+    for (uint16_t len=2; len<=m; len <<= 1) {
+        const uint16_t step = _n / len;
+        const uint16_t span = len / 2;
+        for (uint16_t i=0; i<m; i+=len) {
+            for (uint16_t j=0; j<span; j++) {
+                const float wr = _cos[j * step];
+                const float wi = -_sin[j * step];
+                const uint16_t a = i + j;
+                const uint16_t b = a + span;
+                const float tr = _re[b] * wr - _im[b] * wi;
+                const float ti = _re[b] * wi + _im[b] * wr;
+                _re[b] = _re[a] - tr;
+                _im[b] = _im[a] - ti;
+                _re[a] += tr;
+                _im[a] += ti;
+            }
+        }
+    }
+}
+
+void RealFFT::power_spectrum(const float *samples, float *power)
+{
+    if (_n == 0) {
+        return;
+    }
+    const uint16_t m = _n / 2;
+
+    // even samples are the real part, odd samples the imaginary part
+    for (uint16_t k=0; k<m; k++) {
+        _re[k] = samples[2*k] * _window[2*k];
+        _im[k] = samples[2*k+1] * _window[2*k+1];
+    }
+
+    complex_fft();
+
+    /*
+      split the half length transform Z into the full one:
+        X[k] = (Z[k] + conj(Z[m-k]))/2 - i W^k (Z[k] - conj(Z[m-k]))/2
+      with W = exp(-2 pi i / n)
+     */
+    for (uint16_t k=0; k<=m; k++) {
+        const uint16_t k1 = (k == m) ? 0 : k;
+        const uint16_t k2 = (k == 0) ? 0 : m - k;
+        const float a = _re[k1];
+        const float b = _im[k1];
+        const float c = _re[k2];
+        const float d = _im[k2];
+
+        const float er = 0.5f * (a + c);
+        const float ei = 0.5f * (b - d);
+        const float odd_r = 0.5f * (b + d);
+        const float odd_i = -0.5f * (a - c);
+
+        float wr, wi;
+        if (k < m) {
+            wr = _cos[k];
+            wi = -_sin[k];
+        } else {
+            wr = -1;
+            wi = 0;
+        }
+        const float xr = er + wr * odd_r - wi * odd_i;
+        const float xi = ei + wr * odd_i + wi * odd_r;
+        power[k] = xr * xr + xi * xi;
+    }
+}
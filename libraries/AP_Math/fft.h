@@ -0,0 +1,70 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#define REAL_FFT_MIN_SIZE 8
+#define REAL_FFT_MAX_SIZE 1024
+
+/*
+  FFT of a power of two number of real samples, with a Hann window.
+
+  The transform packs the samples into a complex sequence of half the
+  length, runs a radix-2 complex FFT on that and splits the result,
+  so it costs about half of a complex transform of the same size. All
+  buffers are allocated in init() and a transform does no allocation
+ */
+class RealFFT {
+public:
+    RealFFT() :
+        _n(0),
+        _window(nullptr),
+        _cos(nullptr),
+        _sin(nullptr),
+        _re(nullptr),
+        _im(nullptr)
+    {}
+    ~RealFFT();
+
+    /* Do not allow copies */
+    RealFFT(const RealFFT &other) = delete;
+    RealFFT &operator=(const RealFFT&) = delete;
+
+    // n must be a power of two between REAL_FFT_MIN_SIZE and
+    // REAL_FFT_MAX_SIZE. Returns false on a bad size or no memory
+    bool init(uint16_t n);
+
+    // number of samples per transform, zero before init()
+    uint16_t size(void) const { return _n; }
+
+    /*
+      fill power[0..n/2] with the squared magnitude of each frequency
+      bin of the n windowed samples. Bin k is at k * sample_rate / n
+     */
+    void power_spectrum(const float *samples, float *power);
+
+private:
+    void complex_fft(void);
+
+    uint16_t _n;
+    float *_window;
+    // cos and sin of 2*pi*k/n for k < n/2
+    float *_cos;
+    float *_sin;
+    // n/2 complex values being transformed
+    float *_re;
+    float *_im;
+};
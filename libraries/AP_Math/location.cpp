@@ -155,6 +155,50 @@ Vector3f location_3d_diff_NED(const struct Location &loc1, const struct Location
                     (loc1.alt - loc2.alt) * 0.01f);
 }
 
+LocationOrigin::LocationOrigin(const struct Location &origin) :
+    _lat(origin.lat),
+    _lng(origin.lng),
+    _alt(origin.alt),
+    _lng_factor(LOCATION_SCALING_FACTOR * longitude_scale(origin))
+{
+}
+
+Vector3f LocationOrigin::diff_ned(const struct Location &loc) const
+{
+    const Vector2f ne = diff_ne(loc);
+    return Vector3f(ne.x, ne.y, (_alt - loc.alt) * 0.01f);
+}
+
+int32_t LocationOrigin::get_bearing_cd(const struct Location &loc) const
+{
+    const Vector2f ne = diff_ne(loc);
+    int32_t bearing = atan2f(ne.y, ne.x) * DEGX100;
+    if (bearing < 0) {
+        bearing += 36000;
+    }
+    return bearing;
+}
+
+void LocationOrigin::diff_ne(const struct Location *locs, uint16_t count, Vector2f *ne) const
+{
+    for (uint16_t i=0; i<count; i++) {
+        ne[i] = diff_ne(locs[i].lat, locs[i].lng);
+    }
+}
+
+void LocationOrigin::distance_bearing(const struct Location *locs, uint16_t count,
+                                      float *distance, int32_t *bearing_cd) const
+{
+    for (uint16_t i=0; i<count; i++) {
+        if (distance != nullptr) {
+            distance[i] = get_distance(locs[i]);
+        }
+        if (bearing_cd != nullptr) {
+            bearing_cd[i] = get_bearing_cd(locs[i]);
+        }
+    }
+}
+
 /*
   return true if lat and lng match. Ignores altitude and options
  */
@@ -71,6 +71,54 @@ Vector2f    location_diff(const struct Location &loc1, const struct Location &lo
  */
 Vector3f    location_3d_diff_NED(const struct Location &loc1, const struct Location &loc2);
 
+/*
+  offsets, distances and bearings of many locations from one origin.
+  The longitude scale of the origin is computed once, so each location
+  costs only a few multiplies. Like location_diff() all results use
+  the longitude scale of the origin
+ */
+class LocationOrigin {
+public:
+    LocationOrigin(const struct Location &origin);
+
+    // N/E offset in meters from the origin to lat/lng
+    Vector2f diff_ne(int32_t lat, int32_t lng) const {
+        return Vector2f((lat - _lat) * LOCATION_SCALING_FACTOR,
+                        (lng - _lng) * _lng_factor);
+    }
+
+    // as location_diff(origin, loc)
+    Vector2f diff_ne(const struct Location &loc) const {
+        return diff_ne(loc.lat, loc.lng);
+    }
+
+    // as location_3d_diff_NED(origin, loc)
+    Vector3f diff_ned(const struct Location &loc) const;
+
+    // horizontal distance in meters from the origin to loc
+    float get_distance(const struct Location &loc) const {
+        return diff_ne(loc).length();
+    }
+
+    // bearing in centi-degrees from the origin to loc
+    int32_t get_bearing_cd(const struct Location &loc) const;
+
+    // fill ne[0..count-1] with the offsets of locs
+    void diff_ne(const struct Location *locs, uint16_t count, Vector2f *ne) const;
+
+    // fill in the distance in meters and bearing in centi-degrees of
+    // each of locs. Either output may be nullptr
+    void distance_bearing(const struct Location *locs, uint16_t count,
+                          float *distance, int32_t *bearing_cd) const;
+
+private:
+    int32_t _lat;
+    int32_t _lng;
+    int32_t _alt;
+    // LOCATION_SCALING_FACTOR times the longitude scale of the origin
+    float _lng_factor;
+};
+
 /*
  * check if lat and lng match. Ignore altitude and options
  */
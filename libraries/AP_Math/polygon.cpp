@@ -36,42 +36,51 @@
  *  expect that to be very small over the distances involved in the
  *  fence boundary
  */
+/*
+  return true if the edge from Vj to Vi crosses the ray from P towards
+  positive x
+ */
+template <typename T>
+static inline bool Polygon_edge_crosses(const Vector2<T> &P, const Vector2<T> &Vi, const Vector2<T> &Vj)
+{
+    if ((Vi.y > P.y) == (Vj.y > P.y)) {
+        return false;
+    }
+    const int32_t dx1 = P.x - Vi.x;
+    const int32_t dx2 = Vj.x - Vi.x;
+    const int32_t dy1 = P.y - Vi.y;
+    const int32_t dy2 = Vj.y - Vi.y;
+    const int8_t dx1s = (dx1 < 0) ? -1 : 1;
+    const int8_t dx2s = (dx2 < 0) ? -1 : 1;
+    const int8_t dy1s = (dy1 < 0) ? -1 : 1;
+    const int8_t dy2s = (dy2 < 0) ? -1 : 1;
+    const int8_t m1 = dx1s * dy2s;
+    const int8_t m2 = dx2s * dy1s;
+    // we avoid the 64 bit multiplies if we can based on sign checks.
+    if (dy2 < 0) {
+        if (m1 > m2) {
+            return true;
+        } else if (m1 < m2) {
+            return false;
+        }
+        return dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1;
+    }
+    if (m1 < m2) {
+        return true;
+    } else if (m1 > m2) {
+        return false;
+    }
+    return dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1;
+}
+
 template <typename T>
 bool Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n)
 {
     unsigned i, j;
     bool outside = true;
     for (i = 0, j = n-1; i < n; j = i++) {
-        if ((V[i].y > P.y) == (V[j].y > P.y)) {
-            continue;
-        }
-        const int32_t dx1 = P.x - V[i].x;
-        const int32_t dx2 = V[j].x - V[i].x;
-        const int32_t dy1 = P.y - V[i].y;
-        const int32_t dy2 = V[j].y - V[i].y;
-        const int8_t dx1s = (dx1 < 0) ? -1 : 1;
-        const int8_t dx2s = (dx2 < 0) ? -1 : 1;
-        const int8_t dy1s = (dy1 < 0) ? -1 : 1;
-        const int8_t dy2s = (dy2 < 0) ? -1 : 1;
-        const int8_t m1 = dx1s * dy2s;
-        const int8_t m2 = dx2s * dy1s;
-        // we avoid the 64 bit multiplies if we can based on sign checks.
-        if (dy2 < 0) {
-            if (m1 > m2) {
-                outside = !outside;
-            } else if (m1 < m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 > dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
-        } else {
-            if (m1 < m2) {
-                outside = !outside;
-            } else if (m1 > m2) {
-                continue;
-            } else if ( dx1 * (int64_t)dy2 < dx2 * (int64_t)dy1 ) {
-                outside = !outside;
-            }
+        if (Polygon_edge_crosses(P, V[i], V[j])) {
+            outside = !outside;
         }
     }
     return outside;
@@ -95,3 +104,275 @@ template bool Polygon_outside<int32_t>(const Vector2l &P, const Vector2l *V, uns
 template bool Polygon_complete<int32_t>(const Vector2l *V, unsigned n);
 template bool Polygon_outside<float>(const Vector2f &P, const Vector2f *V, unsigned n);
 template bool Polygon_complete<float>(const Vector2f *V, unsigned n);
+
+PolygonIndex::~PolygonIndex()
+{
+    clear();
+}
+
+void PolygonIndex::clear()
+{
+    free(_cell_start);
+    free(_cell_edges);
+    _cell_start = nullptr;
+    _cell_edges = nullptr;
+    _points = nullptr;
+    _n = 0;
+}
+
+uint8_t PolygonIndex::cell_x(float x) const
+{
+    const float c = (x - _min.x) * _inv_cell_size.x;
+    if (c <= 0) {
+        return 0;
+    }
+    if (c >= _cells_x - 1) {
+        return _cells_x - 1;
+    }
+    return uint8_t(c);
+}
+
+uint8_t PolygonIndex::cell_y(float y) const
+{
+    const float c = (y - _min.y) * _inv_cell_size.y;
+    if (c <= 0) {
+        return 0;
+    }
+    if (c >= _cells_y - 1) {
+        return _cells_y - 1;
+    }
+    return uint8_t(c);
+}
+
+bool PolygonIndex::build(const Vector2f *V, uint16_t n)
+{
+    clear();
+    if (V == nullptr || n == 0) {
+        return false;
+    }
+
+    _min = V[0];
+    _max = V[0];
+    for (uint16_t i=1; i<n; i++) {
+        _min.x = MIN(_min.x, V[i].x);
+        _min.y = MIN(_min.y, V[i].y);
+        _max.x = MAX(_max.x, V[i].x);
+        _max.y = MAX(_max.y, V[i].y);
+    }
+
+    // about one edge per cell, with cells roughly square
+    const Vector2f size = _max - _min;
+    float cells_x = 1, cells_y = 1;
+    if (size.x > 0 && size.y > 0) {
+        cells_x = sqrtf(n * size.x / size.y);
+        cells_y = sqrtf(n * size.y / size.x);
+    } else if (size.x > 0) {
+        cells_x = n;
+    } else if (size.y > 0) {
+        cells_y = n;
+    }
+    _cells_x = constrain_float(cells_x + 0.5f, 1, POLYGON_INDEX_MAX_CELLS);
+    _cells_y = constrain_float(cells_y + 0.5f, 1, POLYGON_INDEX_MAX_CELLS);
+    _inv_cell_size.x = (size.x > 0) ? _cells_x / size.x : 0;
+    _inv_cell_size.y = (size.y > 0) ? _cells_y / size.y : 0;
+    _n = n;
+
+    const uint16_t num_cells = _cells_x * _cells_y;
+    _cell_start = (uint16_t *)calloc(num_cells + 1, sizeof(uint16_t));
+    if (_cell_start == nullptr) {
+        clear();
+        return false;
+    }
+
+    // count the edges in each cell, using edge_start() before _points
+    // is set to mark the index valid
+    _points = V;
+    uint32_t total = 0;
+    for (uint16_t i=0; i<n; i++) {
+        const Vector2f &a = edge_start(i);
+        const Vector2f &b = edge_end(i);
+        const uint8_t x0 = cell_x(MIN(a.x, b.x)), x1 = cell_x(MAX(a.x, b.x));
+        const uint8_t y0 = cell_y(MIN(a.y, b.y)), y1 = cell_y(MAX(a.y, b.y));
+        for (uint8_t y=y0; y<=y1; y++) {
+            for (uint8_t x=x0; x<=x1; x++) {
+                _cell_start[cell(x, y)]++;
+            }
+        }
+        total += (x1 - x0 + 1) * (y1 - y0 + 1);
+    }
+    if (total > UINT16_MAX) {
+        clear();
+        return false;
+    }
+    _cell_edges = (uint16_t *)calloc(total, sizeof(uint16_t));
+    if (_cell_edges == nullptr) {
+        clear();
+        return false;
+    }
+
+    // turn counts into the end of each cell's run, then fill each run
+    // backwards so that it ends up starting at _cell_start
+    for (uint16_t c=1; c<=num_cells; c++) {
+        _cell_start[c] += _cell_start[c-1];
+    }
+    for (uint16_t i=n; i>0; i--) {
+        const Vector2f &a = edge_start(i-1);
+        const Vector2f &b = edge_end(i-1);
+        const uint8_t x0 = cell_x(MIN(a.x, b.x)), x1 = cell_x(MAX(a.x, b.x));
+        const uint8_t y0 = cell_y(MIN(a.y, b.y)), y1 = cell_y(MAX(a.y, b.y));
+        for (uint8_t y=y0; y<=y1; y++) {
+            for (uint8_t x=x0; x<=x1; x++) {
+                _cell_edges[--_cell_start[cell(x, y)]] = i-1;
+            }
+        }
+    }
+    return true;
+}
+
+bool PolygonIndex::edge_in_box(uint16_t i, const Vector2f &min, const Vector2f &max) const
+{
+    const Vector2f &a = edge_start(i);
+    const Vector2f &b = edge_end(i);
+    return MIN(a.x, b.x) <= max.x && MAX(a.x, b.x) >= min.x &&
+           MIN(a.y, b.y) <= max.y && MAX(a.y, b.y) >= min.y;
+}
+
+bool PolygonIndex::outside(const Vector2f &P) const
+{
+    if (!valid() ||
+        P.x < _min.x || P.x > _max.x ||
+        P.y < _min.y || P.y > _max.y) {
+        return true;
+    }
+    if (_n < POLYGON_INDEX_MIN_POINTS) {
+        // a plain scan is quicker for small polygons
+        return Polygon_outside(P, _points, _n);
+    }
+    // only edges reaching the ray from P towards positive x can cross it
+    bool outside = true;
+    BoxQuery query(*this, P, Vector2f(_max.x, P.y));
+    uint16_t i;
+    while (query.next(i)) {
+        if (Polygon_edge_crosses(P, edge_end(i), edge_start(i))) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+/*
+  search rings of cells outwards from the cell of P until the closest
+  edge found is nearer than anything outside the rings searched
+ */
+float PolygonIndex::closest_edge(const Vector2f &P, uint16_t &edge) const
+{
+    if (!valid()) {
+        return -1;
+    }
+    const int16_t cx = cell_x(P.x);
+    const int16_t cy = cell_y(P.y);
+    const float cell_w = (_inv_cell_size.x > 0) ? 1 / _inv_cell_size.x : 0;
+    const float cell_h = (_inv_cell_size.y > 0) ? 1 / _inv_cell_size.y : 0;
+    float best_sq = -1;
+
+    for (int16_t r=0; ; r++) {
+        for (int16_t y=MAX(cy-r, 0); y<=MIN(cy+r, _cells_y-1); y++) {
+            for (int16_t x=MAX(cx-r, 0); x<=MIN(cx+r, _cells_x-1); x++) {
+                if (abs(x - cx) != r && abs(y - cy) != r) {
+                    // searched in an earlier ring
+                    continue;
+                }
+                const uint16_t c = cell(x, y);
+                for (uint16_t k=_cell_start[c]; k<_cell_start[c+1]; k++) {
+                    const uint16_t i = _cell_edges[k];
+                    const float d_sq = (Vector2f::closest_point(P, edge_start(i), edge_end(i)) - P).length_squared();
+                    if (best_sq < 0 || d_sq < best_sq) {
+                        best_sq = d_sq;
+                        edge = i;
+                    }
+                }
+            }
+        }
+
+        // distance from P to the nearest cell not yet searched
+        float reach = -1;
+        if (cx - r > 0) {
+            reach = P.x - (_min.x + (cx - r) * cell_w);
+        }
+        if (cx + r + 1 < _cells_x) {
+            const float d = _min.x + (cx + r + 1) * cell_w - P.x;
+            reach = (reach < 0) ? d : MIN(reach, d);
+        }
+        if (cy - r > 0) {
+            const float d = P.y - (_min.y + (cy - r) * cell_h);
+            reach = (reach < 0) ? d : MIN(reach, d);
+        }
+        if (cy + r + 1 < _cells_y) {
+            const float d = _min.y + (cy + r + 1) * cell_h - P.y;
+            reach = (reach < 0) ? d : MIN(reach, d);
+        }
+        if (reach < 0) {
+            // the whole grid has been searched
+            break;
+        }
+        if (best_sq >= 0 && best_sq <= sq(reach)) {
+            break;
+        }
+    }
+    return (best_sq < 0) ? -1 : sqrtf(best_sq);
+}
+
+PolygonIndex::BoxQuery::BoxQuery(const PolygonIndex &index, const Vector2f &min, const Vector2f &max) :
+    _index(index),
+    _min(min),
+    _max(max)
+{
+    if (!index.valid() ||
+        max.x < index._min.x || min.x > index._max.x ||
+        max.y < index._min.y || min.y > index._max.y) {
+        // nothing to report
+        _x0 = _x1 = _cx = 0;
+        _y0 = _y1 = _cy = 0;
+        _pos = _end = 0;
+        return;
+    }
+    _x0 = _cx = index.cell_x(min.x);
+    _x1 = index.cell_x(max.x);
+    _y0 = _cy = index.cell_y(min.y);
+    _y1 = index.cell_y(max.y);
+    const uint16_t c = index.cell(_cx, _cy);
+    _pos = index._cell_start[c];
+    _end = index._cell_start[c+1];
+}
+
+bool PolygonIndex::BoxQuery::next(uint16_t &edge)
+{
+    while (true) {
+        while (_pos < _end) {
+            const uint16_t i = _index._cell_edges[_pos++];
+            if (!_index.edge_in_box(i, _min, _max)) {
+                continue;
+            }
+            // an edge is listed in every cell its bounding box touches,
+            // so only report it from the first of those in the query
+            const Vector2f &a = _index.edge_start(i);
+            const Vector2f &b = _index.edge_end(i);
+            if (_cx == MAX(_x0, _index.cell_x(MIN(a.x, b.x))) &&
+                _cy == MAX(_y0, _index.cell_y(MIN(a.y, b.y)))) {
+                edge = i;
+                return true;
+            }
+        }
+        if (_cx < _x1) {
+            _cx++;
+        } else if (_cy < _y1) {
+            _cx = _x0;
+            _cy++;
+        } else {
+            return false;
+        }
+        const uint16_t c = _index.cell(_cx, _cy);
+        _pos = _index._cell_start[c];
+        _end = _index._cell_start[c+1];
+    }
+}
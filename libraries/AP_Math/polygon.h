@@ -24,3 +24,84 @@ bool        Polygon_outside(const Vector2<T> &P, const Vector2<T> *V, unsigned n
 template <typename T>
 bool        Polygon_complete(const Vector2<T> *V, unsigned n);
 
+
+#define POLYGON_INDEX_MAX_CELLS 32
+// outside() scans every edge of polygons smaller than this
+#define POLYGON_INDEX_MIN_POINTS 32
+
+/*
+  a uniform grid over the bounding box of a polygon, with each cell
+  listing the edges whose bounding boxes overlap it. Built once when
+  the polygon changes, it lets a point test or an edge search look at
+  the few edges near the query instead of every edge.
+
+  Edge i runs from V[i-1] to V[i], with edge 0 closing the polygon
+  from V[n-1] to V[0], the same pairs Polygon_outside() tests
+ */
+class PolygonIndex {
+public:
+    PolygonIndex() {}
+    ~PolygonIndex();
+
+    /* Do not allow copies */
+    PolygonIndex(const PolygonIndex &other) = delete;
+    PolygonIndex &operator=(const PolygonIndex&) = delete;
+
+    // index the n points of V, which must stay unchanged until the
+    // next build() or clear(). Returns false if out of memory
+    bool build(const Vector2f *V, uint16_t n);
+    void clear();
+
+    // true if build() succeeded
+    bool valid() const { return _points != nullptr; }
+
+    // same result as Polygon_outside(P, V, n)
+    bool outside(const Vector2f &P) const;
+
+    // distance from P to the closest edge, which is returned in edge.
+    // Edges are numbered over the points given to build(), so for a
+    // fence indexed without its return point edge 0 ends at the first
+    // vertex after it. Returns a negative distance if there are no edges
+    float closest_edge(const Vector2f &P, uint16_t &edge) const;
+
+    const Vector2f &edge_start(uint16_t i) const { return _points[(i == 0) ? _n - 1 : i - 1]; }
+    const Vector2f &edge_end(uint16_t i) const { return _points[i]; }
+
+    /*
+      iterate over each edge whose bounding box overlaps the box from
+      min to max exactly once, in no particular order
+     */
+    class BoxQuery {
+    public:
+        BoxQuery(const PolygonIndex &index, const Vector2f &min, const Vector2f &max);
+
+        // get the next edge, returning false when there are no more
+        bool next(uint16_t &edge);
+
+    private:
+        const PolygonIndex &_index;
+        Vector2f _min;
+        Vector2f _max;
+        uint8_t _x0, _x1, _y0, _y1;
+        uint8_t _cx, _cy;
+        uint16_t _pos;
+        uint16_t _end;
+    };
+
+private:
+    uint8_t cell_x(float x) const;
+    uint8_t cell_y(float y) const;
+    uint16_t cell(uint8_t x, uint8_t y) const { return y * _cells_x + x; }
+    bool edge_in_box(uint16_t i, const Vector2f &min, const Vector2f &max) const;
+
+    const Vector2f *_points = nullptr;
+    uint16_t _n;
+    Vector2f _min;
+    Vector2f _max;
+    uint8_t _cells_x;
+    uint8_t _cells_y;
+    Vector2f _inv_cell_size;
+    // edges of cell c are _cell_edges[_cell_start[c].._cell_start[c+1]-1]
+    uint16_t *_cell_start = nullptr;
+    uint16_t *_cell_edges = nullptr;
+};
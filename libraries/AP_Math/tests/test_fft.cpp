@@ -0,0 +1,83 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/fft.h>
+
+// windowed power spectrum by direct evaluation of the DFT
+static void dft_power(const float *samples, uint16_t n, float *power)
+{
+    for (uint16_t k=0; k<=n/2; k++) {
+        double re = 0, im = 0;
+        for (uint16_t i=0; i<n; i++) {
+            const double w = 0.5 * (1 - cos(2 * M_PI * i / n));
+            re += w * samples[i] * cos(2 * M_PI * k * i / n);
+            im -= w * samples[i] * sin(2 * M_PI * k * i / n);
+        }
+        power[k] = re * re + im * im;
+    }
+}
+
+static void check_against_dft(uint16_t n)
+{
+    RealFFT fft;
+    ASSERT_TRUE(fft.init(n));
+    EXPECT_EQ(n, fft.size());
+
+    float samples[REAL_FFT_MAX_SIZE];
+    for (uint16_t i=0; i<n; i++) {
+        samples[i] = sinf(0.37f * i) + 0.5f * cosf(1.9f * i + 0.3f) + ((i * 37) % 11) * 0.05f;
+    }
+    float expected[REAL_FFT_MAX_SIZE/2+1];
+    float power[REAL_FFT_MAX_SIZE/2+1];
+    dft_power(samples, n, expected);
+    fft.power_spectrum(samples, power);
+
+    for (uint16_t k=0; k<=n/2; k++) {
+        EXPECT_NEAR(expected[k], power[k], 1.0e-3f * (1 + expected[k])) << "n=" << n << " bin=" << k;
+    }
+}
+
+TEST(RealFFT, MatchesDFT)
+{
+    check_against_dft(8);
+    check_against_dft(16);
+    check_against_dft(64);
+    check_against_dft(256);
+    check_against_dft(1024);
+}
+
+TEST(RealFFT, FindsTone)
+{
+    const uint16_t n = 128;
+    const float sample_rate = 1000;
+    RealFFT fft;
+    ASSERT_TRUE(fft.init(n));
+
+    float samples[n];
+    float power[n/2+1];
+    for (uint16_t bin=3; bin<n/2-1; bin+=7) {
+        for (uint16_t i=0; i<n; i++) {
+            samples[i] = 0.2f + sinf(M_2PI * (bin * sample_rate / n) * i / sample_rate);
+        }
+        fft.power_spectrum(samples, power);
+        uint16_t peak = 1;
+        for (uint16_t k=2; k<=n/2; k++) {
+            if (power[k] > power[peak]) {
+                peak = k;
+            }
+        }
+        EXPECT_EQ(bin, peak);
+    }
+}
+
+TEST(RealFFT, BadSize)
+{
+    RealFFT fft;
+    EXPECT_FALSE(fft.init(0));
+    EXPECT_FALSE(fft.init(4));
+    EXPECT_FALSE(fft.init(100));
+    EXPECT_FALSE(fft.init(2048));
+    EXPECT_EQ(0, fft.size());
+}
+
+AP_GTEST_MAIN()
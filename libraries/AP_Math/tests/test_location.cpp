@@ -0,0 +1,100 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+#define NUM_LOCATIONS 50
+
+// a spread of points within a few km of the origin
+static void make_locations(const Location &origin, Location *locs)
+{
+    for (uint16_t i=0; i<NUM_LOCATIONS; i++) {
+        locs[i] = origin;
+        locs[i].lat += ((i * 7919) % 40000) - 20000;
+        locs[i].lng += ((i * 104729) % 60000) - 30000;
+        locs[i].alt += i * 100;
+    }
+}
+
+TEST(LocationOrigin, MatchesLocationDiff)
+{
+    Location origin {};
+    origin.lat = -353632610;
+    origin.lng = 1491652300;
+    origin.alt = 58400;
+    Location locs[NUM_LOCATIONS];
+    make_locations(origin, locs);
+
+    const LocationOrigin lo(origin);
+    Vector2f ne[NUM_LOCATIONS];
+    lo.diff_ne(locs, NUM_LOCATIONS, ne);
+    for (uint16_t i=0; i<NUM_LOCATIONS; i++) {
+        const Vector2f expected = location_diff(origin, locs[i]);
+        EXPECT_FLOAT_EQ(expected.x, ne[i].x);
+        EXPECT_FLOAT_EQ(expected.y, ne[i].y);
+
+        const Vector3f ned = lo.diff_ned(locs[i]);
+        const Vector3f expected_ned = location_3d_diff_NED(origin, locs[i]);
+        EXPECT_FLOAT_EQ(expected_ned.x, ned.x);
+        EXPECT_FLOAT_EQ(expected_ned.y, ned.y);
+        EXPECT_FLOAT_EQ(expected_ned.z, ned.z);
+    }
+}
+
+TEST(LocationOrigin, DistanceAndBearing)
+{
+    Location origin {};
+    origin.lat = 474000000;
+    origin.lng = 85000000;
+    Location locs[NUM_LOCATIONS];
+    make_locations(origin, locs);
+
+    const LocationOrigin lo(origin);
+    float distance[NUM_LOCATIONS];
+    int32_t bearing[NUM_LOCATIONS];
+    lo.distance_bearing(locs, NUM_LOCATIONS, distance, bearing);
+    for (uint16_t i=0; i<NUM_LOCATIONS; i++) {
+        // the single location helpers use the longitude scale of the
+        // target rather than the origin, which differs slightly
+        const float expected = get_distance(origin, locs[i]);
+        EXPECT_NEAR(expected, distance[i], 1.0e-3f * expected + 0.01f);
+        EXPECT_FLOAT_EQ(lo.get_distance(locs[i]), distance[i]);
+
+        int32_t error = bearing[i] - get_bearing_cd(origin, locs[i]);
+        if (error > 18000) {
+            error -= 36000;
+        } else if (error < -18000) {
+            error += 36000;
+        }
+        EXPECT_LE(abs(error), 5);
+        EXPECT_EQ(lo.get_bearing_cd(locs[i]), bearing[i]);
+        EXPECT_GE(bearing[i], 0);
+        EXPECT_LT(bearing[i], 36000);
+    }
+
+    // either output may be omitted
+    lo.distance_bearing(locs, NUM_LOCATIONS, nullptr, bearing);
+    lo.distance_bearing(locs, NUM_LOCATIONS, distance, nullptr);
+}
+
+TEST(LocationOrigin, CardinalBearings)
+{
+    Location origin {};
+    origin.lat = 100000000;
+    origin.lng = 200000000;
+    const LocationOrigin lo(origin);
+
+    Location loc = origin;
+    loc.lat += 1000;
+    EXPECT_EQ(0, lo.get_bearing_cd(loc));
+    loc = origin;
+    loc.lng += 1000;
+    EXPECT_EQ(9000, lo.get_bearing_cd(loc));
+    loc = origin;
+    loc.lat -= 1000;
+    EXPECT_EQ(18000, lo.get_bearing_cd(loc));
+    loc = origin;
+    loc.lng -= 1000;
+    EXPECT_EQ(27000, lo.get_bearing_cd(loc));
+}
+
+AP_GTEST_MAIN()
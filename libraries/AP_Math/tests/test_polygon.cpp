@@ -0,0 +1,110 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+#define NUM_POINTS 300
+
+// a closed star shaped polygon in cm, like a survey site fence
+static void make_polygon(Vector2f *V, uint16_t n)
+{
+    for (uint16_t i=0; i<n-1; i++) {
+        const float angle = M_2PI * i / (n - 1);
+        const float radius = 50000 + 20000 * sinf(7 * angle) + ((i * 7919) % 1000) * 10;
+        V[i] = Vector2f(radius * cosf(angle) + 12345, radius * sinf(angle) - 5432);
+    }
+    V[n-1] = V[0];
+}
+
+TEST(PolygonIndex, OutsideMatchesPolygonOutside)
+{
+    Vector2f V[NUM_POINTS];
+    make_polygon(V, NUM_POINTS);
+    PolygonIndex index;
+    ASSERT_TRUE(index.build(V, NUM_POINTS));
+    ASSERT_TRUE(index.valid());
+
+    for (int32_t x=-90000; x<=110000; x+=1237) {
+        for (int32_t y=-100000; y<=100000; y+=1103) {
+            const Vector2f P(x + 0.5f, y + 0.5f);
+            EXPECT_EQ(Polygon_outside(P, V, NUM_POINTS), index.outside(P)) << "x=" << x << " y=" << y;
+        }
+    }
+}
+
+TEST(PolygonIndex, ClosestEdge)
+{
+    // laid out like a fence, with the return point first and only the
+    // points after it indexed
+    Vector2f B[NUM_POINTS+1];
+    B[0] = Vector2f(12345, -5432);
+    make_polygon(&B[1], NUM_POINTS);
+    const Vector2f *V = &B[1];
+    PolygonIndex index;
+    ASSERT_TRUE(index.build(V, NUM_POINTS));
+
+    for (int32_t x=-120000; x<=140000; x+=5011) {
+        for (int32_t y=-130000; y<=130000; y+=4999) {
+            const Vector2f P(x, y);
+            float expected = -1;
+            for (uint16_t i=0; i<NUM_POINTS; i++) {
+                const Vector2f &start = V[(i == 0) ? NUM_POINTS - 1 : i - 1];
+                const float d = (Vector2f::closest_point(P, start, V[i]) - P).length();
+                if (expected < 0 || d < expected) {
+                    expected = d;
+                }
+            }
+            uint16_t edge;
+            const float distance = index.closest_edge(P, edge);
+            EXPECT_FLOAT_EQ(expected, distance);
+            ASSERT_LT(edge, NUM_POINTS);
+            const Vector2f &start = V[(edge == 0) ? NUM_POINTS - 1 : edge - 1];
+            EXPECT_FLOAT_EQ(distance, (Vector2f::closest_point(P, start, V[edge]) - P).length());
+        }
+    }
+}
+
+TEST(PolygonIndex, BoxQueryReportsEachEdgeOnce)
+{
+    Vector2f V[NUM_POINTS];
+    make_polygon(V, NUM_POINTS);
+    PolygonIndex index;
+    ASSERT_TRUE(index.build(V, NUM_POINTS));
+
+    for (int32_t x=-80000; x<=80000; x+=9000) {
+        const Vector2f min(x, -x / 2);
+        const Vector2f max(x + 15000, -x / 2 + 30000);
+        uint8_t seen[NUM_POINTS] {};
+        PolygonIndex::BoxQuery query(index, min, max);
+        uint16_t edge;
+        while (query.next(edge)) {
+            ASSERT_LT(edge, NUM_POINTS);
+            seen[edge]++;
+        }
+        for (uint16_t i=0; i<NUM_POINTS; i++) {
+            const Vector2f &a = index.edge_start(i);
+            const Vector2f &b = index.edge_end(i);
+            const bool overlaps = MIN(a.x, b.x) <= max.x && MAX(a.x, b.x) >= min.x &&
+                                  MIN(a.y, b.y) <= max.y && MAX(a.y, b.y) >= min.y;
+            EXPECT_EQ(overlaps ? 1 : 0, seen[i]) << "edge " << i;
+        }
+    }
+}
+
+TEST(PolygonIndex, Empty)
+{
+    PolygonIndex index;
+    EXPECT_FALSE(index.valid());
+    EXPECT_TRUE(index.outside(Vector2f(0, 0)));
+    uint16_t edge;
+    EXPECT_LT(index.closest_edge(Vector2f(0, 0), edge), 0);
+    EXPECT_FALSE(index.build(nullptr, 0));
+
+    Vector2f V[5] = {{0, 0}, {100, 0}, {100, 100}, {0, 100}, {0, 0}};
+    EXPECT_TRUE(index.build(V, 5));
+    EXPECT_FALSE(index.outside(Vector2f(50, 50)));
+    EXPECT_TRUE(index.outside(Vector2f(150, 50)));
+    index.clear();
+    EXPECT_FALSE(index.valid());
+}
+
+AP_GTEST_MAIN()
@@ -2,6 +2,7 @@
 #if HAL_CPU_CLASS >= HAL_CPU_CLASS_150
 
 #include "AP_NavEKF3_core.h"
+#include "AP_NavEKF3_CoreThread.h"
 #include <AP_Vehicle/AP_Vehicle.h>
 #include <GCS_MAVLink/GCS.h>
 #include <DataFlash/DataFlash.h>
@@ -576,6 +577,14 @@ const AP_Param::GroupInfo NavEKF3::var_info[] = {
     // @Units: m/s
     AP_GROUPINFO("WENC_VERR", 53, NavEKF3, _wencOdmVelErr, 0.1f),
 
+    // @Param: CORE_THREADS
+    // @DisplayName: Run EKF cores on separate threads
+    // @Description: On Linux boards with more than one CPU, the EKF cores other than the primary are run on their own threads, each pinned to a CPU, in parallel with the primary core. The main loop still waits for every core to complete its update, as core selection uses the result of all cores, but the wait is for the slowest core rather than the sum of all cores. Has no effect on other boards.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("CORE_THREADS", 54, NavEKF3, _coreThreads, 0),
+
     AP_GROUPEND
 };
 
@@ -697,6 +706,8 @@ bool NavEKF3::InitialiseFilter(void)
         return false;
     }
 
+    start_core_threads();
+
     // Set the primary initially to be the lowest index
     primary = 0;
 
@@ -739,9 +750,37 @@ void NavEKF3::UpdateFilter(void)
         } else {
             statePredictEnabled[i] = true;
         }
+#if EK3_CORE_THREADS_ENABLED
+        if (core_threads != nullptr) {
+            // run in parallel below
+            continue;
+        }
+#endif
         core[i].UpdateFilter(statePredictEnabled[i]);
     }
 
+#if EK3_CORE_THREADS_ENABLED
+    if (core_threads != nullptr) {
+        // hand the other cores to the core threads, run the primary
+        // core on this thread and then wait for the others, as core
+        // selection below needs the result of every core
+        uint8_t thread_index = 0;
+        for (uint8_t i=0; i<num_cores; i++) {
+            if (i != primary) {
+                core_threads[thread_index++].run(&core[i], statePredictEnabled[i]);
+            }
+        }
+        core[primary].UpdateFilter(statePredictEnabled[primary]);
+        for (uint8_t i=0; i<thread_index; i++) {
+            core_threads[i].wait();
+        }
+        // core threads can't talk to the GCS, send their text here
+        for (uint8_t i=0; i<num_cores; i++) {
+            core[i].send_queued_text();
+        }
+    }
+#endif
+
     // If the current core selected has a bad error score or is unhealthy, switch to a healthy core with the lowest fault score
     // Don't start running the check until the primary core has started returned healthy for at least 10 seconds to avoid switching
     // due to initial alignment fluctuations and race conditions
@@ -784,6 +823,45 @@ void NavEKF3::UpdateFilter(void)
     check_log_write();
 }
 
+/*
+  start the threads used to run the non-primary cores when EK3_CORE_THREADS
+  is set. The cores are run serially on the main thread if the threads
+  cannot be started
+ */
+void NavEKF3::start_core_threads(void)
+{
+#if EK3_CORE_THREADS_ENABLED
+    if (core_threads != nullptr || _coreThreads == 0 || num_cores < 2) {
+        return;
+    }
+    const uint8_t num_cpus = NavEKF3_CoreThread::num_cpus();
+    if (num_cpus < 2) {
+        gcs().send_text(MAV_SEVERITY_INFO, "NavEKF3: single CPU, core threads disabled");
+        return;
+    }
+    NavEKF3_CoreThread *threads = new NavEKF3_CoreThread[num_cores-1];
+    if (threads == nullptr) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "NavEKF3: core thread allocation failed");
+        return;
+    }
+    for (uint8_t i=0; i<num_cores-1; i++) {
+        // leave CPU 0 to the main thread
+        const int16_t cpu = 1 + (i % (num_cpus - 1));
+        if (!threads[i].start(i, cpu)) {
+            // stop the threads that did start and run all cores here
+            for (uint8_t j=0; j<i; j++) {
+                threads[j].stop();
+            }
+            delete[] threads;
+            gcs().send_text(MAV_SEVERITY_WARNING, "NavEKF3: core thread start failed");
+            return;
+        }
+    }
+    core_threads = threads;
+    gcs().send_text(MAV_SEVERITY_INFO, "NavEKF3: %u core threads", (unsigned)(num_cores-1));
+#endif
+}
+
 // Check basic filter health metrics and return a consolidated health status
 bool NavEKF3::healthy(void) const
 {
@@ -29,6 +29,7 @@
 #include <AP_RangeFinder/AP_RangeFinder.h>
 
 class NavEKF3_core;
+class NavEKF3_CoreThread;
 class AP_AHRS;
 
 class NavEKF3 {
@@ -358,6 +359,7 @@ private:
     uint8_t num_cores; // number of allocated cores
     uint8_t primary;   // current primary core
     NavEKF3_core *core = nullptr;
+    NavEKF3_CoreThread *core_threads = nullptr; // threads running the non-primary cores, if enabled
     const AP_AHRS *_ahrs;
     const RangeFinder &_rng;
 
@@ -416,6 +418,7 @@ private:
     AP_Float _visOdmVelErrMax;      // Observation 1-STD velocity error assumed for visual odometry sensor at lowest reported quality (m/s)
     AP_Float _visOdmVelErrMin;      // Observation 1-STD velocity error assumed for visual odometry sensor at highest reported quality (m/s)
     AP_Float _wencOdmVelErr;        // Observation 1-STD velocity error assumed for wheel odometry sensor (m/s)
+    AP_Int8 _coreThreads;           // Run the non-primary cores on their own threads
 
 
     // Tuning parameters
@@ -447,12 +450,14 @@ private:
     const uint16_t fusionTimeStep_ms = 10;         // The minimum time interval between covariance predictions and measurement fusions in msec
     const uint8_t sensorIntervalMin_ms = 50;       // The minimum allowed time between measurements from any non-IMU sensor (msec)
 
+    // the log_ flags are set by the cores, which may run on separate
+    // threads, so they are not bitfields sharing a byte
     struct {
-        bool enabled:1;
-        bool log_compass:1;
-        bool log_gps:1;
-        bool log_baro:1;
-        bool log_imu:1;
+        bool enabled;
+        bool log_compass;
+        bool log_gps;
+        bool log_baro;
+        bool log_imu;
     } logging;
 
     // time at start of current filter update
@@ -499,4 +504,7 @@ private:
     // new_primary - index of the ekf instance that we are about to switch to as the primary
     // old_primary - index of the ekf instance that we are currently using as the primary
     void updateLaneSwitchPosDownResetData(uint8_t new_primary, uint8_t old_primary);
+
+    // start the threads used to run the non-primary cores
+    void start_core_threads(void);
 };
@@ -3,6 +3,7 @@
 // this buffer model is to be used for observation buffers,
 // the data is pushed into buffer like any standard ring buffer
 // return is based on the sample time provided
+// the size is rounded up to a power of two so indexes wrap with a mask
 template <typename element_type>
 class obs_ring_buffer_t
 {
@@ -14,16 +15,26 @@ public:
     // initialise buffer, returns false when allocation has failed
     bool init(uint32_t size)
     {
-        buffer = new element_t[size];
+        uint32_t pow2_size = 1;
+        while (pow2_size < size) {
+            pow2_size <<= 1;
+        }
+        if (pow2_size > 128) {
+            return false;
+        }
+        buffer = new element_t[pow2_size];
         if(buffer == nullptr)
         {
             return false;
         }
-        memset((void *)buffer,0,size*sizeof(element_t));
-        _size = size;
+        memset((void *)buffer,0,pow2_size*sizeof(element_t));
+        _size = pow2_size;
+        _mask = pow2_size - 1;
         _head = 0;
         _tail = 0;
         _new_data = false;
+        _unordered = 0;
+        _last_push_ms = 0;
         return true;
     }
 
@@ -51,6 +62,28 @@ public:
                     _new_data = false;
                 }
             }
+        } else if (_unordered == 0) {
+            // every element was pushed in time order, so binary search
+            // for the newest element that is not newer than sample_time.
+            // Older elements are older still so cannot be a better match
+            uint8_t lo = 0;
+            uint8_t hi = (_head - tail) & _mask;
+            while (lo < hi) {
+                const uint8_t mid = (lo + hi) / 2;
+                if (buffer[(tail + mid) & _mask].element.time_ms > sample_time) {
+                    hi = mid;
+                } else {
+                    lo = mid + 1;
+                }
+            }
+            if (lo > 0) {
+                const uint8_t index = (tail + lo - 1) & _mask;
+                if (buffer[index].element.time_ms != 0 &&
+                    ((sample_time - buffer[index].element.time_ms) < 100)) {
+                    bestIndex = index;
+                    success = true;
+                }
+            }
         } else {
             while(_head != tail) {
                 // find a measurement older than the fusion time horizon that we haven't checked before
@@ -63,13 +96,13 @@ public:
                 } else if(buffer[tail].element.time_ms > sample_time){
                     break;
                 }
-                tail = (tail+1)%_size;
+                tail = (tail+1) & _mask;
             }
         }
 
         if (success) {
             element = buffer[bestIndex].element;
-            _tail = (bestIndex+1)%_size;
+            _tail = (bestIndex+1) & _mask;
             //make time zero to stop using it again,
             //resolves corner case of reusing the element when head == tail
             buffer[bestIndex].element.time_ms = 0;
@@ -85,8 +118,16 @@ public:
     */
     inline void push(element_type element)
     {
+        // an element older than the last one stops recall() using a
+        // binary search until it has been overwritten
+        if (element.time_ms < _last_push_ms) {
+            _unordered = _size;
+        } else if (_unordered > 0) {
+            _unordered--;
+        }
+        _last_push_ms = element.time_ms;
         // Advance head to next available index
-        _head = (_head+1)%_size;
+        _head = (_head+1) & _mask;
         // New data is written at the head
         buffer[_head].element = element;
         _new_data = true;
@@ -96,6 +137,8 @@ public:
         for (uint8_t index=0; index<_size; index++) {
             buffer[index].element = element;
         }
+        _unordered = 0;
+        _last_push_ms = element.time_ms;
     }
 
     // zeroes all data in the ring buffer
@@ -103,14 +146,18 @@ public:
         _head = 0;
         _tail = 0;
         _new_data = false;
+        _unordered = 0;
+        _last_push_ms = 0;
         memset((void *)buffer,0,_size*sizeof(element_t));
     }
 
 private:
-    uint8_t _size,_head,_tail,_new_data;
+    uint8_t _size,_mask,_head,_tail,_new_data;
+    // number of pushes until all elements are in time order again
+    uint8_t _unordered;
+    uint32_t _last_push_ms;
 };
 
-
 // Following buffer model is for IMU data,
 // it achieves a distance of sample size
 // between youngest and oldest
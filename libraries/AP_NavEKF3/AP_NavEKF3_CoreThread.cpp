@@ -0,0 +1,115 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "AP_NavEKF3_CoreThread.h"
+
+#if EK3_CORE_THREADS_ENABLED
+
+#include "AP_NavEKF3_core.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+uint8_t NavEKF3_CoreThread::num_cpus(void)
+{
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) {
+        return 1;
+    }
+    return MIN(n, 255);
+}
+
+bool NavEKF3_CoreThread::start(uint8_t index, int16_t cpu)
+{
+    _core = nullptr;
+    _predict = false;
+    _running = false;
+    _exit = false;
+    _cpu = cpu;
+    if (sem_init(&_start_sem, 0, 0) != 0 ||
+        sem_init(&_done_sem, 0, 0) != 0) {
+        return false;
+    }
+
+    char name[] = "EK3_core0";
+    name[sizeof(name)-2] = '0' + index;
+    // same priority as the main thread, which waits on this thread
+    if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&NavEKF3_CoreThread::thread_main, void),
+                                      name, 8192, AP_HAL::Scheduler::PRIORITY_MAIN, 0)) {
+        sem_destroy(&_start_sem);
+        sem_destroy(&_done_sem);
+        return false;
+    }
+    return true;
+}
+
+void NavEKF3_CoreThread::run(NavEKF3_core *core, bool predict)
+{
+    _core = core;
+    _predict = predict;
+    _running = true;
+    sem_post(&_start_sem);
+}
+
+void NavEKF3_CoreThread::wait(void)
+{
+    if (!_running) {
+        return;
+    }
+    while (sem_wait(&_done_sem) != 0 && errno == EINTR) {
+    }
+    _running = false;
+}
+
+void NavEKF3_CoreThread::stop(void)
+{
+    wait();
+    _exit = true;
+    sem_post(&_start_sem);
+    // the thread posts _done_sem as the last thing it does before
+    // returning, after which it no longer touches this object
+    while (sem_wait(&_done_sem) != 0 && errno == EINTR) {
+    }
+    sem_destroy(&_start_sem);
+    sem_destroy(&_done_sem);
+}
+
+void NavEKF3_CoreThread::thread_main(void)
+{
+    if (_cpu >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(_cpu, &cpuset);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0) {
+            hal.console->printf("NavEKF3: failed to pin core thread to CPU %d\n", (int)_cpu);
+        }
+    }
+
+    while (true) {
+        while (sem_wait(&_start_sem) != 0 && errno == EINTR) {
+        }
+        if (_exit) {
+            sem_post(&_done_sem);
+            return;
+        }
+        _core->UpdateFilter(_predict);
+        sem_post(&_done_sem);
+    }
+}
+
+#endif // EK3_CORE_THREADS_ENABLED
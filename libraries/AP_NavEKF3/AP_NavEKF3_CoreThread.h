@@ -0,0 +1,62 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  worker thread used to run an EKF core in parallel with the core being
+  run by the main thread. The main thread hands a core to the worker
+  with run() and collects it with wait() before anything else reads
+  the core, so the core itself needs no locking
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#define EK3_CORE_THREADS_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_LINUX)
+
+#if EK3_CORE_THREADS_ENABLED
+
+#include <semaphore.h>
+
+class NavEKF3_core;
+
+class NavEKF3_CoreThread {
+public:
+    // start the thread, pinned to the given CPU if cpu is not negative
+    bool start(uint8_t index, int16_t cpu);
+
+    // start running UpdateFilter() on a core
+    void run(NavEKF3_core *core, bool predict);
+
+    // wait for the core passed to run() to complete
+    void wait(void);
+
+    // stop a thread started with start() and wait for it to exit
+    void stop(void);
+
+    // number of CPUs available to run cores on
+    static uint8_t num_cpus(void);
+
+private:
+    void thread_main(void);
+
+    NavEKF3_core *_core;
+    bool _predict;
+    bool _running;
+    bool _exit;
+    int16_t _cpu;
+    sem_t _start_sem;
+    sem_t _done_sem;
+};
+
+#endif // EK3_CORE_THREADS_ENABLED
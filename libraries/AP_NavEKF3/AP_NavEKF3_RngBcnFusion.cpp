@@ -211,46 +211,10 @@ void NavEKF3_core::FuseRngBcn()
             // restart the counter
             lastRngBcnPassTime_ms = imuSampleTime_ms;
 
-            // correct the covariance P = (I - K*H)*P
-            // take advantage of the empty columns in KH to reduce the
-            // number of operations
-            for (unsigned i = 0; i<=stateIndexLim; i++) {
-                for (unsigned j = 0; j<=6; j++) {
-                    KH[i][j] = 0.0f;
-                }
-                for (unsigned j = 7; j<=9; j++) {
-                    KH[i][j] = Kfusion[i] * H_BCN[j];
-                }
-                for (unsigned j = 10; j<=23; j++) {
-                    KH[i][j] = 0.0f;
-                }
-            }
-            for (unsigned j = 0; j<=stateIndexLim; j++) {
-                for (unsigned i = 0; i<=stateIndexLim; i++) {
-                    ftype res = 0;
-                    res += KH[i][7] * P[7][j];
-                    res += KH[i][8] * P[8][j];
-                    res += KH[i][9] * P[9][j];
-                    KHP[i][j] = res;
-                }
-            }
-            // Check that we are not going to drive any variances negative and skip the update if so
-            bool healthyFusion = true;
-            for (uint8_t i= 0; i<=stateIndexLim; i++) {
-                if (KHP[i][i] > P[i][i]) {
-                    healthyFusion = false;
-                }
-            }
-            if (healthyFusion) {
-                // update the covariance matrix
-                for (uint8_t i= 0; i<=stateIndexLim; i++) {
-                    for (uint8_t j= 0; j<=stateIndexLim; j++) {
-                        P[i][j] = P[i][j] - KHP[i][j];
-                    }
-                }
-
-                // force the covariance matrix to be symmetrical and limit the variances to prevent ill-condiioning.
-                ForceSymmetry();
+            // correct the covariance P = (I - K*H)*P, only elements 7 to 9 of H are non zero
+            // skip the update if it would drive any variances negative
+            if (FuseCovariance(&Kfusion[0], &H_BCN[7], 7, 9, true)) {
+                // limit the variances to prevent ill-condiioning.
                 ConstrainVariances();
 
                 // correct the state vector
@@ -456,18 +420,11 @@ void NavEKF3_core::FuseRngBcnStatic()
             receiverPos.z -= K_RNG[2] * innovRngBcn;
 
             // calculate the covariance correction
-            for (unsigned i = 0; i<=2; i++) {
-                for (unsigned j = 0; j<=2; j++) {
-                    KH[i][j] = K_RNG[i] * H_RNG[j];
-                }
-            }
+            ftype KHP[3][3];
             for (unsigned j = 0; j<=2; j++) {
+                const ftype HP = H_RNG[0] * receiverPosCov[0][j] + H_RNG[1] * receiverPosCov[1][j] + H_RNG[2] * receiverPosCov[2][j];
                 for (unsigned i = 0; i<=2; i++) {
-                    ftype res = 0;
-                    res += KH[i][0] * receiverPosCov[0][j];
-                    res += KH[i][1] * receiverPosCov[1][j];
-                    res += KH[i][2] * receiverPosCov[2][j];
-                    KHP[i][j] = res;
+                    KHP[i][j] = K_RNG[i] * HP;
                 }
             }
 
@@ -36,6 +36,40 @@ NavEKF3_core::NavEKF3_core(void) :
     lastInitFailReport_ms = 0;
 }
 
+/*
+  send status text. UpdateFilter() may run on a core thread, which must
+  not call into the GCS, so text from a core thread is queued and sent
+  by the main thread once the core has been collected
+ */
+void NavEKF3_core::send_text(MAV_SEVERITY severity, const char *fmt, ...)
+{
+    va_list arg_list;
+    va_start(arg_list, fmt);
+#if EK3_CORE_THREADS_ENABLED
+    if (!hal.scheduler->in_main_thread()) {
+        if (text_queue_count < ARRAY_SIZE(text_queue)) {
+            struct queued_text &q = text_queue[text_queue_count++];
+            q.severity = severity;
+            hal.util->vsnprintf(q.text, sizeof(q.text), fmt, arg_list);
+        }
+        va_end(arg_list);
+        return;
+    }
+#endif
+    gcs().send_textv(severity, fmt, arg_list);
+    va_end(arg_list);
+}
+
+void NavEKF3_core::send_queued_text(void)
+{
+#if EK3_CORE_THREADS_ENABLED
+    for (uint8_t i=0; i<text_queue_count; i++) {
+        gcs().send_text(text_queue[i].severity, "%s", text_queue[i].text);
+    }
+    text_queue_count = 0;
+#endif
+}
+
 // setup this core backend
 bool NavEKF3_core::setup_core(NavEKF3 *_frontend, uint8_t _imu_index, uint8_t _core_index)
 {
@@ -75,11 +109,11 @@ bool NavEKF3_core::setup_core(NavEKF3 *_frontend, uint8_t _imu_index, uint8_t _c
                 lastInitFailReport_ms = AP_HAL::millis();
                 // provide an escalating series of messages
                 if (AP_HAL::millis() > 30000) {
-                    gcs().send_text(MAV_SEVERITY_ERROR, "EKF3 waiting for GPS config data");
+                    send_text(MAV_SEVERITY_ERROR, "EKF3 waiting for GPS config data");
                 } else if (AP_HAL::millis() > 15000) {
-                    gcs().send_text(MAV_SEVERITY_WARNING, "EKF3 waiting for GPS config data");
+                    send_text(MAV_SEVERITY_WARNING, "EKF3 waiting for GPS config data");
                 } else  {
-                    gcs().send_text(MAV_SEVERITY_INFO, "EKF3 waiting for GPS config data");
+                    send_text(MAV_SEVERITY_INFO, "EKF3 waiting for GPS config data");
                 }
             }
             return false;
@@ -140,7 +174,7 @@ bool NavEKF3_core::setup_core(NavEKF3 *_frontend, uint8_t _imu_index, uint8_t _c
     if(!storedOutput.init(imu_buffer_length)) {
         return false;
     }
-    gcs().send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u buffers, IMU=%u , OBS=%u , dt=%6.4f",(unsigned)imu_index,(unsigned)imu_buffer_length,(unsigned)obs_buffer_length,(double)dtEkfAvg);
+    send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u buffers, IMU=%u , OBS=%u , dt=%6.4f",(unsigned)imu_index,(unsigned)imu_buffer_length,(unsigned)obs_buffer_length,(double)dtEkfAvg);
     return true;
 }
     
@@ -480,7 +514,7 @@ bool NavEKF3_core::InitialiseFilterBootstrap(void)
 
     // set to true now that states have be initialised
     statesInitialised = true;
-    gcs().send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u initialised",(unsigned)imu_index);
+    send_text(MAV_SEVERITY_INFO, "EKF3 IMU%u initialised",(unsigned)imu_index);
 
     // we initially return false to wait for the IMU buffer to fill
     return false;
@@ -1424,6 +1458,81 @@ void NavEKF3_core::ForceSymmetry()
     }
 }
 
+/*
+  correct the covariance P = (I - K*H)*P for a scalar observation
+
+  K*H*P is the outer product of K and the single row H*P, so it is
+  applied directly instead of forming K*H and K*H*P as 24x24
+  intermediates. Only the upper triangle is computed, using the mean of
+  K*H*P and its transpose as ForceSymmetry() would, then copied to the
+  lower triangle. Rows of states with a zero gain (inhibited states) only
+  visit the columns of states with a non-zero gain.
+ */
+bool NavEKF3_core::ScalarCovarianceUpdate(float *covMat, uint8_t lim, const float *K,
+                                          const float *H, uint8_t hFirst, uint8_t hLast,
+                                          bool checkVariances)
+{
+    // H*P, skipping the zero elements of H
+    float HP[24] {};
+    for (uint8_t k=hFirst; k<=hLast; k++) {
+        const float h = H[k-hFirst];
+        if (!(fabsf(h) > 0.0f)) {
+            continue;
+        }
+        const float *row = &covMat[k*24];
+        for (uint8_t j=0; j<=lim; j++) {
+            HP[j] += h * row[j];
+        }
+    }
+
+    // check that we are not going to drive any variances negative
+    if (checkVariances) {
+        for (uint8_t i=0; i<=lim; i++) {
+            if (K[i] * HP[i] > covMat[i*25]) {
+                return false;
+            }
+        }
+    }
+
+    // local copy of the gains and the states with a non-zero gain, the
+    // copy lets the compiler see that K does not alias covMat
+    float Kl[24];
+    uint8_t active[24];
+    uint8_t numActive = 0;
+    for (uint8_t i=0; i<=lim; i++) {
+        Kl[i] = K[i];
+        if (fabsf(K[i]) > 0.0f) {
+            active[numActive++] = i;
+        }
+    }
+
+    for (uint8_t i=0; i<=lim; i++) {
+        float *row = &covMat[i*24];
+        const float halfHPi = 0.5f * HP[i];
+        if (fabsf(Kl[i]) > 0.0f) {
+            const float halfKi = 0.5f * Kl[i];
+            for (uint8_t j=i; j<=lim; j++) {
+                row[j] -= halfKi * HP[j] + Kl[j] * halfHPi;
+            }
+        } else {
+            for (uint8_t a=0; a<numActive; a++) {
+                const uint8_t j = active[a];
+                if (j > i) {
+                    row[j] -= Kl[j] * halfHPi;
+                }
+            }
+        }
+    }
+
+    for (uint8_t i=1; i<=lim; i++) {
+        for (uint8_t j=0; j<i; j++) {
+            covMat[i*24+j] = covMat[j*24+i];
+        }
+    }
+
+    return true;
+}
+
 // constrain variances (diagonal terms) in the state covariance matrix to  prevent ill-conditioning
 // if states are inactive, zero the corresponding off-diagonals
 void NavEKF3_core::ConstrainVariances()
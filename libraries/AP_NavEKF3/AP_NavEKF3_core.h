@@ -28,6 +28,7 @@
 #include "AP_NavEKF3.h"
 #include <AP_Math/vectorN.h>
 #include <AP_NavEKF3/AP_NavEKF3_Buffer.h>
+#include "AP_NavEKF3_CoreThread.h"
 
 // GPS pre-flight check bit locations
 #define MASK_GPS_NSATS      (1<<0)
@@ -79,6 +80,10 @@ public:
     // The predict flag is set true when a new prediction cycle can be started
     void UpdateFilter(bool predict);
 
+    // send status text queued by UpdateFilter() while running on a
+    // core thread. Must be called from the main thread
+    void send_queued_text(void);
+
     // Check basic filter health metrics and return a consolidated health status
     bool healthy(void) const;
 
@@ -349,7 +354,19 @@ public:
 
     // get timing statistics structure
     void getTimingStatistics(struct ekf_timing &timing);
-    
+
+    /*
+      apply the covariance correction P = (I - K*H)*P for a scalar
+      observation to the row major 24x24 matrix covMat, for states 0 to
+      lim. H holds the observation jacobian for states hFirst to hLast.
+      covMat is left symmetric. If checkVariances is true and the
+      correction would make a variance negative then covMat is not
+      changed and false is returned
+     */
+    static bool ScalarCovarianceUpdate(float *covMat, uint8_t lim, const float *K,
+                                       const float *H, uint8_t hFirst, uint8_t hLast,
+                                       bool checkVariances);
+
 private:
     // Reference to the global EKF frontend for parameters
     NavEKF3 *frontend;
@@ -521,6 +538,11 @@ private:
     // constrain variances (diagonal terms) in the state covariance matrix
     void ConstrainVariances();
 
+    // correct the state covariance matrix for a scalar observation, see ScalarCovarianceUpdate()
+    bool FuseCovariance(const ftype *K, const ftype *H, uint8_t hFirst, uint8_t hLast, bool checkVariances) {
+        return ScalarCovarianceUpdate(&P[0][0], stateIndexLim, K, H, hFirst, hLast, checkVariances);
+    }
+
     // constrain states
     void ConstrainStates();
 
@@ -815,8 +837,6 @@ private:
 
     float gpsNoiseScaler;           // Used to scale the  GPS measurement noise and consistency gates to compensate for operation with small satellite counts
     Vector28 Kfusion;               // Kalman gain vector
-    Matrix24 KH;                    // intermediate result used for covariance updates
-    Matrix24 KHP;                   // intermediate result used for covariance updates
     Matrix24 P;                     // covariance matrix
     imu_ring_buffer_t<imu_elements> storedIMU;      // IMU data buffer
     obs_ring_buffer_t<gps_elements> storedGPS;      // GPS data buffer
@@ -1229,6 +1249,19 @@ private:
     // string representing last reason for prearm failure
     char prearm_fail_string[40];
 
+    // send status text, queueing it for send_queued_text() when
+    // called from a core thread
+    void send_text(MAV_SEVERITY severity, const char *fmt, ...) FMT_PRINTF(3, 4);
+
+#if EK3_CORE_THREADS_ENABLED
+    // status text from a core thread waiting to be sent by the main thread
+    struct queued_text {
+        MAV_SEVERITY severity;
+        char text[50];
+    } text_queue[4];
+    uint8_t text_queue_count = 0;
+#endif
+
     // performance counters
     AP_HAL::Util::perf_counter_t  _perf_UpdateFilter;
     AP_HAL::Util::perf_counter_t  _perf_CovariancePrediction;
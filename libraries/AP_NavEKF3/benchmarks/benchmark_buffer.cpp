@@ -0,0 +1,74 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  cost of an observation buffer recall against buffer length. Each
+  recall follows half a buffer of new measurements, as happens when a
+  sensor runs faster than it is fused, so the match is several elements
+  past the tail
+ */
+#include <AP_gbenchmark.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <AP_NavEKF3/AP_NavEKF3_Buffer.h>
+
+struct bench_elements {
+    uint32_t time_ms;
+    float data[6];
+};
+
+static void recall_steady_state(benchmark::State& state, bool in_order)
+{
+    const uint8_t size = state.range(0);
+    obs_ring_buffer_t<bench_elements> buf;
+    buf.init(size);
+
+    bench_elements e {};
+    const uint32_t delay_ms = (size / 2) * 10;
+    uint32_t time_ms = 1000;
+    uint32_t count = 0;
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<size/2; i++) {
+            e.time_ms = time_ms;
+            if (!in_order && (++count % size) == 0) {
+                // a late measurement keeps the buffer out of time order
+                e.time_ms -= 5;
+            }
+            buf.push(e);
+            time_ms += 10;
+        }
+        bench_elements out;
+        bool ret = buf.recall(out, time_ms - delay_ms);
+        gbenchmark_escape(&ret);
+        gbenchmark_escape(&out);
+    }
+}
+
+static void BM_ObsBufferRecall(benchmark::State& state)
+{
+    recall_steady_state(state, true);
+}
+
+static void BM_ObsBufferRecallUnordered(benchmark::State& state)
+{
+    recall_steady_state(state, false);
+}
+
+BENCHMARK(BM_ObsBufferRecall)->Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(128);
+BENCHMARK(BM_ObsBufferRecallUnordered)->Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(128);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,159 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  compare the scalar covariance update used by the EKF3 fusion steps
+  against the dense K*H and K*H*P form it replaced, for a magnetometer
+  observation (H non-zero for states 0-3 and 16-21)
+ */
+#include <AP_gbenchmark.h>
+
+#include <AP_NavEKF3/AP_NavEKF3_core.h>
+
+#include <string.h>
+
+struct CovarianceSetup {
+    float P[24][24];
+    float K[24];
+    float H[24];
+};
+
+// a positive definite P and a matching gain, with the gains of the mag
+// and wind states zeroed if inhibited
+static void covariance_setup(CovarianceSetup &s, bool inhibited)
+{
+    float A[24][24];
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            A[i][j] = 0.01f * ((i * 7 + j * 13) % 17) - 0.08f;
+        }
+        A[i][i] += 1.0f;
+    }
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            float sum = 0;
+            for (uint8_t k=0; k<24; k++) {
+                sum += A[i][k] * A[j][k];
+            }
+            s.P[i][j] = sum;
+        }
+    }
+
+    memset(s.H, 0, sizeof(s.H));
+    for (uint8_t k=0; k<=3; k++) {
+        s.H[k] = 0.1f * (k + 1);
+    }
+    for (uint8_t k=16; k<=21; k++) {
+        s.H[k] = 0.05f * (k - 15);
+    }
+
+    float HP[24] {};
+    float var = 1.0f;
+    for (uint8_t j=0; j<24; j++) {
+        for (uint8_t k=0; k<24; k++) {
+            HP[j] += s.H[k] * s.P[k][j];
+        }
+        var += HP[j] * s.H[j];
+    }
+    for (uint8_t i=0; i<24; i++) {
+        s.K[i] = (inhibited && i >= 16) ? 0.0f : HP[i] / var;
+    }
+}
+
+// the update as previously written in FuseMagnetometer()
+static void covariance_update_dense(float P[24][24], const float K[24], const float H[24])
+{
+    static float KH[24][24];
+    static float KHP[24][24];
+
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<=3; j++) {
+            KH[i][j] = K[i] * H[j];
+        }
+        for (uint8_t j=4; j<=15; j++) {
+            KH[i][j] = 0.0f;
+        }
+        for (uint8_t j=16; j<=21; j++) {
+            KH[i][j] = K[i] * H[j];
+        }
+        for (uint8_t j=22; j<=23; j++) {
+            KH[i][j] = 0.0f;
+        }
+    }
+    for (uint8_t j=0; j<24; j++) {
+        for (uint8_t i=0; i<24; i++) {
+            float res = 0;
+            res += KH[i][0] * P[0][j];
+            res += KH[i][1] * P[1][j];
+            res += KH[i][2] * P[2][j];
+            res += KH[i][3] * P[3][j];
+            res += KH[i][16] * P[16][j];
+            res += KH[i][17] * P[17][j];
+            res += KH[i][18] * P[18][j];
+            res += KH[i][19] * P[19][j];
+            res += KH[i][20] * P[20][j];
+            res += KH[i][21] * P[21][j];
+            KHP[i][j] = res;
+        }
+    }
+    for (uint8_t i=0; i<24; i++) {
+        if (KHP[i][i] > P[i][i]) {
+            return;
+        }
+    }
+    for (uint8_t i=0; i<24; i++) {
+        for (uint8_t j=0; j<24; j++) {
+            P[i][j] = P[i][j] - KHP[i][j];
+        }
+    }
+    for (uint8_t i=1; i<24; i++) {
+        for (uint8_t j=0; j<i; j++) {
+            float temp = 0.5f * (P[i][j] + P[j][i]);
+            P[i][j] = temp;
+            P[j][i] = temp;
+        }
+    }
+}
+
+static void BM_CovarianceUpdateDense(benchmark::State& state)
+{
+    CovarianceSetup s;
+    covariance_setup(s, state.range(0) != 0);
+    float P[24][24];
+
+    while (state.KeepRunning()) {
+        memcpy(P, s.P, sizeof(P));
+        covariance_update_dense(P, s.K, s.H);
+        gbenchmark_escape(P);
+    }
+}
+
+static void BM_CovarianceUpdateScalar(benchmark::State& state)
+{
+    CovarianceSetup s;
+    covariance_setup(s, state.range(0) != 0);
+    float P[24][24];
+
+    while (state.KeepRunning()) {
+        memcpy(P, s.P, sizeof(P));
+        NavEKF3_core::ScalarCovarianceUpdate(&P[0][0], 23, s.K, s.H, 0, 21, true);
+        gbenchmark_escape(P);
+    }
+}
+
+// argument is 1 if the mag and wind states are inhibited
+BENCHMARK(BM_CovarianceUpdateDense)->Arg(0)->Arg(1);
+BENCHMARK(BM_CovarianceUpdateScalar)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN()
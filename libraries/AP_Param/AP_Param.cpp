@@ -28,11 +28,15 @@
 
 #include <cmath>
 #include <string.h>
+#include <ctype.h>
 
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/Semaphore.h>
 #include <AP_Math/AP_Math.h>
+#include <AP_Math/crc.h>
 #include <GCS_MAVLink/GCS.h>
 #include <StorageManager/StorageManager.h>
+#include <StorageManager/StorageJournal.h>
 #include <stdio.h>
 
 extern const AP_HAL::HAL &hal;
@@ -72,6 +76,7 @@ uint16_t AP_Param::num_param_overrides = 0;
 
 ObjectBuffer<AP_Param::param_save> AP_Param::save_queue{30};
 bool AP_Param::registered_save_handler;
+volatile bool AP_Param::save_flush_requested;
 
 // we need a dummy object for the parameter save callback
 static AP_Param save_dummy;
@@ -91,17 +96,46 @@ const AP_Param::param_defaults_struct AP_Param::param_defaults_data = {
 // storage object
 StorageAccess AP_Param::_storage(StorageManager::StorageParam);
 
+// saves are held briefly so a burst of saves is coalesced into a few
+// storage writes
+StorageJournal AP_Param::_storage_journal(_storage);
+
 // flags indicating frame type
 uint16_t AP_Param::_frame_type_flags;
 
 // write to EEPROM
 void AP_Param::eeprom_write_check(const void *ptr, uint16_t ofs, uint8_t size)
 {
-    _storage.write_block(ofs, ptr, size);
+    _storage_journal.write_block(ofs, ptr, size);
 }
 
 bool AP_Param::_hide_disabled_groups = true;
 
+// name index for find()
+#ifndef AP_PARAM_FIND_INDEX_ENABLED
+#define AP_PARAM_FIND_INDEX_ENABLED !HAL_MINIMIZE_FEATURES
+#endif
+struct AP_Param::find_index_entry *AP_Param::_find_index;
+uint16_t AP_Param::_find_index_count;
+
+// protects the find() index, which is replaced when objects with
+// pointer parameters are allocated
+static HAL_Semaphore find_index_sem;
+
+// index of scalar parameters for find_by_index()
+#ifndef AP_PARAM_SCALAR_INDEX_ENABLED
+#define AP_PARAM_SCALAR_INDEX_ENABLED !HAL_MINIMIZE_FEATURES
+#endif
+struct AP_Param::scalar_index_entry *AP_Param::_scalar_index;
+uint16_t AP_Param::_scalar_index_count;
+uint32_t AP_Param::_scalar_index_names_crc;
+uint8_t AP_Param::_scalar_index_generation;
+volatile uint8_t AP_Param::_count_generation;
+
+// protects the scalar index, which is replaced when objects with
+// pointer parameters are allocated
+static HAL_Semaphore scalar_index_sem;
+
 // write a sentinal value at the given offset
 void AP_Param::write_sentinal(uint16_t ofs)
 {
@@ -127,6 +161,10 @@ void AP_Param::erase_all(void)
 
     // add a sentinal directly after the header
     write_sentinal(sizeof(struct EEPROM_header));
+
+    // the caller may reboot straight after this, so don't leave the
+    // erase held in the journal
+    _storage_journal.flush();
 }
 
 /* the 'group_id' of a element of a group is the 18 bit identifier
@@ -307,7 +345,7 @@ bool AP_Param::setup(void)
     struct EEPROM_header hdr;
 
     // check the header
-    _storage.read_block(&hdr, 0, sizeof(hdr));
+    _storage_journal.read_block(&hdr, 0, sizeof(hdr));
     if (hdr.magic[0] != k_EEPROM_magic0 ||
         hdr.magic[1] != k_EEPROM_magic1 ||
         hdr.revision != k_EEPROM_revision) {
@@ -678,7 +716,7 @@ bool AP_Param::scan(const AP_Param::Param_header *target, uint16_t *pofs)
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
     while (ofs < _storage.size()) {
-        _storage.read_block(&phdr, ofs, sizeof(phdr));
+        _storage_journal.read_block(&phdr, ofs, sizeof(phdr));
         if (phdr.type == target->type &&
             get_key(phdr) == get_key(*target) &&
             phdr.group_element == target->group_element) {
@@ -824,57 +862,243 @@ AP_Param::find_group(const char *name, uint16_t vindex, ptrdiff_t group_offset,
 }
 
 
+// Find a variable by name in one top level variable
+//
+AP_Param *
+AP_Param::find_in_var(const char *name, uint16_t vindex, enum ap_var_type *ptype)
+{
+    uint8_t type = _var_info[vindex].type;
+    if (type == AP_PARAM_GROUP) {
+        uint8_t len = strnlen(_var_info[vindex].name, AP_MAX_NAME_SIZE);
+        if (strncmp(name, _var_info[vindex].name, len) != 0) {
+            return nullptr;
+        }
+        const struct GroupInfo *group_info = get_group_info(_var_info[vindex]);
+        if (group_info == nullptr) {
+            return nullptr;
+        }
+        return find_group(name + len, vindex, 0, group_info, ptype);
+    } else if (strcasecmp(name, _var_info[vindex].name) == 0) {
+        ptrdiff_t base;
+        if (!get_base(_var_info[vindex], base)) {
+            return nullptr;
+        }
+        *ptype = (enum ap_var_type)type;
+        return (AP_Param *)base;
+    }
+    return nullptr;
+}
+
+/*
+  case insensitive hash of a parameter name for the find() index
+ */
+uint16_t AP_Param::name_hash(const char *name)
+{
+    // FNV-1a, folded to 16 bits
+    uint32_t h = 2166136261U;
+    for (uint8_t i=0; i<AP_MAX_NAME_SIZE && name[i] != 0; i++) {
+        h ^= (uint8_t)toupper(name[i]);
+        h *= 16777619U;
+    }
+    return (h >> 16) ^ (h & 0xFFFF);
+}
+
+static int find_index_compare(const void *v1, const void *v2)
+{
+    const uint32_t k1 = (((const uint16_t *)v1)[0] << 16) | ((const uint16_t *)v1)[1];
+    const uint32_t k2 = (((const uint16_t *)v2)[0] << 16) | ((const uint16_t *)v2)[1];
+    if (k1 < k2) {
+        return -1;
+    }
+    return k1 > k2 ? 1 : 0;
+}
+
+/*
+  build the find() index from the visible scalar parameters, replacing
+  any earlier index. Parameters not in the index, such as those in
+  disabled groups, are found by the full search in find()
+ */
+void AP_Param::build_find_index(void)
+{
+#if AP_PARAM_FIND_INDEX_ENABLED
+    ParamToken token;
+    AP_Param *ap;
+    uint16_t count = 0;
+    for (ap=AP_Param::first(&token, nullptr);
+         ap;
+         ap=AP_Param::next_scalar(&token, nullptr)) {
+        count++;
+    }
+    struct find_index_entry *index = (struct find_index_entry *)calloc(count, sizeof(index[0]));
+    if (index == nullptr) {
+        return;
+    }
+    uint16_t n = 0;
+    for (ap=AP_Param::first(&token, nullptr);
+         ap && n < count;
+         ap=AP_Param::next_scalar(&token, nullptr)) {
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, sizeof(name), true);
+        name[AP_MAX_NAME_SIZE] = 0;
+        index[n].hash = name_hash(name);
+        index[n].vindex = token.key;
+        n++;
+    }
+
+    // sort by hash then variable, and drop duplicate entries
+    // from parameters of one variable with the same hash
+    qsort(index, n, sizeof(index[0]), find_index_compare);
+    uint16_t index_count = 0;
+    for (uint16_t i=0; i<n; i++) {
+        if (index_count == 0 ||
+            index[i].hash != index[index_count-1].hash ||
+            index[i].vindex != index[index_count-1].vindex) {
+            index[index_count++] = index[i];
+        }
+    }
+
+    struct find_index_entry *old_index;
+    {
+        WITH_SEMAPHORE(find_index_sem);
+        old_index = _find_index;
+        _find_index = index;
+        _find_index_count = index_count;
+    }
+    free(old_index);
+#endif
+}
+
+/*
+  find a variable by name using the index. Returns nullptr if the name
+  is not in the index, or the index has not been built yet or is being
+  replaced, in which case the caller falls back to a full search
+ */
+AP_Param *
+AP_Param::find_indexed(const char *name, enum ap_var_type *ptype)
+{
+    if (!find_index_sem.take_nonblocking()) {
+        return nullptr;
+    }
+    AP_Param *ap = find_in_index(name, ptype);
+    find_index_sem.give();
+    return ap;
+}
+
+AP_Param *
+AP_Param::find_in_index(const char *name, enum ap_var_type *ptype)
+{
+    if (_find_index == nullptr) {
+        return nullptr;
+    }
+
+    // binary search for the first entry with the hash
+    const uint16_t hash = name_hash(name);
+    uint16_t low = 0;
+    uint16_t high = _find_index_count;
+    while (low < high) {
+        const uint16_t mid = (low + high) / 2;
+        if (_find_index[mid].hash < hash) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    // entries are in variable order, so the first match is the one
+    // the full search would find
+    for (uint16_t i=low; i<_find_index_count && _find_index[i].hash == hash; i++) {
+        AP_Param *ap = find_in_var(name, _find_index[i].vindex, ptype);
+        if (ap != nullptr) {
+            return ap;
+        }
+    }
+    return nullptr;
+}
+
 // Find a variable by name.
 //
 AP_Param *
 AP_Param::find(const char *name, enum ap_var_type *ptype)
 {
+#if AP_PARAM_FIND_INDEX_ENABLED
+    AP_Param *ap = find_indexed(name, ptype);
+    if (ap != nullptr) {
+        return ap;
+    }
+#endif
     for (uint16_t i=0; i<_num_vars; i++) {
-        uint8_t type = _var_info[i].type;
-        if (type == AP_PARAM_GROUP) {
-            uint8_t len = strnlen(_var_info[i].name, AP_MAX_NAME_SIZE);
-            if (strncmp(name, _var_info[i].name, len) != 0) {
-                continue;
-            }
-            const struct GroupInfo *group_info = get_group_info(_var_info[i]);
-            if (group_info == nullptr) {
-                continue;
-            }
-            AP_Param *ap = find_group(name + len, i, 0, group_info, ptype);
-            if (ap != nullptr) {
-                return ap;
-            }
-            // we continue looking as we want to allow top level
-            // parameter to have the same prefix name as group
-            // parameters, for example CAM_P_G
-        } else if (strcasecmp(name, _var_info[i].name) == 0) {
-            *ptype = (enum ap_var_type)type;
-            ptrdiff_t base;
-            if (!get_base(_var_info[i], base)) {
-                return nullptr;
-            }
-            return (AP_Param *)base;
+        AP_Param *ap2 = find_in_var(name, i, ptype);
+        if (ap2 != nullptr) {
+            return ap2;
         }
+        // we continue looking as we want to allow top level
+        // parameter to have the same prefix name as group
+        // parameters, for example CAM_P_G
     }
     return nullptr;
 }
 
-// Find a variable by index. Note that this is quite slow.
+// Find a variable by index.
 //
 AP_Param *
 AP_Param::find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token)
 {
     AP_Param *ap;
+    if (read_scalar_index(idx, ap, ptype, token, nullptr)) {
+        return ap;
+    }
+
     uint16_t count=0;
     for (ap=AP_Param::first(token, ptype);
          ap && count < idx;
          ap=AP_Param::next_scalar(token, ptype)) {
         count++;
     }
-    return ap;    
+    return ap;
 }
 
 
+AP_Param *
+AP_Param::find_by_index_with_name(uint16_t idx, enum ap_var_type *ptype, ParamToken *token, char *name)
+{
+    AP_Param *ap;
+    if (!read_scalar_index(idx, ap, ptype, token, name)) {
+        return nullptr;
+    }
+    return ap;
+}
+
+/*
+  look up entry idx of the scalar index, copying its name if name is
+  not nullptr. Returns false if the index is out of date or being
+  replaced, in which case the caller walks the tree instead
+ */
+bool AP_Param::read_scalar_index(uint16_t idx, AP_Param *&ap, enum ap_var_type *ptype, ParamToken *token, char *name)
+{
+    if (!scalar_index_sem.take_nonblocking()) {
+        return false;
+    }
+    if (!scalar_index_valid()) {
+        scalar_index_sem.give();
+        return false;
+    }
+    ap = nullptr;
+    if (idx < _scalar_index_count) {
+        const struct scalar_index_entry &entry = _scalar_index[idx];
+        ap = entry.ap;
+        *token = entry.token;
+        if (ptype != nullptr) {
+            *ptype = (enum ap_var_type)entry.type;
+        }
+        if (name != nullptr) {
+            memcpy(name, entry.name, AP_MAX_NAME_SIZE);
+            name[AP_MAX_NAME_SIZE] = 0;
+        }
+    }
+    scalar_index_sem.give();
+    return true;
+}
+
 /*
   Find a variable by pointer, returning key. This is used for loading pointer variables
 */
@@ -1025,7 +1249,7 @@ void AP_Param::save_sync(bool force_save)
 
     if (phdr.type == AP_PARAM_INT8 && ginfo != nullptr && (ginfo->flags & AP_PARAM_FLAG_ENABLE)) {
         // clear cached parameter count
-        _parameter_count = 0;
+        invalidate_count();
     }
     
     char name[AP_MAX_NAME_SIZE+1];
@@ -1111,6 +1335,12 @@ void AP_Param::save_io_handler(void)
     while (save_queue.pop(p)) {
         p.param->save_sync(p.force_save);
     }
+    if (save_flush_requested) {
+        save_flush_requested = false;
+        _storage_journal.flush();
+    } else {
+        _storage_journal.update();
+    }
 }
 
 /*
@@ -1119,11 +1349,21 @@ void AP_Param::save_io_handler(void)
 void AP_Param::flush(void)
 {
     uint16_t counter = 200; // 2 seconds max
-    while (counter-- && save_queue.available()) {
+    save_flush_requested = true;
+    while (counter-- && save_pending()) {
         hal.scheduler->delay(10);
     }
 }
 
+/*
+  return true if there are parameter saves not yet handed to the storage
+  driver
+*/
+bool AP_Param::save_pending(void)
+{
+    return save_queue.available() || _storage_journal.pending();
+}
+
 // Load the variable from EEPROM, if supported
 //
 bool AP_Param::load(void)
@@ -1185,7 +1425,7 @@ bool AP_Param::load(void)
     }
 
     // found it
-    _storage.read_block(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
+    _storage_journal.read_block(ap, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
     return true;
 }
 
@@ -1326,6 +1566,7 @@ bool AP_Param::load_all()
 {
     struct Param_header phdr;
     uint16_t ofs = sizeof(AP_Param::EEPROM_header);
+    bool found_sentinal = false;
 
     reload_defaults_file(false);
 
@@ -1335,12 +1576,13 @@ bool AP_Param::load_all()
     }
     
     while (ofs < _storage.size()) {
-        _storage.read_block(&phdr, ofs, sizeof(phdr));
+        _storage_journal.read_block(&phdr, ofs, sizeof(phdr));
         // note that this is an || not an && for robustness
         // against power off while adding a variable
         if (is_sentinal(phdr)) {
             // we've reached the sentinal
-            return true;
+            found_sentinal = true;
+            break;
         }
 
         const struct AP_Param::Info *info;
@@ -1348,15 +1590,22 @@ bool AP_Param::load_all()
 
         info = find_by_header(phdr, &ptr);
         if (info != nullptr) {
-            _storage.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
+            _storage_journal.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
         }
 
         ofs += type_size((enum ap_var_type)phdr.type) + sizeof(phdr);
     }
 
-    // we didn't find the sentinal
-    Debug("no sentinal in load_all");
-    return false;
+    // build the indexes now the enable parameters are loaded.
+    // Objects with pointer parameters are added when they are loaded
+    // by load_object_from_eeprom()
+    build_find_index();
+    build_scalar_index();
+
+    if (!found_sentinal) {
+        Debug("no sentinal in load_all");
+    }
+    return found_sentinal;
 }
 
 /*
@@ -1395,12 +1644,21 @@ void AP_Param::reload_defaults_file(bool last_pass)
    required for dynamically loaded objects
  */
 void AP_Param::load_object_from_eeprom(const void *object_pointer, const struct GroupInfo *group_info)
+{
+    load_object_group_from_eeprom(object_pointer, group_info);
+
+    // the object's parameters can now be found, so index them
+    build_find_index();
+    build_scalar_index();
+}
+
+void AP_Param::load_object_group_from_eeprom(const void *object_pointer, const struct GroupInfo *group_info)
 {
     struct Param_header phdr;
     uint16_t key;
 
     // reset cached param counter as we may be loading a dynamic var_info
-    _parameter_count = 0;
+    invalidate_count();
     
     if (!find_key_by_pointer(object_pointer, key)) {
         hal.console->printf("ERROR: Unable to find param pointer\n");
@@ -1415,12 +1673,12 @@ void AP_Param::load_object_from_eeprom(const void *object_pointer, const struct
             }
             const struct GroupInfo *ginfo = get_group_info(group_info[i]);
             if (ginfo != nullptr) {
-                load_object_from_eeprom((void *)(((ptrdiff_t)object_pointer)+new_offset), ginfo);
+                load_object_group_from_eeprom((void *)(((ptrdiff_t)object_pointer)+new_offset), ginfo);
             }
         }
         uint16_t ofs = sizeof(AP_Param::EEPROM_header);
         while (ofs < _storage.size()) {
-            _storage.read_block(&phdr, ofs, sizeof(phdr));
+            _storage_journal.read_block(&phdr, ofs, sizeof(phdr));
             // note that this is an || not an && for robustness
             // against power off while adding a variable
             if (is_sentinal(phdr)) {
@@ -1434,7 +1692,7 @@ void AP_Param::load_object_from_eeprom(const void *object_pointer, const struct
                 info = find_by_header(phdr, &ptr);
                 if (info != nullptr) {
                     if ((ptrdiff_t)ptr == ((ptrdiff_t)object_pointer)+group_info[i].offset) {
-                        _storage.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
+                        _storage_journal.read_block(ptr, ofs+sizeof(phdr), type_size((enum ap_var_type)phdr.type));
                         break;
                     }
                 }
@@ -1679,7 +1937,7 @@ bool AP_Param::find_old_parameter(const struct ConversionInfo *info, AP_Param *v
     }
 
     // load the old value from EEPROM
-    _storage.read_block(value, pofs+sizeof(header), type_size((enum ap_var_type)header.type));
+    _storage_journal.read_block(value, pofs+sizeof(header), type_size((enum ap_var_type)header.type));
     return true;
 }
 
@@ -2179,6 +2437,119 @@ uint16_t AP_Param::count_parameters(void)
     return ret;
 }
 
+// true if the scalar index matches the current set of parameters
+bool AP_Param::scalar_index_valid(void)
+{
+    return _scalar_index_count != 0 && _scalar_index_generation == _count_generation;
+}
+
+/*
+  build the scalar index from the visible scalar parameters, replacing
+  any earlier index, and work out the crc of their names and types. If
+  there is no memory for it find_by_index() walks the tree instead
+ */
+void AP_Param::build_scalar_index(void)
+{
+#if AP_PARAM_SCALAR_INDEX_ENABLED
+    // an invalidation while we build leaves the index marked out of date
+    const uint8_t generation = _count_generation;
+    const uint16_t count = count_parameters();
+    struct scalar_index_entry *index = (struct scalar_index_entry *)calloc(count, sizeof(index[0]));
+    uint32_t crc = 0;
+    uint16_t n = 0;
+    if (index != nullptr) {
+        ParamToken token;
+        enum ap_var_type type;
+        for (AP_Param *ap = AP_Param::first(&token, &type);
+             ap != nullptr && n < count;
+             ap = AP_Param::next_scalar(&token, &type)) {
+            char name[AP_MAX_NAME_SIZE+1];
+            ap->copy_name_token(token, name, sizeof(name), true);
+            name[AP_MAX_NAME_SIZE] = 0;
+            const uint8_t type8 = type;
+            crc = crc_crc32(crc, (const uint8_t *)name, strlen(name));
+            crc = crc_crc32(crc, &type8, 1);
+
+            index[n].ap = ap;
+            index[n].token = token;
+            index[n].type = type;
+            strncpy(index[n].name, name, AP_MAX_NAME_SIZE);
+            n++;
+        }
+    }
+    if (n != count) {
+        // the count is out of date, so the index would be too
+        free(index);
+        index = nullptr;
+        n = 0;
+    }
+
+    struct scalar_index_entry *old_index;
+    {
+        WITH_SEMAPHORE(scalar_index_sem);
+        old_index = _scalar_index;
+        _scalar_index = index;
+        _scalar_index_count = n;
+        _scalar_index_names_crc = crc;
+        _scalar_index_generation = generation;
+    }
+    free(old_index);
+#endif
+}
+
+/*
+  forget the parameter count, and with it the scalar index, when the
+  set of parameters may have changed
+ */
+void AP_Param::invalidate_count(void)
+{
+    _parameter_count = 0;
+    _count_generation++;
+}
+
+/*
+  hash of all scalar parameters. The names and types are hashed in
+  index order, then the values. With the scalar index the names part
+  is cached, so only the values need to be read. The crc32 is folded
+  to 24 bits so that it survives being sent as the float value of an
+  AP_PARAM_INT32 PARAM_VALUE
+ */
+uint32_t AP_Param::parameter_set_hash(void)
+{
+    WITH_SEMAPHORE(scalar_index_sem);
+
+    uint32_t crc;
+    ParamToken token;
+    enum ap_var_type type;
+    if (scalar_index_valid()) {
+        crc = _scalar_index_names_crc;
+        for (uint16_t i=0; i<_scalar_index_count; i++) {
+            const float value = _scalar_index[i].ap->cast_to_float((enum ap_var_type)_scalar_index[i].type);
+            crc = crc_crc32(crc, (const uint8_t *)&value, sizeof(value));
+        }
+    } else {
+        crc = 0;
+        for (AP_Param *ap = AP_Param::first(&token, &type);
+             ap != nullptr;
+             ap = AP_Param::next_scalar(&token, &type)) {
+            char name[AP_MAX_NAME_SIZE+1];
+            ap->copy_name_token(token, name, sizeof(name), true);
+            name[AP_MAX_NAME_SIZE] = 0;
+            const uint8_t type8 = type;
+            crc = crc_crc32(crc, (const uint8_t *)name, strlen(name));
+            crc = crc_crc32(crc, &type8, 1);
+        }
+        for (AP_Param *ap = AP_Param::first(&token, &type);
+             ap != nullptr;
+             ap = AP_Param::next_scalar(&token, &type)) {
+            const float value = ap->cast_to_float(type);
+            crc = crc_crc32(crc, (const uint8_t *)&value, sizeof(value));
+        }
+    }
+
+    return (crc ^ (crc >> 24)) & 0xFFFFFF;
+}
+
 /*
   set a default value by name
  */
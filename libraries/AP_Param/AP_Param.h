@@ -137,6 +137,7 @@ enum ap_var_type {
 };
 
 class StorageAccess; // forward
+class StorageJournal; // forward
 
 /// Base class for variables.
 ///
@@ -278,6 +279,8 @@ public:
 
     /// Find a variable by index.
     ///
+    /// This is a table lookup while the scalar index is up to date,
+    /// otherwise it walks the parameter tree.
     ///
     /// @param  idx             The index of the variable
     /// @return                 A pointer to the variable, or nullptr if
@@ -285,6 +288,19 @@ public:
     ///
     static AP_Param * find_by_index(uint16_t idx, enum ap_var_type *ptype, ParamToken *token);
 
+    /// Find a variable by index in the scalar index only, along with
+    /// its name. Used by parameter downloads, which step through the
+    /// tree with next_scalar() when this returns nullptr.
+    ///
+    /// @param  idx             The index of the variable
+    /// @param  name            Filled in with the name, which takes
+    ///                         AP_MAX_NAME_SIZE+1 bytes
+    /// @return                 A pointer to the variable, or nullptr if
+    ///                         it does not exist or the index is out
+    ///                         of date or being replaced.
+    ///
+    static AP_Param * find_by_index_with_name(uint16_t idx, enum ap_var_type *ptype, ParamToken *token, char *name);
+
     
     /// Find a variable by pointer
     ///
@@ -316,8 +332,11 @@ public:
     void save_sync(bool force_save=false);
 
     /// flush all pending parameter saves
-    /// used on reboot
+    /// used on reboot and before arming
     static void flush(void);
+
+    /// true if there are parameter saves not yet handed to the storage driver
+    static bool save_pending(void);
     
     /// Save the current value of the variable to storage, async interface
     ///
@@ -423,6 +442,11 @@ public:
     // count of parameters in tree
     static uint16_t count_parameters(void);
 
+    // 24 bit hash of the names, types and values of all scalar
+    // parameters in index order. A GCS holding a copy of the
+    // parameters with the same hash can skip downloading them
+    static uint32_t parameter_set_hash(void);
+
     static void set_hide_disabled_groups(bool value) { _hide_disabled_groups = value; }
 
     // set frame type flags. Used to unhide frame specific parameters
@@ -451,6 +475,10 @@ public:
 #endif // AP_PARAM_KEY_DUMP
     
 private:
+    // let the benchmarks and tests build the indexes without load_all()
+    friend class AP_Param_Benchmark;
+    friend class AP_Param_Test;
+
     /// EEPROM header
     ///
     /// This structure is placed at the head of the EEPROM to indicate
@@ -559,6 +587,25 @@ private:
                                     ptrdiff_t group_offset,
                                     const struct GroupInfo *group_info,
                                     enum ap_var_type *ptype);
+    static AP_Param *           find_in_var(
+                                    const char *name,
+                                    uint16_t vindex,
+                                    enum ap_var_type *ptype);
+    static AP_Param *           find_indexed(
+                                    const char *name,
+                                    enum ap_var_type *ptype);
+    static AP_Param *           find_in_index(
+                                    const char *name,
+                                    enum ap_var_type *ptype);
+    static void                 load_object_group_from_eeprom(
+                                    const void *object_pointer,
+                                    const struct GroupInfo *group_info);
+    static uint16_t             name_hash(const char *name);
+    static bool                 read_scalar_index(uint16_t idx, AP_Param *&ap,
+                                    enum ap_var_type *ptype,
+                                    ParamToken *token, char *name);
+    static bool                 scalar_index_valid(void);
+    static void                 invalidate_count(void);
     static void                 write_sentinal(uint16_t ofs);
     static uint16_t             get_key(const Param_header &phdr);
     static void                 set_key(Param_header &phdr, uint16_t key);
@@ -605,6 +652,7 @@ private:
     void send_parameter(const char *name, enum ap_var_type param_header_type, uint8_t idx) const;
     
     static StorageAccess        _storage;
+    static StorageJournal       _storage_journal;
     static uint16_t             _num_vars;
     static uint16_t             _parameter_count;
     static const struct Info *  _var_info;
@@ -626,6 +674,47 @@ private:
 
     static bool _hide_disabled_groups;
 
+    // build the indexes used by find() and find_by_index(). Called on
+    // the main thread by load_all() and load_object_from_eeprom()
+    static void build_find_index(void);
+    static void build_scalar_index(void);
+
+    /*
+      index used by find(). Each entry gives the
+      top level variable holding a parameter, sorted by a hash of the
+      parameter name. Only the variable is stored, as pointers in
+      groups may change, and find_in_var() confirms the name
+    */
+    struct PACKED find_index_entry {
+        uint16_t hash;
+        uint16_t vindex;
+    };
+    static struct find_index_entry *_find_index;
+    static uint16_t _find_index_count;
+
+    /*
+      every scalar parameter in index order with its name, so
+      find_by_index() and parameter downloads don't have to walk the
+      tree. It is only read once built. It is used while
+      _scalar_index_generation matches _count_generation, which
+      changes whenever the parameter count is invalidated, such as
+      when a group is enabled. Until the next rebuild, lookups walk
+      the tree
+    */
+    struct scalar_index_entry {
+        AP_Param *ap;
+        ParamToken token;
+        uint8_t type;
+        char name[AP_MAX_NAME_SIZE]; // not null terminated at full length
+    };
+    static struct scalar_index_entry *_scalar_index;
+    static uint16_t _scalar_index_count;
+    // crc of the names and types in the index, the part of
+    // parameter_set_hash() that only changes with the index
+    static uint32_t _scalar_index_names_crc;
+    static uint8_t _scalar_index_generation;
+    static volatile uint8_t _count_generation;
+
     // support for background saving of parameters. We pack it to reduce memory for the
     // queue
     struct PACKED param_save {
@@ -634,6 +723,7 @@ private:
     };
     static ObjectBuffer<struct param_save> save_queue;
     static bool registered_save_handler;
+    static volatile bool save_flush_requested;
 
     // background function for saving parameters
     void save_io_handler(void);
@@ -0,0 +1,160 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  cost of looking up parameters by name, as done for each PARAM_SET
+  and PARAM_REQUEST_READ message and by scripts, and by index, as done
+  for PARAM_REQUEST_READ by index, over a table of 48 groups of 16
+  parameters, similar in size to a vehicle
+ */
+#include <AP_gbenchmark.h>
+
+#include <stdio.h>
+
+#include <AP_Param/AP_Param.h>
+
+#define BENCH_GROUP_PARAMS 16
+#define BENCH_NUM_GROUPS 48
+
+class BenchGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Float p[BENCH_GROUP_PARAMS];
+};
+
+#define BENCH_PARAM(n) AP_GROUPINFO("PARAM" #n, n, BenchGroup, p[n], 0)
+
+const AP_Param::GroupInfo BenchGroup::var_info[] = {
+    BENCH_PARAM(0), BENCH_PARAM(1), BENCH_PARAM(2), BENCH_PARAM(3),
+    BENCH_PARAM(4), BENCH_PARAM(5), BENCH_PARAM(6), BENCH_PARAM(7),
+    BENCH_PARAM(8), BENCH_PARAM(9), BENCH_PARAM(10), BENCH_PARAM(11),
+    BENCH_PARAM(12), BENCH_PARAM(13), BENCH_PARAM(14), BENCH_PARAM(15),
+    AP_GROUPEND
+};
+
+static BenchGroup groups[BENCH_NUM_GROUPS];
+
+#define BENCH_GROUP(n) { AP_PARAM_GROUP, "G" #n "_", n, &groups[n], { group_info : BenchGroup::var_info }, 0 }
+
+static const AP_Param::Info var_info[] = {
+    BENCH_GROUP(0), BENCH_GROUP(1), BENCH_GROUP(2), BENCH_GROUP(3),
+    BENCH_GROUP(4), BENCH_GROUP(5), BENCH_GROUP(6), BENCH_GROUP(7),
+    BENCH_GROUP(8), BENCH_GROUP(9), BENCH_GROUP(10), BENCH_GROUP(11),
+    BENCH_GROUP(12), BENCH_GROUP(13), BENCH_GROUP(14), BENCH_GROUP(15),
+    BENCH_GROUP(16), BENCH_GROUP(17), BENCH_GROUP(18), BENCH_GROUP(19),
+    BENCH_GROUP(20), BENCH_GROUP(21), BENCH_GROUP(22), BENCH_GROUP(23),
+    BENCH_GROUP(24), BENCH_GROUP(25), BENCH_GROUP(26), BENCH_GROUP(27),
+    BENCH_GROUP(28), BENCH_GROUP(29), BENCH_GROUP(30), BENCH_GROUP(31),
+    BENCH_GROUP(32), BENCH_GROUP(33), BENCH_GROUP(34), BENCH_GROUP(35),
+    BENCH_GROUP(36), BENCH_GROUP(37), BENCH_GROUP(38), BENCH_GROUP(39),
+    BENCH_GROUP(40), BENCH_GROUP(41), BENCH_GROUP(42), BENCH_GROUP(43),
+    BENCH_GROUP(44), BENCH_GROUP(45), BENCH_GROUP(46), BENCH_GROUP(47),
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+class AP_Param_Benchmark {
+public:
+    static void build_find_index() { AP_Param::build_find_index(); }
+    static void build_scalar_index() { AP_Param::build_scalar_index(); }
+};
+
+static char names[BENCH_NUM_GROUPS * BENCH_GROUP_PARAMS][AP_MAX_NAME_SIZE+1];
+
+static void setup_names()
+{
+    for (uint16_t g=0; g<BENCH_NUM_GROUPS; g++) {
+        for (uint16_t i=0; i<BENCH_GROUP_PARAMS; i++) {
+            snprintf(names[g*BENCH_GROUP_PARAMS+i], sizeof(names[0]), "G%u_PARAM%u", g, i);
+        }
+    }
+    AP_Param_Benchmark::build_find_index();
+}
+
+// argument is the stride through the table, so lookups are not all
+// for neighbouring parameters
+static void BM_ParamFind(benchmark::State& state)
+{
+    setup_names();
+    const uint16_t count = BENCH_NUM_GROUPS * BENCH_GROUP_PARAMS;
+    uint16_t n = 0;
+
+    while (state.KeepRunning()) {
+        enum ap_var_type ptype;
+        AP_Param *ap = AP_Param::find(names[n], &ptype);
+        gbenchmark_escape(ap);
+        n = (n + state.range(0)) % count;
+    }
+}
+
+// a name that is not a parameter, which has to search the whole table
+static void BM_ParamFindMissing(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        enum ap_var_type ptype;
+        AP_Param *ap = AP_Param::find("G47_NOPARAM", &ptype);
+        gbenchmark_escape(ap);
+    }
+}
+
+static void BM_ParamSetByName(benchmark::State& state)
+{
+    setup_names();
+    const uint16_t count = BENCH_NUM_GROUPS * BENCH_GROUP_PARAMS;
+    uint16_t n = 0;
+    float value = 0;
+
+    while (state.KeepRunning()) {
+        bool ret = AP_Param::set_by_name(names[n], value);
+        gbenchmark_escape(&ret);
+        n = (n + 37) % count;
+        value += 1;
+    }
+}
+
+// lookup by index, as done for PARAM_REQUEST_READ of parameters
+// missed in a download, in order (argument 1) or scattered (argument 37)
+static void BM_ParamFindByIndex(benchmark::State& state)
+{
+    const uint16_t count = AP_Param::count_parameters();
+    AP_Param_Benchmark::build_scalar_index();
+    uint16_t n = 0;
+
+    while (state.KeepRunning()) {
+        enum ap_var_type ptype;
+        AP_Param::ParamToken token;
+        AP_Param *ap = AP_Param::find_by_index(n, &ptype, &token);
+        gbenchmark_escape(ap);
+        n = (n + state.range(0)) % count;
+    }
+}
+
+// the hash sent in reply to a _HASH_CHECK request
+static void BM_ParamSetHash(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        uint32_t hash = AP_Param::parameter_set_hash();
+        gbenchmark_escape(&hash);
+    }
+}
+
+BENCHMARK(BM_ParamFind)->Arg(1)->Arg(37);
+BENCHMARK(BM_ParamFindMissing);
+BENCHMARK(BM_ParamSetByName);
+BENCHMARK(BM_ParamFindByIndex)->Arg(1)->Arg(37);
+BENCHMARK(BM_ParamSetHash);
+
+BENCHMARK_MAIN()
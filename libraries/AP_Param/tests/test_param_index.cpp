@@ -0,0 +1,217 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AP_Math/crc.h>
+#include <AP_Param/AP_Param.h>
+
+#include <string>
+#include <vector>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+#define TEST_GROUP_PARAMS 4
+#define TEST_NUM_GROUPS 8
+
+class TestGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Float p[TEST_GROUP_PARAMS];
+    AP_Int16 q;
+};
+
+const AP_Param::GroupInfo TestGroup::var_info[] = {
+    AP_GROUPINFO("P0", 0, TestGroup, p[0], 0),
+    AP_GROUPINFO("P1", 1, TestGroup, p[1], 0),
+    AP_GROUPINFO("P2", 2, TestGroup, p[2], 0),
+    AP_GROUPINFO("P3", 3, TestGroup, p[3], 0),
+    AP_GROUPINFO("Q",  4, TestGroup, q, 0),
+    AP_GROUPEND
+};
+
+// a group which is hidden until it is enabled
+class TestEnableGroup {
+public:
+    static const struct AP_Param::GroupInfo var_info[];
+
+    AP_Int8 enable;
+    AP_Float p;
+    AP_Int32 q;
+};
+
+const AP_Param::GroupInfo TestEnableGroup::var_info[] = {
+    AP_GROUPINFO_FLAGS("ENABLE", 0, TestEnableGroup, enable, 0, AP_PARAM_FLAG_ENABLE),
+    AP_GROUPINFO("P", 1, TestEnableGroup, p, 0),
+    AP_GROUPINFO("Q", 2, TestEnableGroup, q, 0),
+    AP_GROUPEND
+};
+
+static AP_Int32 top;
+static AP_Vector3f vec;
+static TestGroup groups[TEST_NUM_GROUPS];
+static TestEnableGroup optional;
+
+#define TEST_GROUP(n) { AP_PARAM_GROUP, "G" #n "_", n, &groups[n], { group_info : TestGroup::var_info }, 0 }
+
+static const AP_Param::Info var_info[] = {
+    { AP_PARAM_INT32, "TOP", 20, &top, { def_value : 3 }, 0 },
+    TEST_GROUP(0), TEST_GROUP(1), TEST_GROUP(2), TEST_GROUP(3),
+    { AP_PARAM_GROUP, "OPT_", 21, &optional, { group_info : TestEnableGroup::var_info }, 0 },
+    TEST_GROUP(4), TEST_GROUP(5), TEST_GROUP(6), TEST_GROUP(7),
+    { AP_PARAM_VECTOR3F, "VEC", 22, &vec, { def_value : 0 }, 0 },
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+// builds the indexes as load_all() would, without storage
+class AP_Param_Test {
+public:
+    static void build_indexes() {
+        AP_Param::build_find_index();
+        AP_Param::build_scalar_index();
+    }
+    static void invalidate_count() { AP_Param::invalidate_count(); }
+};
+
+struct walked_param {
+    AP_Param *ap;
+    AP_Param::ParamToken token;
+    enum ap_var_type type;
+    std::string name;
+};
+
+// every scalar parameter in order, by walking the tree
+static std::vector<walked_param> walk(void)
+{
+    std::vector<walked_param> params;
+    AP_Param::ParamToken token;
+    enum ap_var_type type;
+    for (AP_Param *ap = AP_Param::first(&token, &type);
+         ap != nullptr;
+         ap = AP_Param::next_scalar(&token, &type)) {
+        char name[AP_MAX_NAME_SIZE+1];
+        ap->copy_name_token(token, name, sizeof(name), true);
+        name[AP_MAX_NAME_SIZE] = 0;
+        params.push_back(walked_param { ap, token, type, name });
+    }
+    return params;
+}
+
+// the hash of the walked parameters, as parameter_set_hash() documents it
+static uint32_t walk_hash(const std::vector<walked_param> &params)
+{
+    uint32_t crc = 0;
+    for (const walked_param &p : params) {
+        const uint8_t type8 = p.type;
+        crc = crc_crc32(crc, (const uint8_t *)p.name.c_str(), p.name.size());
+        crc = crc_crc32(crc, &type8, 1);
+    }
+    for (const walked_param &p : params) {
+        const float value = p.ap->cast_to_float(p.type);
+        crc = crc_crc32(crc, (const uint8_t *)&value, sizeof(value));
+    }
+    return (crc ^ (crc >> 24)) & 0xFFFFFF;
+}
+
+static bool same_token(const AP_Param::ParamToken &a, const AP_Param::ParamToken &b)
+{
+    return a.key == b.key && a.idx == b.idx && a.group_element == b.group_element;
+}
+
+// check find_by_index() against the walk, in order and scattered
+static void check_find_by_index(const std::vector<walked_param> &params)
+{
+    const uint16_t n = params.size();
+    for (uint16_t i=0; i<n+2; i++) {
+        const uint16_t idx = (i * 37) % (n + 2);
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+        AP_Param *ap = AP_Param::find_by_index(idx, &type, &token);
+        if (idx >= n) {
+            EXPECT_EQ(nullptr, ap) << "index " << idx;
+            continue;
+        }
+        EXPECT_EQ(params[idx].ap, ap) << "index " << idx;
+        EXPECT_EQ(params[idx].type, type) << "index " << idx;
+        EXPECT_TRUE(same_token(params[idx].token, token)) << "index " << idx;
+    }
+}
+
+// check find_by_index_with_name() against the walk
+static void check_find_by_index_with_name(const std::vector<walked_param> &params)
+{
+    for (uint16_t i=0; i<params.size(); i++) {
+        AP_Param::ParamToken token;
+        enum ap_var_type type;
+        char name[AP_MAX_NAME_SIZE+1];
+        AP_Param *ap = AP_Param::find_by_index_with_name(i, &type, &token, name);
+        EXPECT_EQ(params[i].ap, ap) << "index " << i;
+        EXPECT_EQ(params[i].type, type) << "index " << i;
+        EXPECT_TRUE(same_token(params[i].token, token)) << "index " << i;
+        EXPECT_STREQ(params[i].name.c_str(), name) << "index " << i;
+    }
+}
+
+TEST(ParamIndex, FindByIndex)
+{
+    AP_Param_Test::build_indexes();
+    const std::vector<walked_param> params = walk();
+    EXPECT_EQ(params.size(), AP_Param::count_parameters());
+    check_find_by_index(params);
+    check_find_by_index_with_name(params);
+
+    AP_Param::ParamToken token;
+    char name[AP_MAX_NAME_SIZE+1];
+    EXPECT_EQ(nullptr, AP_Param::find_by_index_with_name(params.size(), nullptr, &token, name));
+}
+
+TEST(ParamIndex, SetHash)
+{
+    AP_Param_Test::build_indexes();
+    const std::vector<walked_param> params = walk();
+    const uint32_t hash = AP_Param::parameter_set_hash();
+    EXPECT_EQ(walk_hash(params), hash);
+
+    // sent as the float value of an int32 parameter
+    EXPECT_EQ(hash, (uint32_t)(float)(int32_t)hash);
+
+    // values are read for each hash
+    groups[2].p[3].set(1.5f);
+    EXPECT_NE(hash, AP_Param::parameter_set_hash());
+    EXPECT_EQ(walk_hash(params), AP_Param::parameter_set_hash());
+    groups[2].p[3].set(0);
+    EXPECT_EQ(hash, AP_Param::parameter_set_hash());
+}
+
+TEST(ParamIndex, ParameterSetChanges)
+{
+    AP_Param_Test::build_indexes();
+    const std::vector<walked_param> before = walk();
+
+    // enabling the group shows its parameters, which leaves the index
+    // out of date until it is built again
+    optional.enable.set(1);
+    AP_Param_Test::invalidate_count();
+    const std::vector<walked_param> after = walk();
+    ASSERT_EQ(before.size() + 2, after.size());
+    EXPECT_EQ(after.size(), AP_Param::count_parameters());
+
+    AP_Param::ParamToken token;
+    char name[AP_MAX_NAME_SIZE+1];
+    EXPECT_EQ(nullptr, AP_Param::find_by_index_with_name(0, nullptr, &token, name));
+    check_find_by_index(after);
+    EXPECT_EQ(walk_hash(after), AP_Param::parameter_set_hash());
+
+    AP_Param_Test::build_indexes();
+    check_find_by_index(after);
+    check_find_by_index_with_name(after);
+    EXPECT_EQ(walk_hash(after), AP_Param::parameter_set_hash());
+
+    optional.enable.set(0);
+    AP_Param_Test::invalidate_count();
+    AP_Param_Test::build_indexes();
+    check_find_by_index_with_name(before);
+}
+
+AP_GTEST_MAIN()
@@ -100,3 +100,25 @@ uint8_t *AP_ROMFS::find_decompress(const char *name, uint32_t &size)
     size = decompressed_size;
     return decompressed_data;
 }
+
+/*
+  list the files directly within a directory, returning the name of
+  the file relative to the directory
+*/
+const char *AP_ROMFS::dir_list(const char *dirname, uint16_t &ofs)
+{
+    const size_t dlen = strlen(dirname);
+    for ( ; ofs < ARRAY_SIZE(files); ofs++) {
+        const char *filename = files[ofs].filename;
+        if (strncmp(dirname, filename, dlen) != 0 || filename[dlen] != '/') {
+            continue;
+        }
+        if (strchr(&filename[dlen+1], '/') != nullptr) {
+            // in a sub-directory
+            continue;
+        }
+        ofs++;
+        return &filename[dlen+1];
+    }
+    return nullptr;
+}
@@ -11,6 +11,11 @@ public:
     // call free on the return value after use. The next byte after
     // the file data is guaranteed to be null.
     static uint8_t *find_decompress(const char *name, uint32_t &size);
+
+    // return the name of the next file directly within a directory,
+    // starting with ofs at zero. Returns nullptr when there are no
+    // more files
+    static const char *dir_list(const char *dirname, uint16_t &ofs);
     
 private:
     // find an embedded file
@@ -25,6 +25,7 @@
 #include <AP_Vehicle/AP_Vehicle.h>
 #include <DataFlash/DataFlash.h>
 #include <AP_InertialSensor/AP_InertialSensor.h>
+#include <GCS_MAVLink/GCS.h>
 
 #include <stdio.h>
 
@@ -34,7 +35,11 @@
 #define SCHEDULER_DEFAULT_LOOP_RATE  50
 #endif
 
-#define debug(level, fmt, args...)   do { if ((level) <= _debug.get()) { hal.console->printf(fmt, ##args); }} while (0)
+// SCHED_DEBUG value that only sends task statistics, without the
+// slip and overrun messages of the lower levels
+#define SCHEDULER_DEBUG_TASK_STATS 4
+
+#define debug(level, fmt, args...)   do { if ((level) <= _debug.get() && _debug.get() < SCHEDULER_DEBUG_TASK_STATS) { hal.console->printf(fmt, ##args); }} while (0)
 
 extern const AP_HAL::HAL& hal;
 
@@ -43,8 +48,8 @@ int8_t AP_Scheduler::current_task = -1;
 const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @Param: DEBUG
     // @DisplayName: Scheduler debug level
-    // @Description: Set to non-zero to enable scheduler debug messages. When set to show "Slips" the scheduler will display a message whenever a scheduled task is delayed due to too much CPU load. When set to ShowOverruns the scheduled will display a message whenever a task takes longer than the limit promised in the task table.
-    // @Values: 0:Disabled,2:ShowSlips,3:ShowOverruns
+    // @Description: Set to non-zero to enable scheduler debug messages. When set to show "Slips" the scheduler will display a message whenever a scheduled task is delayed due to too much CPU load. When set to ShowOverruns the scheduled will display a message whenever a task takes longer than the limit promised in the task table. When set to ShowTaskStats the run time statistics of the three most expensive tasks are sent to the GCS as text messages each time performance is logged, which is every 5 to 10 seconds depending on the vehicle, without the slip and overrun messages. A GCS can also request the statistics at any time with MAV_CMD_USER_1, whatever this is set to.
+    // @Values: 0:Disabled,2:ShowSlips,3:ShowOverruns,4:ShowTaskStats
     // @User: Advanced
     AP_GROUPINFO("DEBUG",    0, AP_Scheduler, _debug, 0),
 
@@ -56,6 +61,14 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("LOOP_RATE",  1, AP_Scheduler, _loop_rate_hz, SCHEDULER_DEFAULT_LOOP_RATE),
 
+    // @Param: OPTIONS
+    // @DisplayName: Scheduling options
+    // @Description: Bitmask of scheduler options. When DeadlineOrdering is set the scheduler keeps the next due tick of each task in a priority queue, runs due tasks in order of the tick at which they would slip, and uses the measured run time of each task rather than the limit in the task table to decide whether it fits in the time remaining. This only takes effect on restart.
+    // @Bitmask: 0:DeadlineOrdering
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("OPTIONS",  2, AP_Scheduler, _options, 0),
+
     AP_GROUPEND
 };
 
@@ -97,9 +110,48 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks, uint
     _tasks = tasks;
     _num_tasks = num_tasks;
     _last_run = new uint16_t[_num_tasks];
+    // work out the interval of each task once, so run() does not
+    // need a division per task per tick
+    _interval_ticks = new uint16_t[_num_tasks];
+    if (_last_run == nullptr || _interval_ticks == nullptr) {
+        AP_HAL::panic("AP_Scheduler: Failed to allocate task tables");
+    }
     memset(_last_run, 0, sizeof(_last_run[0]) * _num_tasks);
     _tick_counter = 0;
 
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        uint16_t interval_ticks = _loop_rate_hz / _tasks[i].rate_hz;
+        if (interval_ticks < 1) {
+            interval_ticks = 1;
+        }
+        _interval_ticks[i] = interval_ticks;
+    }
+
+    // per-task statistics are always kept, they are cheap to
+    // gather and are used for deadline scheduling and logging
+    perf_info.allocate_task_info(_num_tasks);
+
+    if (_options & SCHEDULER_OPTION_DEADLINE) {
+        _due_heap = new uint8_t[_num_tasks];
+        _next_due = new uint16_t[_num_tasks];
+        _due_list = new uint8_t[_num_tasks];
+        if (_due_heap == nullptr || _next_due == nullptr || _due_list == nullptr) {
+            // fall back to table order scheduling
+            delete[] _due_heap;
+            delete[] _next_due;
+            delete[] _due_list;
+            _due_heap = nullptr;
+            _next_due = nullptr;
+            _due_list = nullptr;
+        } else {
+            _due_heap_size = 0;
+            for (uint8_t i=0; i<_num_tasks; i++) {
+                _next_due[i] = _interval_ticks[i];
+                due_heap_push(i);
+            }
+        }
+    }
+
     // setup initial performance counters
     perf_info.set_loop_rate(get_loop_rate_hz());
     perf_info.reset();
@@ -119,9 +171,6 @@ void AP_Scheduler::tick(void)
  */
 void AP_Scheduler::run(uint32_t time_available)
 {
-    uint32_t run_started_usec = AP_HAL::micros();
-    uint32_t now = run_started_usec;
-
     if (_debug > 1 && _perf_counters == nullptr) {
         _perf_counters = new AP_HAL::Util::perf_counter_t[_num_tasks];
         if (_perf_counters != nullptr) {
@@ -131,81 +180,232 @@ void AP_Scheduler::run(uint32_t time_available)
         }
     }
 
-    for (uint8_t i=0; i<_num_tasks; i++) {
-        uint16_t dt = _tick_counter - _last_run[i];
-        uint16_t interval_ticks = _loop_rate_hz / _tasks[i].rate_hz;
-        if (interval_ticks < 1) {
-            interval_ticks = 1;
+    if (_due_heap != nullptr) {
+        time_available = run_deadline(time_available);
+    } else {
+        for (uint8_t i=0; i<_num_tasks; i++) {
+            uint16_t dt = _tick_counter - _last_run[i];
+            uint16_t interval_ticks = _interval_ticks[i];
+            if (dt < interval_ticks) {
+                // this task is not yet scheduled to run again
+                continue;
+            }
+            // this task is due to run. Do we have enough time to run it?
+            _task_time_allowed = _tasks[i].max_time_micros;
+
+            if (dt >= interval_ticks*2) {
+                // we've slipped a whole run of this task!
+                perf_info.task_slipped(i);
+                debug(2, "Scheduler slip task[%u-%s] (%u/%u/%u)\n",
+                      (unsigned)i,
+                      _tasks[i].name,
+                      (unsigned)dt,
+                      (unsigned)interval_ticks,
+                      (unsigned)_task_time_allowed);
+            }
+
+            if (_task_time_allowed > time_available) {
+                // not enough time to run this task.  Continue loop -
+                // maybe another task will fit into time remaining
+                continue;
+            }
+
+            const uint32_t time_taken = run_task(i);
+            if (time_taken >= time_available) {
+                time_available = 0;
+                break;
+            }
+            time_available -= time_taken;
+        }
+    }
+
+    // update number of spare microseconds
+    _spare_micros += time_available;
+
+    _spare_ticks++;
+    if (_spare_ticks == 32) {
+        _spare_ticks /= 2;
+        _spare_micros /= 2;
+    }
+}
+
+/*
+  run a single task, returning the number of microseconds it took
+ */
+uint32_t AP_Scheduler::run_task(uint8_t i)
+{
+    _task_time_started = AP_HAL::micros();
+    current_task = i;
+    if (_debug > 1 && _perf_counters && _perf_counters[i]) {
+        hal.util->perf_begin(_perf_counters[i]);
+    }
+    _tasks[i].function();
+    if (_debug > 1 && _perf_counters && _perf_counters[i]) {
+        hal.util->perf_end(_perf_counters[i]);
+    }
+    current_task = -1;
+
+    // record the tick counter when we ran. This drives
+    // when we next run the event
+    _last_run[i] = _tick_counter;
+
+    // work out how long the event actually took
+    const uint32_t time_taken = AP_HAL::micros() - _task_time_started;
+    const bool overrun = time_taken > _task_time_allowed;
+
+    if (overrun) {
+        // the event overran!
+        debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
+              (unsigned)i,
+              _tasks[i].name,
+              (unsigned)time_taken,
+              (unsigned)_task_time_allowed);
+    }
+#ifdef DEBUG_LOOP_TIME
+    times[i] = time_taken;
+#endif
+    perf_info.update_task_info(i, MIN(time_taken, (uint32_t)UINT16_MAX), overrun);
+
+    return time_taken;
+}
+
+/*
+  return true if task_a is due to run before task_b
+ */
+bool AP_Scheduler::due_before(uint8_t task_a, uint8_t task_b) const
+{
+    return (int16_t)(_next_due[task_a] - _next_due[task_b]) < 0;
+}
+
+void AP_Scheduler::due_heap_push(uint8_t task)
+{
+    uint8_t pos = _due_heap_size++;
+    while (pos > 0) {
+        const uint8_t parent = (pos - 1) / 2;
+        if (!due_before(task, _due_heap[parent])) {
+            break;
+        }
+        _due_heap[pos] = _due_heap[parent];
+        pos = parent;
+    }
+    _due_heap[pos] = task;
+}
+
+uint8_t AP_Scheduler::due_heap_pop(void)
+{
+    const uint8_t top = _due_heap[0];
+    const uint8_t last = _due_heap[--_due_heap_size];
+    uint8_t pos = 0;
+    while (true) {
+        uint8_t child = 2 * pos + 1;
+        if (child >= _due_heap_size) {
+            break;
+        }
+        if (child + 1 < _due_heap_size && due_before(_due_heap[child + 1], _due_heap[child])) {
+            child++;
         }
-        if (dt < interval_ticks) {
-            // this task is not yet scheduled to run again
+        if (!due_before(_due_heap[child], last)) {
+            break;
+        }
+        _due_heap[pos] = _due_heap[child];
+        pos = child;
+    }
+    _due_heap[pos] = last;
+    return top;
+}
+
+/*
+  deadline ordered scheduling. Only tasks which are due this tick are
+  looked at. They are run in order of the tick at which they would
+  slip a whole run, using the measured task time to decide if they
+  fit. Returns the number of microseconds left over
+ */
+uint32_t AP_Scheduler::run_deadline(uint32_t time_available)
+{
+    const uint16_t tick = _tick_counter;
+
+    // take all due tasks off the heap
+    uint8_t num_due = 0;
+    while (_due_heap_size > 0 &&
+           (int16_t)(tick - _next_due[_due_heap[0]]) >= 0) {
+        _due_list[num_due++] = due_heap_pop();
+    }
+
+    // sort by deadline, then by smallest slack. The list is short so
+    // an insertion sort is fine
+    for (uint8_t i=1; i<num_due; i++) {
+        const uint8_t task = _due_list[i];
+        const uint16_t deadline = _next_due[task] + _interval_ticks[task];
+        const uint16_t est = task_time_estimate(task);
+        uint8_t j = i;
+        while (j > 0) {
+            const uint8_t prev = _due_list[j-1];
+            const int16_t ddiff = (int16_t)(deadline - (uint16_t)(_next_due[prev] + _interval_ticks[prev]));
+            if (ddiff > 0 || (ddiff == 0 && est >= task_time_estimate(prev))) {
+                break;
+            }
+            _due_list[j] = prev;
+            j--;
+        }
+        _due_list[j] = task;
+    }
+
+    for (uint8_t n=0; n<num_due; n++) {
+        const uint8_t i = _due_list[n];
+        if (time_available == 0) {
+            // out of time, leave it due for the next tick
+            due_heap_push(i);
             continue;
         }
-        // this task is due to run. Do we have enough time to run it?
+
+        const uint16_t dt = tick - _last_run[i];
         _task_time_allowed = _tasks[i].max_time_micros;
 
-        if (dt >= interval_ticks*2) {
+        if (dt >= _interval_ticks[i]*2) {
             // we've slipped a whole run of this task!
+            perf_info.task_slipped(i);
             debug(2, "Scheduler slip task[%u-%s] (%u/%u/%u)\n",
                   (unsigned)i,
                   _tasks[i].name,
                   (unsigned)dt,
-                  (unsigned)interval_ticks,
+                  (unsigned)_interval_ticks[i],
                   (unsigned)_task_time_allowed);
         }
 
-        if (_task_time_allowed > time_available) {
-            // not enough time to run this task.  Continue loop -
-            // maybe another task will fit into time remaining
+        if (task_time_estimate(i) > time_available) {
+            // doesn't fit, it stays due. Decay its estimate so one
+            // long run can't keep it from running for ever
+            perf_info.task_deferred(i);
+            due_heap_push(i);
             continue;
         }
 
-        // run it
-        _task_time_started = now;
-        current_task = i;
-        if (_debug > 1 && _perf_counters && _perf_counters[i]) {
-            hal.util->perf_begin(_perf_counters[i]);
-        }
-        _tasks[i].function();
-        if (_debug > 1 && _perf_counters && _perf_counters[i]) {
-            hal.util->perf_end(_perf_counters[i]);
-        }
-        current_task = -1;
-
-        // record the tick counter when we ran. This drives
-        // when we next run the event
-        _last_run[i] = _tick_counter;
+        const uint32_t time_taken = run_task(i);
 
-        // work out how long the event actually took
-        now = AP_HAL::micros();
-        uint32_t time_taken = now - _task_time_started;
+        _next_due[i] = tick + _interval_ticks[i];
+        due_heap_push(i);
 
-        if (time_taken > _task_time_allowed) {
-            // the event overran!
-            debug(3, "Scheduler overrun task[%u-%s] (%u/%u)\n",
-                  (unsigned)i,
-                  _tasks[i].name,
-                  (unsigned)time_taken,
-                  (unsigned)_task_time_allowed);
-        }
-#ifdef DEBUG_LOOP_TIME
-            times[i] = time_taken;
-#endif
         if (time_taken >= time_available) {
             time_available = 0;
-            break;
+        } else {
+            time_available -= time_taken;
         }
-        time_available -= time_taken;
     }
 
-    // update number of spare microseconds
-    _spare_micros += time_available;
+    return time_available;
+}
 
-    _spare_ticks++;
-    if (_spare_ticks == 32) {
-        _spare_ticks /= 2;
-        _spare_micros /= 2;
+/*
+  expected run time of a task in microseconds. This is the measured
+  time if the task has run, otherwise the limit from the task table
+ */
+uint16_t AP_Scheduler::task_time_estimate(uint8_t i) const
+{
+    const AP::PerfInfo::TaskInfo *ti = perf_info.get_task_info(i);
+    if (ti == nullptr || ti->est_time_us == 0) {
+        return _tasks[i].max_time_micros;
     }
+    return ti->est_time_us;
 }
 
 /*
@@ -281,6 +481,9 @@ void AP_Scheduler::update_logging()
     if (debug_flags()) {
         perf_info.update_logging();
     }
+    if (_debug == SCHEDULER_DEBUG_TASK_STATS) {
+        send_task_stats(3, nullptr);
+    }
     if (_log_performance_bit != (uint32_t)-1 &&
         DataFlash_Class::instance()->should_log(_log_performance_bit)) {
         Log_Write_Performance();
@@ -302,6 +505,90 @@ void AP_Scheduler::Log_Write_Performance()
         load             : (uint16_t)(load_average() * 1000)
     };
     DataFlash_Class::instance()->WriteCriticalBlock(&pkt, sizeof(pkt));
+
+    Log_Write_TaskPerf();
+}
+
+// Write run time statistics for each task that ran since the last reset
+void AP_Scheduler::Log_Write_TaskPerf()
+{
+    const uint64_t now = AP_HAL::micros64();
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const AP::PerfInfo::TaskInfo *ti = perf_info.get_task_info(i);
+        if (ti == nullptr) {
+            return;
+        }
+        if (ti->tick_count == 0 && ti->slip_count == 0) {
+            continue;
+        }
+        struct log_TaskPerf pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_TASK_PERF_MSG),
+            time_us       : now,
+            name          : {},
+            tick_count    : (uint16_t)MIN(ti->tick_count, (uint32_t)UINT16_MAX),
+            max_time      : ti->max_time_us,
+            overrun_count : ti->overrun_count,
+            slip_count    : ti->slip_count,
+            hist          : {}
+        };
+        strncpy(pkt.name, _tasks[i].name, sizeof(pkt.name));
+        memcpy(pkt.hist, ti->histogram, sizeof(pkt.hist));
+        DataFlash_Class::instance()->WriteBlock(&pkt, sizeof(pkt));
+    }
+}
+
+/*
+  send the run time statistics of the num_report tasks which used the
+  most time since the last reset, to the given link or to all links if
+  it is null. The statistics are reset by update_logging(), so they
+  cover the time since it was last called
+ */
+void AP_Scheduler::send_task_stats(uint8_t num_report, GCS_MAVLINK *link) const
+{
+    num_report = MIN(num_report, SCHEDULER_TASK_STATS_MAX_REPORT);
+    int16_t top[SCHEDULER_TASK_STATS_MAX_REPORT];
+    for (uint8_t j=0; j<num_report; j++) {
+        top[j] = -1;
+    }
+    for (uint8_t i=0; i<_num_tasks; i++) {
+        const AP::PerfInfo::TaskInfo *ti = perf_info.get_task_info(i);
+        if (ti == nullptr) {
+            return;
+        }
+        if (ti->tick_count == 0) {
+            continue;
+        }
+        for (uint8_t j=0; j<num_report; j++) {
+            if (top[j] == -1 ||
+                ti->elapsed_time_us > perf_info.get_task_info(top[j])->elapsed_time_us) {
+                for (uint8_t k=num_report-1; k>j; k--) {
+                    top[k] = top[k-1];
+                }
+                top[j] = i;
+                break;
+            }
+        }
+    }
+    for (uint8_t j=0; j<num_report; j++) {
+        if (top[j] == -1) {
+            break;
+        }
+        const AP::PerfInfo::TaskInfo *ti = perf_info.get_task_info(top[j]);
+        char text[MAVLINK_MSG_STATUSTEXT_FIELD_TEXT_LEN+1];
+        hal.util->snprintf(text, sizeof(text),
+                           "TASK %s n=%lu avg=%lu max=%u ovr=%u slp=%u",
+                           _tasks[top[j]].name,
+                           (unsigned long)ti->tick_count,
+                           (unsigned long)(ti->elapsed_time_us / ti->tick_count),
+                           (unsigned)ti->max_time_us,
+                           (unsigned)ti->overrun_count,
+                           (unsigned)ti->slip_count);
+        if (link != nullptr) {
+            link->send_text(MAV_SEVERITY_INFO, "%s", text);
+        } else {
+            gcs().send_text(MAV_SEVERITY_INFO, "%s", text);
+        }
+    }
 }
 
 namespace AP {
@@ -27,6 +27,11 @@
 
 #define AP_SCHEDULER_NAME_INITIALIZER(_name) .name = #_name,
 
+// most tasks whose statistics can be sent in one go
+#define SCHEDULER_TASK_STATS_MAX_REPORT 8
+
+class GCS_MAVLINK;
+
 
 
 
@@ -90,6 +95,13 @@ public:
     // write out PERF message to dataflash
     void Log_Write_Performance();
 
+    // write out per-task TASK messages to dataflash
+    void Log_Write_TaskPerf();
+
+    // send the statistics of the num_report most expensive tasks as
+    // text, to one link or to all links if link is null
+    void send_task_stats(uint8_t num_report, GCS_MAVLINK *link) const;
+
     // call when one tick has passed
     void tick(void);
 
@@ -179,6 +191,13 @@ private:
 
     // loop rate in Hz as set at startup
     AP_Int16 _active_loop_rate_hz;
+
+    // scheduler options
+    AP_Int8 _options;
+
+    enum {
+        SCHEDULER_OPTION_DEADLINE = (1U<<0),
+    };
     
     // calculated loop period in usec
     uint16_t _loop_period_us;
@@ -199,6 +218,26 @@ private:
     // tick counter at the time we last ran each task
     uint16_t *_last_run;
 
+    // number of ticks between runs of each task, calculated at init
+    uint16_t *_interval_ticks;
+
+    // deadline scheduling: min-heap of task numbers ordered by the
+    // tick each task is next due to run
+    uint8_t *_due_heap;
+    uint8_t _due_heap_size;
+    uint16_t *_next_due;
+
+    // scratch list of the tasks due on this tick
+    uint8_t *_due_list;
+
+    uint32_t run_task(uint8_t i);
+    uint32_t run_deadline(uint32_t time_available);
+    uint16_t task_time_estimate(uint8_t i) const;
+    bool due_before(uint8_t task_a, uint8_t task_b) const;
+    void due_heap_push(uint8_t task);
+    uint8_t due_heap_pop(void);
+
+
     // number of microseconds allowed for the current task
     uint32_t _task_time_allowed;
 
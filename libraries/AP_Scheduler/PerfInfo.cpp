@@ -20,6 +20,98 @@ void AP::PerfInfo::reset()
     long_running = 0;
     sigma_time = 0;
     sigmasquared_time = 0;
+
+    if (_task_info != nullptr) {
+        for (uint8_t i=0; i<_num_tasks; i++) {
+            // keep est_time_us, it is used for scheduling decisions
+            _task_info[i].max_time_us = 0;
+            _task_info[i].elapsed_time_us = 0;
+            _task_info[i].tick_count = 0;
+            _task_info[i].overrun_count = 0;
+            _task_info[i].slip_count = 0;
+            memset(_task_info[i].histogram, 0, sizeof(_task_info[i].histogram));
+        }
+    }
+}
+
+// allocate_task_info - allocate per-task statistics
+void AP::PerfInfo::allocate_task_info(uint8_t num_tasks)
+{
+    if (_task_info != nullptr) {
+        return;
+    }
+    _task_info = new TaskInfo[num_tasks];
+    if (_task_info == nullptr) {
+        return;
+    }
+    memset(_task_info, 0, sizeof(TaskInfo) * num_tasks);
+    _num_tasks = num_tasks;
+}
+
+// update_task_info - record the run time of a single task. This is
+// called for every task run so must stay cheap
+void AP::PerfInfo::update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun)
+{
+    if (_task_info == nullptr || task_index >= _num_tasks) {
+        return;
+    }
+    TaskInfo &ti = _task_info[task_index];
+    // the estimate follows a new peak immediately and decays
+    // towards the typical run time by 1/16th per run
+    if (task_time_us >= ti.est_time_us) {
+        ti.est_time_us = task_time_us;
+    } else {
+        ti.est_time_us -= (ti.est_time_us - task_time_us) / 16;
+    }
+    if (task_time_us > ti.max_time_us) {
+        ti.max_time_us = task_time_us;
+    }
+    ti.elapsed_time_us += task_time_us;
+    ti.tick_count++;
+    if (overrun) {
+        ti.overrun_count++;
+    }
+
+    uint8_t bucket = 0;
+    const uint16_t scaled = task_time_us >> 4;
+    if (scaled != 0) {
+        bucket = 32 - __builtin_clz(scaled);
+        if (bucket >= PERF_TASK_HIST_BUCKETS) {
+            bucket = PERF_TASK_HIST_BUCKETS - 1;
+        }
+    }
+    ti.histogram[bucket]++;
+}
+
+// task_slipped - record that a task missed a whole run
+void AP::PerfInfo::task_slipped(uint8_t task_index)
+{
+    if (_task_info == nullptr || task_index >= _num_tasks) {
+        return;
+    }
+    _task_info[task_index].slip_count++;
+}
+
+// task_deferred - record that a due task was not run as its estimate
+// did not fit in the time left. The estimate only decays when the
+// task runs, so decay it here too or one long run could keep the task
+// from ever running again
+void AP::PerfInfo::task_deferred(uint8_t task_index)
+{
+    if (_task_info == nullptr || task_index >= _num_tasks) {
+        return;
+    }
+    TaskInfo &ti = _task_info[task_index];
+    ti.est_time_us -= ti.est_time_us / 16;
+}
+
+// get_task_info - return statistics for a task, or nullptr if not available
+const AP::PerfInfo::TaskInfo *AP::PerfInfo::get_task_info(uint8_t task_index) const
+{
+    if (_task_info == nullptr || task_index >= _num_tasks) {
+        return nullptr;
+    }
+    return &_task_info[task_index];
 }
 
 // ignore_loop - ignore this loop from performance measurements (used to reduce false positive when arming)
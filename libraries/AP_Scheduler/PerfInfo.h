@@ -2,6 +2,9 @@
 
 #include <stdint.h>
 
+// number of log2 buckets in the per-task run time histogram
+#define PERF_TASK_HIST_BUCKETS 8
+
 namespace AP {
 
 class PerfInfo {
@@ -26,6 +29,25 @@ public:
 
     void update_logging();
 
+    // per-task run time statistics, indexed by scheduler task number
+    struct TaskInfo {
+        uint16_t est_time_us;      // decaying peak of run time
+        uint16_t max_time_us;
+        uint32_t elapsed_time_us;
+        uint32_t tick_count;
+        uint16_t overrun_count;
+        uint16_t slip_count;
+        // bucket 0 is under 16us, each following bucket doubles
+        uint16_t histogram[PERF_TASK_HIST_BUCKETS];
+    };
+
+    void allocate_task_info(uint8_t num_tasks);
+    void update_task_info(uint8_t task_index, uint16_t task_time_us, bool overrun);
+    void task_slipped(uint8_t task_index);
+    void task_deferred(uint8_t task_index);
+    const TaskInfo *get_task_info(uint8_t task_index) const;
+    uint8_t get_num_tasks() const { return _num_tasks; }
+
 private:
     uint16_t loop_rate_hz;
     uint16_t overtime_threshold_micros;
@@ -39,6 +61,10 @@ private:
     float filtered_loop_time;
     bool ignore_loop;
 
+    // per-task statistics, nullptr until allocate_task_info()
+    TaskInfo *_task_info = nullptr;
+    uint8_t _num_tasks = 0;
+
 };
 
 };
@@ -0,0 +1,58 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Scheduler/PerfInfo.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+TEST(PerfInfo, EstimateFollowsPeak)
+{
+    AP::PerfInfo perf;
+    perf.allocate_task_info(1);
+    perf.update_task_info(0, 100, false);
+    EXPECT_EQ(100, perf.get_task_info(0)->est_time_us);
+    perf.update_task_info(0, 900, true);
+    EXPECT_EQ(900, perf.get_task_info(0)->est_time_us);
+
+    // shorter runs bring it back down, to within the rounding of
+    // the 1/16th step
+    for (uint8_t i=0; i<100; i++) {
+        perf.update_task_info(0, 100, false);
+    }
+    EXPECT_LT(perf.get_task_info(0)->est_time_us, 100 + 16);
+}
+
+/*
+  a task whose estimate was raised above the loop budget by one long
+  run must not be deferred for ever, as it only decays when it runs
+ */
+TEST(PerfInfo, DeferredTaskEstimateDecays)
+{
+    const uint16_t budget_us = 2000;
+    AP::PerfInfo perf;
+    perf.allocate_task_info(2);
+    perf.update_task_info(1, 50000, true);
+
+    uint16_t skips = 0;
+    while (perf.get_task_info(1)->est_time_us > budget_us) {
+        perf.task_deferred(1);
+        skips++;
+        ASSERT_LT(skips, 1000);
+    }
+    // about one second at 50Hz
+    EXPECT_LE(skips, 60);
+
+    // the other task is not touched
+    EXPECT_EQ(0, perf.get_task_info(0)->est_time_us);
+}
+
+TEST(PerfInfo, BadTaskIndex)
+{
+    AP::PerfInfo perf;
+    perf.task_deferred(0);
+    perf.allocate_task_info(1);
+    perf.task_deferred(1);
+    EXPECT_EQ(nullptr, perf.get_task_info(1));
+}
+
+AP_GTEST_MAIN()
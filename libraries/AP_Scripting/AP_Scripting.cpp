@@ -16,9 +16,8 @@
 #include <AP_Scripting/AP_Scripting.h>
 #include <AP_HAL/AP_HAL.h>
 #include <GCS_MAVLink/GCS.h>
-#include <AP_ROMFS/AP_ROMFS.h>
 
-#include "lua_bindings.h"
+#include "lua_scripts.h"
 
 // ensure that we have a set of stack sizes, and enforce constraints around it
 // except for the minimum size, these are allowed to be defined by the build system
@@ -36,6 +35,14 @@
 static_assert(SCRIPTING_STACK_SIZE >= SCRIPTING_STACK_MIN_SIZE, "Scripting requires a larger minimum stack size");
 static_assert(SCRIPTING_STACK_SIZE <= SCRIPTING_STACK_MAX_SIZE, "Scripting requires a smaller stack size");
 
+#ifndef SCRIPTING_HEAP_SIZE
+  #if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    #define SCRIPTING_HEAP_SIZE (100 * 1024)
+  #else
+    #define SCRIPTING_HEAP_SIZE (40 * 1024)
+  #endif
+#endif // SCRIPTING_HEAP_SIZE
+
 extern const AP_HAL::HAL& hal;
 
 const AP_Param::GroupInfo AP_Scripting::var_info[] = {
@@ -47,6 +54,25 @@ const AP_Param::GroupInfo AP_Scripting::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO_FLAGS("ENABLE", 1, AP_Scripting, _enable, 1, AP_PARAM_FLAG_ENABLE),
 
+    // @Param: VM_I_COUNT
+    // @DisplayName: Scripting Virtual Machine Instruction Count
+    // @Description: The number of Lua instructions a script may run each time it is called before it is stopped
+    // @Range: 1000 1000000
+    // @Increment: 10000
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("VM_I_COUNT", 2, AP_Scripting, _vm_steps, 10000),
+
+    // @Param: HEAP_SIZE
+    // @DisplayName: Scripting Heap Size
+    // @Description: Amount of memory available to each script. A script that needs more than this is stopped
+    // @Units: B
+    // @Range: 16384 1048576
+    // @Increment: 1024
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("HEAP_SIZE", 3, AP_Scripting, _heap_size, SCRIPTING_HEAP_SIZE),
+
     AP_GROUPEND
 };
 
@@ -76,50 +102,17 @@ bool AP_Scripting::init(void) {
 }
 
 void AP_Scripting::thread(void) {
-    unsigned int loop = 0;
-    lua_State *state = luaL_newstate();
-    luaL_openlibs(state);
-    load_lua_bindings(state);
-
-    // load the sandbox creation function
-    uint32_t sandbox_size;
-    char *sandbox_data = (char *)AP_ROMFS::find_decompress("sandbox.lua", sandbox_size);
-    if (sandbox_data == nullptr) {
-        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Could not find sandbox");
+    lua_scripts *lua = new lua_scripts(_vm_steps, _heap_size);
+    if (lua == nullptr) {
+        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Unable to allocate memory");
+        _running = false;
         return;
     }
+    lua->run();
 
-    if (luaL_dostring(state, sandbox_data)) {
-        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Loading sandbox: %s", lua_tostring(state, -1));
-        return;
-    }
-    free(sandbox_data);
-
-    luaL_loadstring(state, "gcs.send_text(string.format(\"math.cos(1 + 2) = %f\", math.cos(1+2)))");
-    lua_getglobal(state, "get_sandbox_env"); // find the sandbox creation function
-    if (lua_pcall(state, 0, LUA_MULTRET, 0)) {
-        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Could not create sandbox: %s", lua_tostring(state, -1));
-        return;
-    }
-    lua_setupvalue(state, -2, 1);
-
-    while (true) {
-        hal.scheduler->delay(1000);
-        gcs().send_text(MAV_SEVERITY_INFO, "Scripting Loop: %u", loop++);
-
-        const uint32_t startMem = hal.util->available_memory();
-        const uint32_t loadEnd = AP_HAL::micros();
-        lua_pushvalue(state, -1);
-        if(lua_pcall(state, 0, LUA_MULTRET, 0)) {
-            gcs().send_text(MAV_SEVERITY_INFO, "Lua: %s", lua_tostring(state, -1));
-            hal.console->printf("Lua: %s", lua_tostring(state, -1));
-            lua_pop(state, 1);
-            continue;
-        }
-        const uint32_t runEnd = AP_HAL::micros();
-        const uint32_t endMem = hal.util->available_memory();
-        gcs().send_text(MAV_SEVERITY_INFO, "Time: %d Memory: %d", runEnd - loadEnd, startMem - endMem);
-    }
+    // only reachable if the scripts could not be started
+    delete lua;
+    _running = false;
 }
 
 AP_Scripting *AP_Scripting::_singleton = nullptr;
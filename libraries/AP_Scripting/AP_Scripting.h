@@ -42,6 +42,8 @@ private:
     bool _running;
 
     AP_Int8 _enable;
+    AP_Int32 _vm_steps;
+    AP_Int32 _heap_size;
 
     static AP_Scripting *_singleton;
 
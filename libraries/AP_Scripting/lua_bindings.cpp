@@ -48,8 +48,3 @@ void load_lua_bindings(lua_State *state) {
     luaL_newlib(state, servo_functions);
     lua_setglobal(state, "servo");
 }
-
-void hook(lua_State *L, lua_Debug *ar) {
-    gcs().send_text(MAV_SEVERITY_INFO, "got a debug hook");
-    lua_error(L);
-}
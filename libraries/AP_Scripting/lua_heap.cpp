@@ -0,0 +1,201 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  fixed size arena allocator for Lua states
+ */
+
+#include "lua_heap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// smallest block, which must be able to hold a free_block
+#define LUA_HEAP_MIN_BLOCK ((sizeof(struct free_block) + 7U) & ~7U)
+
+lua_heap::~lua_heap(void)
+{
+    free(_arena);
+}
+
+bool lua_heap::init(uint32_t size)
+{
+    size &= ~7U;
+    if (size < LUA_HEAP_MIN_BLOCK) {
+        return false;
+    }
+    _arena = (uint8_t *)malloc(size);
+    if (_arena == nullptr) {
+        return false;
+    }
+    _size = size;
+    _free = (struct free_block *)_arena;
+    _free->hdr.size = size;
+    _free->next = nullptr;
+    _used = 0;
+    _peak = 0;
+    return true;
+}
+
+/*
+  size of the block needed to hold nsize bytes
+ */
+uint32_t lua_heap::block_size(size_t nsize)
+{
+    uint32_t size = (nsize + sizeof(struct block_header) + 7U) & ~7U;
+    if (size < LUA_HEAP_MIN_BLOCK) {
+        size = LUA_HEAP_MIN_BLOCK;
+    }
+    return size;
+}
+
+void lua_heap::add_used(uint32_t size)
+{
+    _used += size;
+    if (_used > _peak) {
+        _peak = _used;
+    }
+}
+
+void *lua_heap::allocate(size_t nsize)
+{
+    if (nsize >= _size) {
+        return nullptr;
+    }
+    const uint32_t need = block_size(nsize);
+
+    struct free_block **prev = &_free;
+    for (struct free_block *b = _free; b != nullptr; prev = &b->next, b = b->next) {
+        if (b->hdr.size < need) {
+            continue;
+        }
+        if (b->hdr.size - need >= LUA_HEAP_MIN_BLOCK) {
+            // split, leaving the end of the block free
+            struct free_block *rest = (struct free_block *)((uint8_t *)b + need);
+            rest->hdr.size = b->hdr.size - need;
+            rest->next = b->next;
+            *prev = rest;
+            b->hdr.size = need;
+        } else {
+            *prev = b->next;
+        }
+        add_used(b->hdr.size);
+        return (uint8_t *)b + sizeof(struct block_header);
+    }
+    return nullptr;
+}
+
+void lua_heap::release(void *ptr)
+{
+    struct free_block *b = (struct free_block *)((uint8_t *)ptr - sizeof(struct block_header));
+    _used -= b->hdr.size;
+
+    // find the free blocks either side
+    struct free_block *prev = nullptr;
+    struct free_block *next = _free;
+    while (next != nullptr && next < b) {
+        prev = next;
+        next = next->next;
+    }
+
+    if (next != nullptr && (uint8_t *)b + b->hdr.size == (uint8_t *)next) {
+        b->hdr.size += next->hdr.size;
+        b->next = next->next;
+    } else {
+        b->next = next;
+    }
+
+    if (prev == nullptr) {
+        _free = b;
+    } else if ((uint8_t *)prev + prev->hdr.size == (uint8_t *)b) {
+        prev->hdr.size += b->hdr.size;
+        prev->next = b->next;
+    } else {
+        prev->next = b;
+    }
+}
+
+void *lua_heap::reallocate(void *ptr, size_t nsize)
+{
+    struct free_block *b = (struct free_block *)((uint8_t *)ptr - sizeof(struct block_header));
+    if (nsize >= _size) {
+        return nullptr;
+    }
+    const uint32_t need = block_size(nsize);
+
+    if (need <= b->hdr.size) {
+        // shrinking always succeeds, as Lua requires
+        if (b->hdr.size - need >= LUA_HEAP_MIN_BLOCK) {
+            struct free_block *rest = (struct free_block *)((uint8_t *)b + need);
+            rest->hdr.size = b->hdr.size - need;
+            b->hdr.size = need;
+            release((uint8_t *)rest + sizeof(struct block_header));
+        }
+        return ptr;
+    }
+
+    // try to grow into a free block that follows this one, which is
+    // the common case for a growing table or buffer
+    struct free_block **prev = &_free;
+    struct free_block *f = _free;
+    while (f != nullptr && f < b) {
+        prev = &f->next;
+        f = f->next;
+    }
+    if (f != nullptr &&
+        (uint8_t *)b + b->hdr.size == (uint8_t *)f &&
+        b->hdr.size + f->hdr.size >= need) {
+        const uint32_t total = b->hdr.size + f->hdr.size;
+        struct free_block *next = f->next;
+        if (total - need >= LUA_HEAP_MIN_BLOCK) {
+            struct free_block *rest = (struct free_block *)((uint8_t *)b + need);
+            rest->hdr.size = total - need;
+            rest->next = next;
+            *prev = rest;
+            add_used(need - b->hdr.size);
+            b->hdr.size = need;
+        } else {
+            *prev = next;
+            add_used(total - b->hdr.size);
+            b->hdr.size = total;
+        }
+        return ptr;
+    }
+
+    void *newptr = allocate(nsize);
+    if (newptr == nullptr) {
+        return nullptr;
+    }
+    memcpy(newptr, ptr, b->hdr.size - sizeof(struct block_header));
+    release(ptr);
+    return newptr;
+}
+
+/*
+  the lua_Alloc interface. A nsize of zero frees, a null ptr allocates
+ */
+void *lua_heap::alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+    lua_heap *heap = (lua_heap *)ud;
+    if (nsize == 0) {
+        if (ptr != nullptr) {
+            heap->release(ptr);
+        }
+        return nullptr;
+    }
+    if (ptr == nullptr) {
+        return heap->allocate(nsize);
+    }
+    return heap->reallocate(ptr, nsize);
+}
@@ -0,0 +1,70 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  A fixed size arena for one Lua state. The arena is taken from the
+  system heap in one allocation when the script is loaded, so a script
+  can never use more than its arena and never fragments the system
+  heap. Blocks are allocated first fit from a free list kept in address
+  order, with neighbouring free blocks merged
+ */
+class lua_heap {
+public:
+    lua_heap() {}
+    ~lua_heap(void);
+
+    /* Do not allow copies */
+    lua_heap(const lua_heap &other) = delete;
+    lua_heap &operator=(const lua_heap&) = delete;
+
+    // allocate the arena, returns false if there is not enough memory
+    bool init(uint32_t size);
+
+    // lua_Alloc function, with the lua_heap as the user data
+    static void *alloc(void *ud, void *ptr, size_t osize, size_t nsize);
+
+    // bytes in use, including block headers
+    uint32_t get_used(void) const { return _used; }
+
+    // highest value of get_used()
+    uint32_t get_peak(void) const { return _peak; }
+
+private:
+    struct block_header {
+        uint32_t size; // size of the block, including this header
+        uint32_t pad;  // keep allocations 8 byte aligned
+    };
+
+    struct free_block {
+        struct block_header hdr;
+        struct free_block *next;
+    };
+
+    static uint32_t block_size(size_t nsize);
+    void *allocate(size_t nsize);
+    void release(void *ptr);
+    void *reallocate(void *ptr, size_t nsize);
+    void add_used(uint32_t size);
+
+    uint8_t *_arena = nullptr;
+    uint32_t _size;
+    struct free_block *_free;
+    uint32_t _used;
+    uint32_t _peak;
+};
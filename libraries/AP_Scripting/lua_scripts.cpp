@@ -0,0 +1,370 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  script loading and scheduling
+ */
+
+#include "lua_scripts.h"
+#include "lua_bindings.h"
+
+#include <AP_ROMFS/AP_ROMFS.h>
+#include <DataFlash/DataFlash.h>
+#include <GCS_MAVLink/GCS.h>
+
+#include <AP_Math/AP_Math.h>
+
+#include <stdio.h>
+#if HAL_OS_POSIX_IO
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+// smallest instruction budget per run
+#define SCRIPTING_VM_STEPS_MIN 1000
+
+extern const AP_HAL::HAL& hal;
+
+// arguments to setup_state()
+struct setup_args {
+    const char *sandbox;
+    const char *name;
+    const char *data;
+    size_t size;
+    int lua_ref;
+};
+
+lua_scripts::lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size) :
+    _vm_steps(vm_steps),
+    _heap_size(heap_size)
+{
+}
+
+/*
+  the error on top of the stack as text. Scripts can raise errors
+  with any value, which lua_tostring() can't convert
+ */
+static const char *error_text(lua_State *L)
+{
+    const char *text = lua_tostring(L, -1);
+    if (text == nullptr) {
+        return "error object is not a string";
+    }
+    return text;
+}
+
+/*
+  called if Lua raises an error outside a protected call, which the
+  loader and scheduler are written to never do
+ */
+int lua_scripts::atpanic(lua_State *L)
+{
+    AP_HAL::panic("Lua: %s", error_text(L));
+    return 0;
+}
+
+/*
+  count hook, called once a script has run its instruction budget. A
+  script can catch the error with pcall(), so the hook is re-armed to
+  raise it again on every instruction until the script has unwound
+  back to run_next_script(), which removes the hook
+ */
+void lua_scripts::hook(lua_State *L, lua_Debug *ar)
+{
+    lua_sethook(L, hook, LUA_MASKCOUNT, 1);
+    luaL_error(L, "exceeded instruction budget");
+}
+
+/*
+  set up a new state and load a script into it. This is run as a
+  protected call, as anything that allocates can fail once the
+  script's heap is full
+ */
+int lua_scripts::setup_state(lua_State *L)
+{
+    struct setup_args *args = (struct setup_args *)lua_touserdata(L, 1);
+    lua_pop(L, 1);
+
+    luaL_openlibs(L);
+    load_lua_bindings(L);
+
+    if (luaL_dostring(L, args->sandbox)) {
+        return lua_error(L);
+    }
+
+    // only text chunks are accepted, precompiled bytecode is not verified
+    if (luaL_loadbufferx(L, args->data, args->size, args->name, "t")) {
+        return lua_error(L);
+    }
+
+    // run the chunk in the sandbox environment
+    lua_getglobal(L, "get_sandbox_env");
+    lua_call(L, 0, 1);
+    lua_setupvalue(L, -2, 1);
+
+    args->lua_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    return 0;
+}
+
+/*
+  create a state for a script and schedule it to run now
+ */
+void lua_scripts::load_script(const char *filename, const char *data, size_t size)
+{
+    struct script_info *script = new struct script_info;
+    if (script == nullptr) {
+        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Insufficient memory for %s", filename);
+        return;
+    }
+    memset(script->name, 0, sizeof(script->name));
+    strncpy(script->name, filename, sizeof(script->name));
+    script->state = nullptr;
+    script->run_time_us = 0;
+    script->total_time_us = 0;
+    script->next = nullptr;
+
+    if (!script->heap.init(_heap_size)) {
+        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Insufficient memory for %s", filename);
+        delete script;
+        return;
+    }
+
+    lua_State *L = lua_newstate(lua_heap::alloc, &script->heap);
+    if (L == nullptr) {
+        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Insufficient memory for %s", filename);
+        delete script;
+        return;
+    }
+    lua_atpanic(L, atpanic);
+    script->state = L;
+
+    struct setup_args args { _sandbox, filename, data, size, LUA_NOREF };
+    lua_pushcfunction(L, setup_state);
+    lua_pushlightuserdata(L, &args);
+    if (lua_pcall(L, 1, 0, 0)) {
+        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: %s", error_text(L));
+        lua_close(L);
+        delete script;
+        return;
+    }
+    script->lua_ref = args.lua_ref;
+    script->next_run_ms = AP_HAL::millis();
+
+    gcs().send_text(MAV_SEVERITY_INFO, "Scripting: loaded %s", filename);
+    schedule(script);
+}
+
+/*
+  load the scripts built into ROMFS
+ */
+void lua_scripts::load_romfs_scripts(void)
+{
+    uint16_t ofs = 0;
+    const char *name;
+    while ((name = AP_ROMFS::dir_list(SCRIPTING_ROMFS_DIRECTORY, ofs)) != nullptr) {
+        char path[64];
+        snprintf(path, sizeof(path), "%s/%s", SCRIPTING_ROMFS_DIRECTORY, name);
+        uint32_t size;
+        char *data = (char *)AP_ROMFS::find_decompress(path, size);
+        if (data == nullptr) {
+            gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Insufficient memory for %s", name);
+            continue;
+        }
+        load_script(name, data, size);
+        free(data);
+    }
+}
+
+/*
+  load the *.lua files in a directory on the filesystem
+ */
+void lua_scripts::load_directory(const char *dirname)
+{
+#if HAL_OS_POSIX_IO || HAL_OS_FATFS_IO
+    DIR *d = opendir(dirname);
+    if (d == nullptr) {
+        return;
+    }
+
+    for (struct dirent *de=readdir(d); de; de=readdir(d)) {
+        const size_t length = strlen(de->d_name);
+        if (length < 5 || strcmp(&de->d_name[length-4], ".lua") != 0) {
+            continue;
+        }
+
+        char path[128];
+        snprintf(path, sizeof(path), "%s/%s", dirname, de->d_name);
+        struct stat st;
+        if (::stat(path, &st) != 0 || st.st_size <= 0) {
+            continue;
+        }
+        const size_t size = st.st_size;
+        char *data = (char *)malloc(size + 1);
+        if (data == nullptr) {
+            gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Insufficient memory for %s", de->d_name);
+            continue;
+        }
+        int fd = ::open(path, O_RDONLY|O_CLOEXEC);
+        if (fd == -1) {
+            free(data);
+            continue;
+        }
+        size_t nread = 0;
+        while (nread < size) {
+            ssize_t n = ::read(fd, &data[nread], size - nread);
+            if (n <= 0) {
+                break;
+            }
+            nread += n;
+        }
+        ::close(fd);
+        if (nread == size) {
+            data[size] = 0;
+            load_script(de->d_name, data, size);
+        }
+        free(data);
+    }
+    closedir(d);
+#endif
+}
+
+/*
+  insert a script into the run list, in order of next run time
+ */
+void lua_scripts::schedule(struct script_info *script)
+{
+    struct script_info **prev = &_scripts;
+    while (*prev != nullptr &&
+           (int32_t)((*prev)->next_run_ms - script->next_run_ms) <= 0) {
+        prev = &(*prev)->next;
+    }
+    script->next = *prev;
+    *prev = script;
+}
+
+void lua_scripts::remove_script(struct script_info *script)
+{
+    lua_close(script->state);
+    delete script;
+}
+
+/*
+  log the time and memory used by a script
+ */
+void lua_scripts::log_script(const struct script_info *script) const
+{
+    DataFlash_Class *df = DataFlash_Class::instance();
+    if (df == nullptr) {
+        return;
+    }
+    df->Log_Write("SCR", "TimeUS,Name,Runtime,Total,Mem,MemPeak", "QNIIII",
+                  AP_HAL::micros64(),
+                  script->name,
+                  script->run_time_us,
+                  script->total_time_us,
+                  script->heap.get_used(),
+                  script->heap.get_peak());
+}
+
+/*
+  run the script at the head of the list, and reschedule or remove it
+ */
+void lua_scripts::run_next_script(void)
+{
+    struct script_info *script = _scripts;
+    _scripts = script->next;
+
+    lua_State *L = script->state;
+    const int top = lua_gettop(L);
+    const uint32_t start_ms = AP_HAL::millis();
+
+    lua_sethook(L, hook, LUA_MASKCOUNT, MAX(_vm_steps.get(), SCRIPTING_VM_STEPS_MIN));
+    lua_rawgeti(L, LUA_REGISTRYINDEX, script->lua_ref);
+    const uint32_t start_us = AP_HAL::micros();
+    const int ret = lua_pcall(L, 0, LUA_MULTRET, 0);
+    script->run_time_us = AP_HAL::micros() - start_us;
+    script->total_time_us += script->run_time_us;
+    lua_sethook(L, nullptr, 0, 0);
+
+    log_script(script);
+
+    if (ret != 0) {
+        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: %s", error_text(L));
+        remove_script(script);
+        return;
+    }
+
+    switch (lua_gettop(L) - top) {
+    case 0:
+        // the script has finished
+        remove_script(script);
+        return;
+    case 2:
+        if (lua_isfunction(L, -2) && lua_isnumber(L, -1)) {
+            const lua_Number delay_ms = lua_tonumber(L, -1);
+            lua_pop(L, 1);
+            // replace the function in the existing registry slot, which
+            // does not allocate
+            lua_rawseti(L, LUA_REGISTRYINDEX, script->lua_ref);
+            lua_settop(L, top);
+            // clamp before converting, as a huge or NaN delay does not
+            // fit a uint32_t. schedule() compares run times as signed
+            // differences, so the delay must stay below INT32_MAX
+            const uint32_t delay = delay_ms > 0 ? (uint32_t)MIN(delay_ms, (lua_Number)INT32_MAX) : 0U;
+            script->next_run_ms = start_ms + delay;
+            schedule(script);
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
+    gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: %s must return a function and a time in ms", script->name);
+    remove_script(script);
+}
+
+void lua_scripts::run(void)
+{
+    uint32_t sandbox_size;
+    _sandbox = (char *)AP_ROMFS::find_decompress("sandbox.lua", sandbox_size);
+    if (_sandbox == nullptr) {
+        gcs().send_text(MAV_SEVERITY_CRITICAL, "Scripting: Could not find sandbox");
+        return;
+    }
+
+    load_romfs_scripts();
+    load_directory(SCRIPTING_DIRECTORY);
+
+    while (true) {
+        if (_scripts == nullptr) {
+            // nothing left to run
+            hal.scheduler->delay(1000);
+            continue;
+        }
+
+        // always sleep between runs, so scripts can't starve other
+        // threads even when they are running late
+        int32_t wait_ms = _scripts->next_run_ms - AP_HAL::millis();
+        if (wait_ms < 1) {
+            wait_ms = 1;
+        }
+        hal.scheduler->delay(wait_ms);
+
+        run_next_script();
+    }
+}
@@ -0,0 +1,90 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Param/AP_Param.h>
+
+#include "lua_heap.h"
+#include "lua/src/lua.hpp"
+
+#ifndef SCRIPTING_DIRECTORY
+#if HAL_OS_FATFS_IO
+#define SCRIPTING_DIRECTORY "/APM/scripts"
+#else
+#define SCRIPTING_DIRECTORY "scripts"
+#endif
+#endif
+
+// directory of scripts built into ROMFS
+#define SCRIPTING_ROMFS_DIRECTORY "scripts"
+
+/*
+  Loads and runs the scripts. Each script has its own Lua state with
+  its own fixed size heap, so a script that runs out of memory only
+  stops itself.
+
+  A script is run once when loaded. To keep running, a script returns
+  a function and a time in milliseconds, and the function is called
+  after that time, returning the same way. A script that returns
+  nothing is finished, and a script that raises an error, exceeds its
+  instruction budget or runs out of memory is stopped.
+ */
+class lua_scripts
+{
+public:
+    lua_scripts(const AP_Int32 &vm_steps, const AP_Int32 &heap_size);
+
+    /* Do not allow copies */
+    lua_scripts(const lua_scripts &other) = delete;
+    lua_scripts &operator=(const lua_scripts&) = delete;
+
+    // load and run all scripts, does not return
+    void run(void);
+
+private:
+    struct script_info {
+        char name[16];           // file name, null padded for logging
+        lua_State *state;
+        lua_heap heap;
+        int lua_ref;             // registry reference to the function to run
+        uint32_t next_run_ms;    // time to run next
+        uint32_t run_time_us;    // time taken by the last run
+        uint32_t total_time_us;  // time taken by all runs
+        struct script_info *next;
+    };
+
+    void load_script(const char *filename, const char *data, size_t size);
+    void load_romfs_scripts(void);
+    void load_directory(const char *dirname);
+
+    void schedule(struct script_info *script);
+    void remove_script(struct script_info *script);
+    void run_next_script(void);
+    void log_script(const struct script_info *script) const;
+
+    static int setup_state(lua_State *L);
+    static int atpanic(lua_State *L);
+    static void hook(lua_State *L, lua_Debug *ar);
+
+    const AP_Int32 &_vm_steps;
+    const AP_Int32 &_heap_size;
+
+    // sandbox environment source, shared by all scripts
+    char *_sandbox = nullptr;
+
+    // scripts waiting to run, soonest first
+    struct script_info *_scripts = nullptr;
+};
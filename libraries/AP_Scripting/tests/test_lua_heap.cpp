@@ -0,0 +1,116 @@
+#include <AP_gtest.h>
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Scripting/lua_heap.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_HEAP_SIZE 16384
+#define TEST_HEAP_BLOCKS 64
+
+static void *heap_alloc(lua_heap &heap, void *ptr, size_t osize, size_t nsize)
+{
+    return lua_heap::alloc(&heap, ptr, osize, nsize);
+}
+
+TEST(LuaHeap, Init)
+{
+    lua_heap tiny;
+    EXPECT_FALSE(tiny.init(8));
+
+    lua_heap heap;
+    ASSERT_TRUE(heap.init(TEST_HEAP_SIZE));
+    EXPECT_EQ(heap.get_used(), 0U);
+    EXPECT_EQ(heap.get_peak(), 0U);
+}
+
+TEST(LuaHeap, Exhaustion)
+{
+    lua_heap heap;
+    ASSERT_TRUE(heap.init(TEST_HEAP_SIZE));
+
+    EXPECT_EQ(heap_alloc(heap, nullptr, 0, TEST_HEAP_SIZE), nullptr);
+
+    void *blocks[TEST_HEAP_SIZE / 200];
+    uint16_t n = 0;
+    void *p;
+    while ((p = heap_alloc(heap, nullptr, 0, 200)) != nullptr) {
+        ASSERT_LT(n, ARRAY_SIZE(blocks));
+        EXPECT_EQ((uintptr_t)p & 7U, 0U);
+        blocks[n++] = p;
+    }
+    EXPECT_GT(n, 0U);
+    EXPECT_LE(heap.get_used(), (uint32_t)TEST_HEAP_SIZE);
+
+    // growing a block fails in a full arena and leaves it unchanged
+    memset(blocks[0], 0x5A, 200);
+    EXPECT_EQ(heap_alloc(heap, blocks[0], 200, 400), nullptr);
+    EXPECT_EQ(((uint8_t *)blocks[0])[199], 0x5A);
+
+    // shrinking never fails, and keeps the block in place
+    EXPECT_EQ(heap_alloc(heap, blocks[0], 200, 16), blocks[0]);
+
+    for (uint16_t i = 0; i < n; i++) {
+        EXPECT_EQ(heap_alloc(heap, blocks[i], 200, 0), nullptr);
+    }
+    EXPECT_EQ(heap.get_used(), 0U);
+}
+
+TEST(LuaHeap, Random)
+{
+    lua_heap heap;
+    ASSERT_TRUE(heap.init(TEST_HEAP_SIZE));
+
+    uint8_t *blocks[TEST_HEAP_BLOCKS] {};
+    size_t sizes[TEST_HEAP_BLOCKS] {};
+
+    srandom(1);
+    for (uint32_t step = 0; step < 20000; step++) {
+        const uint8_t i = random() % TEST_HEAP_BLOCKS;
+        const size_t nsize = (random() % 4 == 0) ? 0 : 1 + random() % 600;
+
+        // every live block still holds the pattern it was given
+        if (blocks[i] != nullptr) {
+            for (size_t j = 0; j < sizes[i]; j++) {
+                ASSERT_EQ(blocks[i][j], (uint8_t)(i + j));
+            }
+        }
+
+        uint8_t *p = (uint8_t *)heap_alloc(heap, blocks[i], sizes[i], nsize);
+        if (nsize == 0) {
+            EXPECT_EQ(p, nullptr);
+            blocks[i] = nullptr;
+            sizes[i] = 0;
+            continue;
+        }
+        if (p == nullptr) {
+            // out of memory, the old block must be untouched
+            continue;
+        }
+        EXPECT_EQ((uintptr_t)p & 7U, 0U);
+
+        // realloc keeps the contents up to the smaller size
+        const size_t keep = sizes[i] < nsize ? sizes[i] : nsize;
+        for (size_t j = 0; j < keep; j++) {
+            ASSERT_EQ(p[j], (uint8_t)(i + j));
+        }
+        for (size_t j = 0; j < nsize; j++) {
+            p[j] = i + j;
+        }
+        blocks[i] = p;
+        sizes[i] = nsize;
+    }
+    EXPECT_GT(heap.get_peak(), heap.get_used());
+
+    for (uint8_t i = 0; i < TEST_HEAP_BLOCKS; i++) {
+        heap_alloc(heap, blocks[i], sizes[i], 0);
+    }
+    EXPECT_EQ(heap.get_used(), 0U);
+
+    // the free blocks have been merged back into one
+    void *p = heap_alloc(heap, nullptr, 0, TEST_HEAP_SIZE - 64);
+    EXPECT_NE(p, nullptr);
+}
+
+AP_GTEST_MAIN()
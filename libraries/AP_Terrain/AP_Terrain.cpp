@@ -46,7 +46,7 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: SPACING
     // @DisplayName: Terrain grid spacing
-    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the worldwide SRTM database then a resolution of 100 meters is appropriate. Some parts of the world may have higher resolution data available, such as 30 meter data available in the SRTM database in the USA. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in the vehicle keeping 12 grid squares in memory with each grid square having a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be demand loaded as needed.
+    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the worldwide SRTM database then a resolution of 100 meters is appropriate. Some parts of the world may have higher resolution data available, such as 30 meter data available in the SRTM database in the USA. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in the vehicle keeping 12 grid squares in memory (64 on Linux boards) with each grid square having a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be demand loaded as needed.
     // @Units: m
     // @Increment: 1
     // @User: Advanced
@@ -286,9 +286,9 @@ float AP_Terrain::lookahead(float bearing, float distance, float climb_ratio)
 
 
 /*
-  1hz update function. This is here to ensure progress is made on disk
-  IO even if no MAVLink send_request() operations are called for a
-  while.
+  update function, called at 10Hz by the vehicles. This is here to
+  ensure progress is made on disk IO even if no MAVLink send_request()
+  operations are called for a while.
  */
 void AP_Terrain::update(void)
 {
@@ -314,6 +314,9 @@ void AP_Terrain::update(void)
     // check for pending rally data
     update_rally_data();
 
+    // load blocks ahead of the vehicle
+    prefetch_blocks();
+
     // update capabilities and status
     if (allocate()) {
         hal.util->set_capabilities(MAV_PROTOCOL_CAPABILITY_TERRAIN);
@@ -387,6 +390,15 @@ bool AP_Terrain::allocate(void)
         gcs().send_text(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         return false;
     }
+    cache_hash = (uint8_t *)malloc(TERRAIN_GRID_CACHE_HASH_SIZE);
+    if (cache_hash == nullptr) {
+        free(cache);
+        cache = nullptr;
+        enable.set(0);
+        gcs().send_text(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
+        return false;
+    }
+    memset(cache_hash, TERRAIN_GRID_CACHE_NONE, TERRAIN_GRID_CACHE_HASH_SIZE);
     cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
     return true;
 }
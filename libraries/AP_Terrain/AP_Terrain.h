@@ -52,8 +52,40 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// number of grid_blocks in the LRU memory cache. Boards with plenty
+// of memory keep more blocks, so long terrain following flights are
+// less likely to wait for disk IO
+#ifndef TERRAIN_GRID_BLOCK_CACHE_SIZE
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE 64
+#else
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
+#endif
+#endif
+
+// number of buckets in the hash index of the memory cache, must be a
+// power of 2
+#define TERRAIN_GRID_CACHE_HASH_SIZE 128
+
+// marks the end of a hash chain
+#define TERRAIN_GRID_CACHE_NONE 0xFF
+
+static_assert(TERRAIN_GRID_BLOCK_CACHE_SIZE < TERRAIN_GRID_CACHE_NONE, "terrain cache too large");
+
+// maximum number of blocks to load ahead of the vehicle on each
+// update. Small caches are kept for the blocks around the vehicle
+#define TERRAIN_PREFETCH_BLOCKS (TERRAIN_GRID_BLOCK_CACHE_SIZE > 16 ? TERRAIN_GRID_BLOCK_CACHE_SIZE/4 : 0)
+
+// time in seconds of flight ahead of the vehicle to load blocks for
+#define TERRAIN_PREFETCH_TIME 60
+
+// mission legs after the current one to load blocks for, and the most
+// mission commands to read looking for them on each update
+#define TERRAIN_PREFETCH_LEGS 3
+#define TERRAIN_PREFETCH_SCAN 10
+
+// maximum time a written block waits for fsync() in milliseconds
+#define TERRAIN_FSYNC_DELAY_MS 2000
 
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
@@ -90,7 +122,7 @@ public:
 
     static const struct AP_Param::GroupInfo var_info[];
 
-    // update terrain state. Should be called at 1Hz or more
+    // update terrain state. Vehicles call this at 10Hz
     void update(void);
 
     // return status enum for health reporting
@@ -177,7 +209,7 @@ public:
      */
     void get_statistics(uint16_t &pending, uint16_t &loaded);
 
-private:
+protected:
     // allocate the terrain subsystem data
     bool allocate(void);
 
@@ -241,6 +273,9 @@ private:
 
         // the last time access was requested to this block, used for LRU
         uint32_t last_access_ms;
+
+        // next block in the same hash bucket
+        uint8_t hash_next;
     };
 
     /*
@@ -280,6 +315,18 @@ private:
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    /*
+      find the cache index of a block, or -1 if not in the cache
+    */
+    int16_t find_cache_idx(int32_t lat, int32_t lon, uint16_t spacing) const;
+
+    /*
+      maintain the hash index of the cache
+    */
+    uint8_t cache_hash_bucket(int32_t lat, int32_t lon) const;
+    void cache_hash_insert(uint8_t idx);
+    void cache_hash_remove(uint8_t idx);
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -319,6 +366,7 @@ private:
     void open_file(void);
     void seek_offset(void);
     void write_block(void);
+    void flush_writes(void);
     void read_block(void);
 
     /*
@@ -331,6 +379,12 @@ private:
      */
     void update_rally_data(void);
 
+    /*
+      load blocks ahead of the vehicle
+     */
+    void prefetch_blocks(void);
+    bool prefetch_path(const Location &start, const Location &end, uint8_t &count);
+
 
     // parameters
     AP_Int8  enable;
@@ -352,6 +406,11 @@ private:
     uint8_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // hash index of the cache, by SW corner of the block. Each bucket
+    // is the index of the first block in a chain, linked through
+    // grid_cache::hash_next
+    uint8_t *cache_hash = nullptr;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -378,6 +437,11 @@ private:
     int8_t file_lat_degrees;
     int16_t file_lon_degrees;
 
+    // writes to the open file not yet flushed with fsync(), and the
+    // time of the first of them
+    bool fsync_pending;
+    uint32_t fsync_pending_ms;
+
     // do we have an IO failure
     volatile bool io_failure;
 
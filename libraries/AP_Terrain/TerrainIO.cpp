@@ -100,7 +100,13 @@ void AP_Terrain::schedule_disk_io(void)
             cache[cache_idx].state = GRID_CACHE_VALID;
             cache[cache_idx].last_access_ms = AP_HAL::millis();
         }
+        // start on the next block straight away, rather than waiting
+        // for the next call
         disk_io_state = DiskIoIdle;
+        check_disk_read();
+        if (disk_io_state == DiskIoIdle) {
+            check_disk_write();
+        }
         break;
     }
 
@@ -114,6 +120,10 @@ void AP_Terrain::schedule_disk_io(void)
             }
         }
         disk_io_state = DiskIoIdle;
+        check_disk_read();
+        if (disk_io_state == DiskIoIdle) {
+            check_disk_write();
+        }
         break;
     }
         
@@ -196,6 +206,7 @@ void AP_Terrain::open_file(void)
     }
 
     if (fd != -1) {
+        flush_writes();
         ::close(fd);
     }
 #if HAL_OS_POSIX_IO
@@ -268,7 +279,11 @@ void AP_Terrain::write_block(void)
         fd = -1;
         io_failure = true;
     } else {
-        ::fsync(fd);
+        // the fsync() is batched, see flush_writes()
+        if (!fsync_pending) {
+            fsync_pending = true;
+            fsync_pending_ms = AP_HAL::millis();
+        }
 #if TERRAIN_DEBUG
         printf("wrote block at %ld %ld ret=%d mask=%07llx\n",
                (long)disk_block.block.lat,
@@ -280,6 +295,19 @@ void AP_Terrain::write_block(void)
     disk_io_state = DiskIoDoneWrite;
 }
 
+/*
+  fsync() the writes to the open file. Writes are flushed together
+  once the oldest has waited TERRAIN_FSYNC_DELAY_MS, or before the file
+  is closed, rather than after every block
+ */
+void AP_Terrain::flush_writes(void)
+{
+    if (fsync_pending && fd != -1) {
+        ::fsync(fd);
+    }
+    fsync_pending = false;
+}
+
 /*
   read in disk_block
  */
@@ -339,7 +367,11 @@ void AP_Terrain::io_timer(void)
     case DiskIoIdle:
     case DiskIoDoneRead:
     case DiskIoDoneWrite:
-        // nothing to do
+        // nothing to do but flush old writes
+        if (fsync_pending &&
+            AP_HAL::millis() - fsync_pending_ms >= TERRAIN_FSYNC_DELAY_MS) {
+            flush_writes();
+        }
         break;
         
     case DiskIoWaitWrite:
@@ -157,4 +157,100 @@ void AP_Terrain::update_rally_data(void)
     }
 }
 
+/*
+  load the blocks along a path, so they are read from disk or
+  requested from the GCS before height_amsl() needs them. Returns
+  false once TERRAIN_PREFETCH_BLOCKS blocks have been added to the
+  cache
+ */
+bool AP_Terrain::prefetch_path(const Location &start, const Location &end, uint8_t &count)
+{
+    // half a block, so no block on the path is stepped over
+    const float step = TERRAIN_GRID_BLOCK_SPACING_X * grid_spacing * 0.5f;
+    const float distance = get_distance(start, end);
+    const float bearing = get_bearing_cd(start, end) * 0.01f;
+
+    Location loc = start;
+    for (uint8_t i=0; i<2*TERRAIN_PREFETCH_BLOCKS && i*step <= distance; i++) {
+        struct grid_info info;
+        calculate_grid_info(loc, info);
+        if (find_cache_idx(info.grid_lat, info.grid_lon, grid_spacing) == -1) {
+            if (count >= TERRAIN_PREFETCH_BLOCKS) {
+                return false;
+            }
+            count++;
+        }
+        find_grid_cache(info);
+        location_update(loc, bearing, step);
+    }
+    return true;
+}
+
+/*
+  load the blocks the vehicle will fly over in the next
+  TERRAIN_PREFETCH_TIME seconds at its current velocity, then those
+  along the current mission leg and up to TERRAIN_PREFETCH_LEGS legs
+  after it
+ */
+void AP_Terrain::prefetch_blocks(void)
+{
+    if (!allocate()) {
+        return;
+    }
+    if (TERRAIN_PREFETCH_BLOCKS == 0 || grid_spacing <= 0) {
+        return;
+    }
+
+    Location loc;
+    if (!ahrs.get_position(loc)) {
+        // we don't know where we are
+        return;
+    }
+
+    uint8_t count = 0;
+    const Vector2f groundspeed = ahrs.groundspeed_vector();
+    Location ahead = loc;
+    location_offset(ahead,
+                    groundspeed.x * TERRAIN_PREFETCH_TIME,
+                    groundspeed.y * TERRAIN_PREFETCH_TIME);
+    if (!prefetch_path(loc, ahead, count)) {
+        return;
+    }
+
+    if (mission.state() != AP_Mission::MISSION_RUNNING) {
+        return;
+    }
+    const AP_Mission::Mission_Command &nav_cmd = mission.get_current_nav_cmd();
+    Location leg_start = nav_cmd.content.location;
+    if (leg_start.lat == 0 && leg_start.lng == 0) {
+        return;
+    }
+    if (!prefetch_path(loc, leg_start, count)) {
+        return;
+    }
+
+    // follow the stored mission from the current nav command. Jumps
+    // are not followed, so after a DO_JUMP this loads the commands
+    // which come next in storage rather than the ones which will be
+    // flown
+    uint8_t legs = 0;
+    for (uint16_t index = nav_cmd.index + 1;
+         legs < TERRAIN_PREFETCH_LEGS && index < nav_cmd.index + 1 + TERRAIN_PREFETCH_SCAN;
+         index++) {
+        AP_Mission::Mission_Command cmd;
+        if (!mission.read_cmd_from_storage(index, cmd)) {
+            break;
+        }
+        if (!AP_Mission::is_nav_cmd(cmd) ||
+            (cmd.content.location.lat == 0 && cmd.content.location.lng == 0)) {
+            continue;
+        }
+        if (!prefetch_path(leg_start, cmd.content.location, count)) {
+            return;
+        }
+        leg_start = cmd.content.location;
+        legs++;
+    }
+}
+
 #endif // AP_TERRAIN_AVAILABLE
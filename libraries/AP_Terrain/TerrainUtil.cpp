@@ -113,28 +113,82 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
 }
 
 
+/*
+  hash bucket for a block given its SW corner
+ */
+uint8_t AP_Terrain::cache_hash_bucket(int32_t lat, int32_t lon) const
+{
+    uint32_t h = (uint32_t)lat * 0x9E3779B1U;
+    h ^= (uint32_t)lon * 0x85EBCA6BU;
+    h ^= h >> 16;
+    return h & (TERRAIN_GRID_CACHE_HASH_SIZE-1);
+}
+
+/*
+  add a cache block to the hash index
+ */
+void AP_Terrain::cache_hash_insert(uint8_t idx)
+{
+    uint8_t &head = cache_hash[cache_hash_bucket(cache[idx].grid.lat, cache[idx].grid.lon)];
+    cache[idx].hash_next = head;
+    head = idx;
+}
+
+/*
+  remove a cache block from the hash index. Blocks that were never
+  used are not in the index
+ */
+void AP_Terrain::cache_hash_remove(uint8_t idx)
+{
+    uint8_t *p = &cache_hash[cache_hash_bucket(cache[idx].grid.lat, cache[idx].grid.lon)];
+    while (*p != TERRAIN_GRID_CACHE_NONE) {
+        if (*p == idx) {
+            *p = cache[idx].hash_next;
+            return;
+        }
+        p = &cache[*p].hash_next;
+    }
+}
+
+/*
+  find the cache index of a block, or -1 if not in the cache
+ */
+int16_t AP_Terrain::find_cache_idx(int32_t lat, int32_t lon, uint16_t spacing) const
+{
+    for (uint8_t i = cache_hash[cache_hash_bucket(lat, lon)];
+         i != TERRAIN_GRID_CACHE_NONE;
+         i = cache[i].hash_next) {
+        if (cache[i].grid.lat == lat &&
+            cache[i].grid.lon == lon &&
+            cache[i].grid.spacing == spacing) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 /*
   find a grid structure given a grid_info
  */
 AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
 {
-    uint16_t oldest_i = 0;
-
     // see if we have that grid
-    for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].grid.lat == info.grid_lat && 
-            cache[i].grid.lon == info.grid_lon &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
-        }
+    int16_t idx = find_cache_idx(info.grid_lat, info.grid_lon, grid_spacing);
+    if (idx != -1) {
+        cache[idx].last_access_ms = AP_HAL::millis();
+        return cache[idx];
+    }
+
+    // Not found. Use the oldest grid and make it this grid,
+    // initially unpopulated
+    uint16_t oldest_i = 0;
+    for (uint16_t i=1; i<cache_size; i++) {
         if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
             oldest_i = i;
         }
     }
+    cache_hash_remove(oldest_i);
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
     struct grid_cache &grid = cache[oldest_i];
     memset(&grid, 0, sizeof(grid));
 
@@ -151,6 +205,8 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
+    cache_hash_insert(oldest_i);
+
     return grid;
 }
 
@@ -0,0 +1,165 @@
+#include <AP_gtest.h>
+
+#include <AP_Terrain/AP_Terrain.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+#if AP_TERRAIN_AVAILABLE
+
+static AP_AHRS_DCM ahrs;
+static AP_Mission mission{ahrs, nullptr, nullptr, nullptr};
+static AP_Rally rally{ahrs};
+
+// the simulated time in microseconds, advanced by each load
+static uint64_t now_us = 1000000;
+
+// gives the tests access to the block cache of AP_Terrain
+class AP_Terrain_Test : public AP_Terrain
+{
+public:
+    AP_Terrain_Test() :
+        AP_Terrain(ahrs, mission, rally)
+    {
+        enable.set(1);
+        grid_spacing.set(100);
+    }
+
+    bool allocate() { return AP_Terrain::allocate(); }
+    uint8_t cache_size() const { return AP_Terrain::cache_size; }
+
+    // load the block with the given SW corner into the cache, one
+    // millisecond after the last load
+    void load(int32_t lat, int32_t lon)
+    {
+        now_us += 1000;
+        hal.scheduler->stop_clock(now_us);
+        grid_info info {};
+        info.grid_lat = lat;
+        info.grid_lon = lon;
+        find_grid_cache(info);
+    }
+
+    // the cache slot holding a block, or -1
+    int16_t slot(int32_t lat, int32_t lon) const
+    {
+        const int16_t idx = find_cache_idx(lat, lon, grid_spacing);
+        if (idx == -1 || cache[idx].grid.lat != lat || cache[idx].grid.lon != lon) {
+            return -1;
+        }
+        return idx;
+    }
+
+    bool cached(int32_t lat, int32_t lon) const
+    {
+        return slot(lat, lon) != -1;
+    }
+
+    // check every index chain only holds blocks that hash to its
+    // bucket, and return the number of blocks in the index
+    uint16_t check_index() const
+    {
+        uint16_t count = 0;
+        for (uint16_t b=0; b<TERRAIN_GRID_CACHE_HASH_SIZE; b++) {
+            for (uint8_t i = cache_hash[b];
+                 i != TERRAIN_GRID_CACHE_NONE;
+                 i = cache[i].hash_next) {
+                EXPECT_LT(i, cache_size());
+                EXPECT_EQ(b, cache_hash_bucket(cache[i].grid.lat, cache[i].grid.lon));
+                count++;
+                if (count > cache_size()) {
+                    // loop in a chain
+                    return count;
+                }
+            }
+        }
+        return count;
+    }
+};
+
+// SW corners of neighbouring blocks, as a flight path loads them
+static int32_t block_lat(uint16_t i)
+{
+    return -353632610 + (i % 8) * 25000;
+}
+
+static int32_t block_lon(uint16_t i)
+{
+    return 1491652300 + (i / 8) * 28000;
+}
+
+TEST(AP_Terrain, CacheIndexFind)
+{
+    AP_Terrain_Test test;
+    ASSERT_TRUE(test.allocate());
+
+    for (uint8_t i=0; i<test.cache_size(); i++) {
+        test.load(block_lat(i), block_lon(i));
+    }
+    EXPECT_EQ(test.cache_size(), test.check_index());
+    for (uint8_t i=0; i<test.cache_size(); i++) {
+        EXPECT_TRUE(test.cached(block_lat(i), block_lon(i)));
+    }
+    EXPECT_FALSE(test.cached(block_lat(test.cache_size()), block_lon(test.cache_size())));
+    EXPECT_FALSE(test.cached(0, 0));
+}
+
+TEST(AP_Terrain, CacheIndexEvict)
+{
+    AP_Terrain_Test test;
+    ASSERT_TRUE(test.allocate());
+    const uint8_t size = test.cache_size();
+
+    for (uint8_t i=0; i<size; i++) {
+        test.load(block_lat(i), block_lon(i));
+    }
+
+    // using block 0 again leaves block 1 as the least recently used,
+    // and a new block must take its slot
+    test.load(block_lat(0), block_lon(0));
+    const int16_t slot1 = test.slot(block_lat(1), block_lon(1));
+    ASSERT_NE(-1, slot1);
+    test.load(block_lat(size), block_lon(size));
+    EXPECT_EQ(slot1, test.slot(block_lat(size), block_lon(size)));
+    EXPECT_FALSE(test.cached(block_lat(1), block_lon(1)));
+    EXPECT_TRUE(test.cached(block_lat(0), block_lon(0)));
+    EXPECT_EQ(size, test.check_index());
+
+    // then block 2 is the oldest
+    const int16_t slot2 = test.slot(block_lat(2), block_lon(2));
+    ASSERT_NE(-1, slot2);
+    test.load(block_lat(size+1), block_lon(size+1));
+    EXPECT_EQ(slot2, test.slot(block_lat(size+1), block_lon(size+1)));
+    EXPECT_FALSE(test.cached(block_lat(2), block_lon(2)));
+
+    // loading three cache sizes worth of new blocks keeps exactly the
+    // last cache size of them
+    const uint16_t first = size + 2;
+    const uint16_t last = first + 3 * size;
+    for (uint16_t i=first; i<last; i++) {
+        test.load(block_lat(i), block_lon(i));
+        ASSERT_TRUE(test.cached(block_lat(i), block_lon(i)));
+        ASSERT_FALSE(test.cached(block_lat(i-size), block_lon(i-size)));
+    }
+    EXPECT_EQ(size, test.check_index());
+    for (uint16_t i=last-size; i<last; i++) {
+        EXPECT_TRUE(test.cached(block_lat(i), block_lon(i)));
+    }
+}
+
+TEST(AP_Terrain, CacheIndexReload)
+{
+    AP_Terrain_Test test;
+    ASSERT_TRUE(test.allocate());
+
+    // loading a cached block again must not add it to the index twice
+    for (uint8_t n=0; n<3; n++) {
+        for (uint8_t i=0; i<4; i++) {
+            test.load(block_lat(i), block_lon(i));
+        }
+    }
+    EXPECT_EQ(4, test.check_index());
+}
+
+#endif // AP_TERRAIN_AVAILABLE
+
+AP_GTEST_MAIN()
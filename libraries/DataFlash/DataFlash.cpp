@@ -65,6 +65,14 @@ const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
     // @Units: kB
     AP_GROUPINFO("_MAV_BUFSIZE",  5, DataFlash_Class, _params.mav_bufsize,       HAL_DATAFLASH_MAV_BUFSIZE),
 
+    // @Param: _FILE_COMPRESS
+    // @DisplayName: Compress log files
+    // @Description: When set, the DataFlash_File backend writes logs as a sequence of independently compressed blocks. This makes logs smaller and so quicker to write and download, by how much depends on how much the logged data repeats. MAVLink log download sends the compressed file as it is stored. It starts with the bytes 'DZ' rather than a message header, and can be read by Replay or expanded into a normal log with Tools/scripts/dataflash_decompress.py. Only supported on Linux boards and SITL. This only takes effect on restart.
+    // @Values: 0:Disabled,1:Enabled
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("_FILE_COMPRESS",  6, DataFlash_Class, _params.file_compress,       0),
+
     AP_GROUPEND
 };
 
@@ -448,9 +456,11 @@ void DataFlash_Class::backend_starting_new_log(const DataFlash_Backend *backend)
     for (uint8_t i=0; i<_next_backend; i++) {
         if (backends[i] == backend) { // pointer comparison!
             // reset sent masks
+            log_write_fmts_sem.take_blocking();
             for (struct log_write_fmt *f = log_write_fmts; f; f=f->next) {
                 f->sent_mask &= ~(1<<i);
             }
+            log_write_fmts_sem.give();
             break;
         }
     }
@@ -694,7 +704,9 @@ void DataFlash_Class::Log_Write(const char *name, const char *labels, const char
 
 void DataFlash_Class::Log_WriteV(const char *name, const char *labels, const char *units, const char *mults, const char *fmt, va_list arg_list)
 {
+    log_write_fmts_sem.take_blocking();
     struct log_write_fmt *f = msg_fmt_for_name(name, labels, units, mults, fmt);
+    log_write_fmts_sem.give();
     if (f == nullptr) {
         // unable to map name to a messagetype; could be out of
         // msgtypes, could be out of slots, ...
@@ -707,7 +719,9 @@ void DataFlash_Class::Log_WriteV(const char *name, const char *labels, const cha
             if (!backends[i]->Log_Write_Emit_FMT(f->msg_type)) {
                 continue;
             }
+            log_write_fmts_sem.take_blocking();
             f->sent_mask |= (1U<<i);
+            log_write_fmts_sem.give();
         }
         va_list arg_copy;
         va_copy(arg_copy, arg_list);
@@ -206,6 +206,7 @@ public:
         AP_Int8 log_disarmed;
         AP_Int8 log_replay;
         AP_Int8 mav_bufsize; // in kilobytes
+        AP_Int8 file_compress;
     } _params;
 
     const struct LogStructure *structure(uint16_t num) const;
@@ -274,6 +275,10 @@ private:
         const char *mults;
     } *log_write_fmts;
 
+    // protects log_write_fmts and their sent masks, as Log_Write() is
+    // called from threads other than the main thread
+    HAL_Semaphore log_write_fmts_sem;
+
     // return (possibly allocating) a log_write_fmt for a name
     struct log_write_fmt *msg_fmt_for_name(const char *name, const char *labels, const char *units, const char *mults, const char *fmt);
     const struct log_write_fmt *log_write_fmt_for_msg_type(uint8_t msg_type) const;
@@ -0,0 +1,277 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  compressed log stream format, see DataFlash_Compress.h
+ */
+
+#include "DataFlash_Compress.h"
+
+#include <string.h>
+#include <AP_Math/crc.h>
+
+#define MIN_MATCH 4
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint16_t hash32(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - DF_COMPRESS_HASH_BITS);
+}
+
+/*
+  write a length extension: runs of 255 followed by the remainder
+ */
+static uint8_t *put_length(uint8_t *op, const uint8_t *oend, uint32_t len)
+{
+    while (len >= 255) {
+        if (op >= oend) {
+            return nullptr;
+        }
+        *op++ = 255;
+        len -= 255;
+    }
+    if (op >= oend) {
+        return nullptr;
+    }
+    *op++ = len;
+    return op;
+}
+
+/*
+  emit one sequence of literals followed by an optional match. A
+  match_len of zero marks the final sequence of a block
+ */
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *oend,
+                             const uint8_t *literals, uint32_t lit_len,
+                             uint16_t offset, uint32_t match_len)
+{
+    if (op >= oend) {
+        return nullptr;
+    }
+    uint8_t *token = op++;
+    *token = (lit_len >= 15 ? 15 : lit_len) << 4;
+    if (lit_len >= 15) {
+        op = put_length(op, oend, lit_len - 15);
+        if (op == nullptr) {
+            return nullptr;
+        }
+    }
+    if (op + lit_len > oend) {
+        return nullptr;
+    }
+    memcpy(op, literals, lit_len);
+    op += lit_len;
+
+    if (match_len == 0) {
+        return op;
+    }
+
+    if (op + 2 > oend) {
+        return nullptr;
+    }
+    *op++ = offset & 0xFF;
+    *op++ = offset >> 8;
+    const uint32_t mlen = match_len - MIN_MATCH;
+    *token |= (mlen >= 15 ? 15 : mlen);
+    if (mlen >= 15) {
+        op = put_length(op, oend, mlen - 15);
+    }
+    return op;
+}
+
+/*
+  compress src into dst. Returns the compressed length, or 0 if it
+  does not fit in dst_size bytes
+ */
+uint32_t DataFlash_Compress::compress(const uint8_t *src, uint16_t src_len,
+                                      uint8_t *dst, uint32_t dst_size, uint16_t *hash_table)
+{
+    uint8_t *op = dst;
+    const uint8_t *oend = dst + dst_size;
+    uint32_t ip = 0;
+    uint32_t anchor = 0;
+
+    // entries hold position+1, zero is empty
+    memset(hash_table, 0, DF_COMPRESS_HASH_SIZE * sizeof(hash_table[0]));
+
+    while (ip + MIN_MATCH <= src_len) {
+        const uint32_t seq = read32(&src[ip]);
+        const uint16_t h = hash32(seq);
+        const uint32_t ref = hash_table[h];
+        hash_table[h] = ip + 1;
+        if (ref == 0 || read32(&src[ref-1]) != seq) {
+            ip++;
+            continue;
+        }
+        const uint32_t match = ref - 1;
+        uint32_t len = MIN_MATCH;
+        while (ip + len < src_len && src[match + len] == src[ip + len]) {
+            len++;
+        }
+        op = put_sequence(op, oend, &src[anchor], ip - anchor, ip - match, len);
+        if (op == nullptr) {
+            return 0;
+        }
+        ip += len;
+        anchor = ip;
+    }
+
+    // final literals
+    op = put_sequence(op, oend, &src[anchor], src_len - anchor, 0, 0);
+    if (op == nullptr) {
+        return 0;
+    }
+    return op - dst;
+}
+
+/*
+  read a length extension, returning false if it runs off the end
+ */
+static bool get_length(const uint8_t *src, uint32_t src_len, uint32_t &ip, uint32_t &len)
+{
+    uint8_t b;
+    do {
+        if (ip >= src_len) {
+            return false;
+        }
+        b = src[ip++];
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+/*
+  decompress src into dst. Returns the decompressed length, or -1 if
+  the input is corrupt or would overflow dst
+ */
+int32_t DataFlash_Compress::decompress(const uint8_t *src, uint32_t src_len,
+                                       uint8_t *dst, uint32_t dst_size)
+{
+    uint32_t ip = 0;
+    uint32_t op = 0;
+
+    while (ip < src_len) {
+        const uint8_t token = src[ip++];
+        uint32_t lit_len = token >> 4;
+        if (lit_len == 15 && !get_length(src, src_len, ip, lit_len)) {
+            return -1;
+        }
+        if (ip + lit_len > src_len || op + lit_len > dst_size) {
+            return -1;
+        }
+        memcpy(&dst[op], &src[ip], lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        if (ip == src_len) {
+            // final sequence
+            break;
+        }
+
+        if (ip + 2 > src_len) {
+            return -1;
+        }
+        const uint16_t offset = src[ip] | (src[ip+1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) {
+            return -1;
+        }
+        uint32_t match_len = token & 0x0F;
+        if (match_len == 15 && !get_length(src, src_len, ip, match_len)) {
+            return -1;
+        }
+        match_len += MIN_MATCH;
+        if (op + match_len > dst_size) {
+            return -1;
+        }
+        // byte at a time as the match may overlap the output
+        const uint8_t *match = &dst[op - offset];
+        for (uint32_t i=0; i<match_len; i++) {
+            dst[op + i] = match[i];
+        }
+        op += match_len;
+    }
+
+    return op;
+}
+
+uint32_t DataFlash_Compress::encode_block(const uint8_t *raw, uint16_t raw_len, uint32_t raw_offset,
+                                          uint8_t *out, uint32_t out_size, uint16_t *hash_table)
+{
+    if (raw_len > DF_COMPRESS_BLOCK_MAX || out_size < block_bound(raw_len)) {
+        return 0;
+    }
+
+    DataFlash_Compress_Header hdr {};
+    hdr.magic1 = DF_COMPRESS_MAGIC1;
+    hdr.magic2 = DF_COMPRESS_MAGIC2;
+    hdr.raw_len = raw_len;
+    hdr.raw_offset = raw_offset;
+
+    uint8_t *data = out + sizeof(hdr);
+    // only keep the compressed form if it is smaller
+    uint32_t data_len = compress(raw, raw_len, data, raw_len, hash_table);
+    if (data_len != 0) {
+        hdr.flags = BLOCK_FLAG_COMPRESSED;
+    } else {
+        memcpy(data, raw, raw_len);
+        data_len = raw_len;
+    }
+    hdr.data_len = data_len;
+    hdr.crc = crc_crc32(0, data, data_len);
+
+    memcpy(out, &hdr, sizeof(hdr));
+    return sizeof(hdr) + data_len;
+}
+
+bool DataFlash_Compress::header_valid(const DataFlash_Compress_Header &hdr)
+{
+    if (hdr.magic1 != DF_COMPRESS_MAGIC1 || hdr.magic2 != DF_COMPRESS_MAGIC2) {
+        return false;
+    }
+    if (hdr.raw_len > DF_COMPRESS_BLOCK_MAX ||
+        hdr.data_len > DF_COMPRESS_BOUND(hdr.raw_len)) {
+        return false;
+    }
+    return true;
+}
+
+int32_t DataFlash_Compress::decode_block(const DataFlash_Compress_Header &hdr, const uint8_t *data,
+                                         uint8_t *dst, uint32_t dst_size)
+{
+    if (!header_valid(hdr) || dst_size < hdr.raw_len) {
+        return -1;
+    }
+    if (crc_crc32(0, data, hdr.data_len) != hdr.crc) {
+        return -1;
+    }
+    if (!(hdr.flags & BLOCK_FLAG_COMPRESSED)) {
+        if (hdr.data_len != hdr.raw_len) {
+            return -1;
+        }
+        memcpy(dst, data, hdr.data_len);
+        return hdr.data_len;
+    }
+    const int32_t ret = decompress(data, hdr.data_len, dst, hdr.raw_len);
+    if (ret != hdr.raw_len) {
+        return -1;
+    }
+    return ret;
+}
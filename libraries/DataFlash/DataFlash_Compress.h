@@ -0,0 +1,91 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  compressed log stream format
+
+  A compressed log is a sequence of blocks, each a header followed by
+  the block payload. The payload is either the raw log bytes or those
+  bytes compressed with a small LZ77 codec in the style of LZ4: a
+  token byte holding a literal count and a match length, the literal
+  bytes, then a 16 bit little-endian offset back into the block. Each
+  block is compressed independently so a reader can start at any
+  block, and raw_offset gives the position of the block in the
+  uncompressed log.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <AP_Common/AP_Common.h>
+
+#define DF_COMPRESS_MAGIC1 'D'
+#define DF_COMPRESS_MAGIC2 'Z'
+
+// maximum uncompressed bytes in one block
+#define DF_COMPRESS_BLOCK_MAX 16384U
+
+// size of the match finder hash table, in entries
+#define DF_COMPRESS_HASH_BITS 12
+#define DF_COMPRESS_HASH_SIZE (1U<<DF_COMPRESS_HASH_BITS)
+
+// worst case size of a block payload for len bytes of input
+#define DF_COMPRESS_BOUND(len) ((len) + (len)/255 + 16)
+
+struct PACKED DataFlash_Compress_Header {
+    uint8_t magic1;
+    uint8_t magic2;
+    uint8_t flags;
+    uint8_t reserved;
+    uint16_t raw_len;       // uncompressed length of the block
+    uint16_t data_len;      // length of the payload following the header
+    uint32_t raw_offset;    // offset of this block in the uncompressed log
+    uint32_t crc;           // crc32 of the payload
+};
+
+class DataFlash_Compress {
+public:
+    enum {
+        BLOCK_FLAG_COMPRESSED = (1U<<0),
+    };
+
+    // size of a complete block for len bytes of input in the worst case
+    static uint32_t block_bound(uint32_t len) {
+        return sizeof(DataFlash_Compress_Header) + DF_COMPRESS_BOUND(len);
+    }
+
+    /*
+      encode raw_len bytes as a complete block (header and payload)
+      into out, which must be at least block_bound(raw_len) bytes.
+      hash_table is scratch space of DF_COMPRESS_HASH_SIZE entries.
+      Returns the number of bytes placed in out, or 0 on bad arguments
+     */
+    static uint32_t encode_block(const uint8_t *raw, uint16_t raw_len, uint32_t raw_offset,
+                                 uint8_t *out, uint32_t out_size, uint16_t *hash_table);
+
+    // check the magic and sizes in a block header
+    static bool header_valid(const DataFlash_Compress_Header &hdr);
+
+    /*
+      decode the payload of a block into dst. Returns the number of
+      bytes decoded, or -1 if the payload is corrupt
+     */
+    static int32_t decode_block(const DataFlash_Compress_Header &hdr, const uint8_t *data,
+                                uint8_t *dst, uint32_t dst_size);
+
+    // raw LZ codec, exposed for testing
+    static uint32_t compress(const uint8_t *src, uint16_t src_len,
+                             uint8_t *dst, uint32_t dst_size, uint16_t *hash_table);
+    static int32_t decompress(const uint8_t *src, uint32_t src_len,
+                              uint8_t *dst, uint32_t dst_size);
+};
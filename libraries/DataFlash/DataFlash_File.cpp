@@ -14,6 +14,7 @@
 
 #if HAL_OS_POSIX_IO || HAL_OS_FATFS_IO
 #include "DataFlash_File.h"
+#include "DataFlash_Compress.h"
 
 #include <AP_Common/AP_Common.h>
 
@@ -34,6 +35,9 @@
 #else
 #include <sys/statfs.h>
 #endif
+#if DATAFLASH_FILE_GATHER_WRITES
+#include <sys/uio.h>
+#endif
 #endif
 
 #if HAL_OS_FATFS_IO
@@ -146,6 +150,12 @@ void DataFlash_File::Init()
 
     hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)bufsize);
 
+#if DATAFLASH_FILE_GATHER_WRITES
+    if (_front._params.file_compress && !_compress_init()) {
+        hal.console->printf("DataFlash_File: no memory for compression\n");
+    }
+#endif
+
     _initialised = true;
     hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void));
 }
@@ -695,7 +705,9 @@ void DataFlash_File::get_log_boundaries(const uint16_t list_entry, uint16_t & st
 }
 
 /*
-  retrieve data from a log file
+  retrieve data from a log file. Logs written with LOG_FILE_COMPRESS
+  are sent as stored, a GCS can tell them apart by the block header
+  magic at the start of the file
  */
 int16_t DataFlash_File::get_log_data(const uint16_t list_entry, const uint16_t page, const uint32_t offset, const uint16_t len, uint8_t *data)
 {
@@ -917,6 +929,13 @@ uint16_t DataFlash_File::start_new_log(void)
     _last_write_ms = AP_HAL::millis();
     _write_offset = 0;
     _writebuf.clear();
+#if DATAFLASH_FILE_GATHER_WRITES
+    _last_fsync_ms = _last_write_ms;
+    _bytes_since_fsync = 0;
+    _compress_out_len = 0;
+    _compress_out_ofs = 0;
+    _compress_raw_offset = 0;
+#endif
     write_fd_semaphore.give();
 
     // now update lastlog.txt with the new log number
@@ -988,6 +1007,13 @@ void DataFlash_File::_io_timer(void)
     }
 
     uint32_t nbytes = _writebuf.available();
+#if DATAFLASH_FILE_GATHER_WRITES
+    if (_compress_out_len != 0) {
+        // finish off a partly written compressed block
+        _io_timer_compressed(tnow);
+        return;
+    }
+#endif
     if (nbytes == 0) {
         return;
     }
@@ -1010,9 +1036,39 @@ void DataFlash_File::_io_timer(void)
         last_io_operation = "";
     }
 
+#if DATAFLASH_FILE_GATHER_WRITES
+    if (_compress_out != nullptr) {
+        _last_write_time = tnow;
+        _io_timer_compressed(tnow);
+        return;
+    }
+#endif
+
     hal.util->perf_begin(_perf_write);
 
     _last_write_time = tnow;
+#if DATAFLASH_FILE_GATHER_WRITES
+    if (nbytes > _gather_write_max) {
+        nbytes = _gather_write_max;
+    }
+
+    // align the end of the write on a page boundary in the file
+    if ((nbytes + _write_offset) % _gather_write_align != 0) {
+        uint32_t ofs = (nbytes + _write_offset) % _gather_write_align;
+        if (ofs < nbytes) {
+            nbytes -= ofs;
+        }
+    }
+
+    // both halves of the ring buffer go out in a single system call
+    ByteBuffer::IoVec vec[2];
+    const uint8_t nvec = _writebuf.peekiovec(vec, nbytes);
+    struct iovec iov[2];
+    for (uint8_t i=0; i<nvec; i++) {
+        iov[i].iov_base = vec[i].data;
+        iov[i].iov_len = vec[i].len;
+    }
+#else
     if (nbytes > _writebuf_chunk) {
         // be kind to the FAT PX4 filesystem
         nbytes = _writebuf_chunk;
@@ -1029,6 +1085,7 @@ void DataFlash_File::_io_timer(void)
             nbytes -= ofs;
         }
     }
+#endif
 
     last_io_operation = "write";
     if (!write_fd_semaphore.take(1)) {
@@ -1038,25 +1095,26 @@ void DataFlash_File::_io_timer(void)
         write_fd_semaphore.give();
         return;
     }
+#if DATAFLASH_FILE_GATHER_WRITES
+    ssize_t nwritten = ::writev(_write_fd, iov, nvec);
+#else
     ssize_t nwritten = ::write(_write_fd, head, nbytes);
+#endif
     last_io_operation = "";
     if (nwritten <= 0) {
-        if (tnow - _last_write_ms > 2000) {
-            // if we can't write for 2 seconds we give up and close
-            // the file. This allows us to cope with temporary write
-            // failures caused by directory listing
-            hal.util->perf_count(_perf_errors);
-            last_io_operation = "close";
-            close(_write_fd);
-            last_io_operation = "";
-            _write_fd = -1;
-            _initialised = false;
-            printf("Failed to write to File: %s\n", strerror(errno));
-        }
+        _write_failed(tnow);
     } else {
         _last_write_ms = tnow;
         _write_offset += nwritten;
         _writebuf.advance(nwritten);
+#if DATAFLASH_FILE_GATHER_WRITES
+        /*
+          Linux filesystems cope with unsynced data far better than
+          FAT on NuttX, so only fsync once enough data or time has
+          built up
+         */
+        _fsync_if_due(tnow, nwritten);
+#else
         /*
           the best strategy for minimizing corruption on microSD cards
           seems to be to write in 4k chunks and fsync the file on each
@@ -1068,10 +1126,135 @@ void DataFlash_File::_io_timer(void)
         ::fsync(_write_fd);
         last_io_operation = "";
 #endif
+#endif
+    }
+    write_fd_semaphore.give();
+    hal.util->perf_end(_perf_write);
+}
+
+/*
+  called with write_fd_semaphore held when a write returns an error
+ */
+void DataFlash_File::_write_failed(uint32_t tnow)
+{
+    if (tnow - _last_write_ms > 2000) {
+        // if we can't write for 2 seconds we give up and close
+        // the file. This allows us to cope with temporary write
+        // failures caused by directory listing
+        hal.util->perf_count(_perf_errors);
+        last_io_operation = "close";
+        close(_write_fd);
+        last_io_operation = "";
+        _write_fd = -1;
+        _initialised = false;
+        printf("Failed to write to File: %s\n", strerror(errno));
+    }
+}
+
+#if DATAFLASH_FILE_GATHER_WRITES
+/*
+  Linux filesystems cope with unsynced data far better than FAT on
+  NuttX, so only fsync once enough data or time has built up. Called
+  with write_fd_semaphore held
+ */
+void DataFlash_File::_fsync_if_due(uint32_t tnow, uint32_t nwritten)
+{
+    _bytes_since_fsync += nwritten;
+#if CONFIG_HAL_BOARD_SUBTYPE != HAL_BOARD_SUBTYPE_LINUX_NONE && CONFIG_HAL_BOARD != HAL_BOARD_SITL
+    if (_bytes_since_fsync >= _fsync_min_bytes ||
+        tnow - _last_fsync_ms >= _fsync_interval_ms) {
+        hal.util->perf_begin(_perf_fsync);
+        last_io_operation = "fsync";
+        ::fsync(_write_fd);
+        last_io_operation = "";
+        hal.util->perf_end(_perf_fsync);
+        _bytes_since_fsync = 0;
+        _last_fsync_ms = tnow;
+    }
+#endif
+}
+
+/*
+  allocate the buffers for compressed logging
+ */
+bool DataFlash_File::_compress_init(void)
+{
+    _compress_out_size = DataFlash_Compress::block_bound(DF_COMPRESS_BLOCK_MAX);
+    _compress_raw = new uint8_t[DF_COMPRESS_BLOCK_MAX];
+    _compress_out = new uint8_t[_compress_out_size];
+    _compress_hash = new uint16_t[DF_COMPRESS_HASH_SIZE];
+    if (_compress_raw == nullptr || _compress_out == nullptr || _compress_hash == nullptr) {
+        delete[] _compress_raw;
+        delete[] _compress_out;
+        delete[] _compress_hash;
+        _compress_raw = nullptr;
+        _compress_out = nullptr;
+        _compress_hash = nullptr;
+        return false;
+    }
+    return true;
+}
+
+/*
+  compressed logging. Raw log data is taken from the ring buffer a
+  block at a time, compressed and written out with a block
+  header. A block which is only partly written is finished off
+  before more data is taken from the ring buffer
+ */
+void DataFlash_File::_io_timer_compressed(uint32_t tnow)
+{
+    hal.util->perf_begin(_perf_write);
+
+    if (_compress_out_len == 0) {
+        const uint32_t nbytes = MIN(_writebuf.available(), DF_COMPRESS_BLOCK_MAX);
+        ByteBuffer::IoVec vec[2];
+        const uint8_t nvec = _writebuf.peekiovec(vec, nbytes);
+        if (nvec == 0) {
+            hal.util->perf_end(_perf_write);
+            return;
+        }
+        const uint8_t *raw = vec[0].data;
+        if (nvec == 2) {
+            // wrapped, make it contiguous
+            memcpy(_compress_raw, vec[0].data, vec[0].len);
+            memcpy(&_compress_raw[vec[0].len], vec[1].data, vec[1].len);
+            raw = _compress_raw;
+        }
+        _compress_out_len = DataFlash_Compress::encode_block(raw, nbytes, _compress_raw_offset,
+                                                             _compress_out, _compress_out_size,
+                                                             _compress_hash);
+        _compress_out_ofs = 0;
+        _compress_raw_offset += nbytes;
+        _writebuf.advance(nbytes);
+    }
+
+    last_io_operation = "write";
+    if (!write_fd_semaphore.take(1)) {
+        return;
+    }
+    if (_write_fd == -1) {
+        write_fd_semaphore.give();
+        return;
+    }
+    const ssize_t nwritten = ::write(_write_fd, &_compress_out[_compress_out_ofs],
+                                     _compress_out_len - _compress_out_ofs);
+    last_io_operation = "";
+    if (nwritten <= 0) {
+        _write_failed(tnow);
+    } else {
+        _last_write_ms = tnow;
+        _write_offset += nwritten;
+        _compress_out_ofs += nwritten;
+        if (_compress_out_ofs >= _compress_out_len) {
+            _compress_out_len = 0;
+            _compress_out_ofs = 0;
+        }
+        _fsync_if_due(tnow, nwritten);
     }
     write_fd_semaphore.give();
     hal.util->perf_end(_perf_write);
 }
+#endif // DATAFLASH_FILE_GATHER_WRITES
 
 // this sensor is enabled if we should be logging at the moment
 bool DataFlash_File::logging_enabled() const
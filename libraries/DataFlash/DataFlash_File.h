@@ -11,6 +11,14 @@
 #include <AP_HAL/utility/RingBuffer.h>
 #include "DataFlash_Backend.h"
 
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+// gather both halves of the ring buffer into one writev() and fsync
+// on a time/byte policy rather than after every chunk
+#define DATAFLASH_FILE_GATHER_WRITES 1
+#else
+#define DATAFLASH_FILE_GATHER_WRITES 0
+#endif
+
 class DataFlash_File : public DataFlash_Backend
 {
 public:
@@ -104,6 +112,32 @@ private:
     const uint16_t _writebuf_chunk;
     uint32_t _last_write_time;
 
+#if DATAFLASH_FILE_GATHER_WRITES
+    // largest single write, and the alignment of writes in the file
+    const uint32_t _gather_write_max = 65536UL;
+    const uint32_t _gather_write_align = 4096UL;
+
+    // fsync once this much data has been written or this much time
+    // has passed since the last fsync, whichever comes first
+    const uint32_t _fsync_interval_ms = 1000UL;
+    const uint32_t _fsync_min_bytes = 262144UL;
+    uint32_t _last_fsync_ms;
+    uint32_t _bytes_since_fsync;
+
+    // compressed logging, buffers are only allocated if LOG_FILE_COMPRESS is set
+    uint8_t *_compress_raw;
+    uint8_t *_compress_out;
+    uint16_t *_compress_hash;
+    uint32_t _compress_out_size;
+    uint32_t _compress_out_len;     // bytes of the current block
+    uint32_t _compress_out_ofs;     // bytes of the current block written so far
+    uint32_t _compress_raw_offset;  // uncompressed bytes taken so far in this log
+    bool _compress_init(void);
+    void _io_timer_compressed(uint32_t tnow);
+    void _fsync_if_due(uint32_t tnow, uint32_t nwritten);
+#endif
+    void _write_failed(uint32_t tnow);
+
     /* construct a file name given a log number. Caller must free. */
     char *_log_file_name(const uint16_t log_num) const;
     char *_log_file_name_long(const uint16_t log_num) const;
@@ -1034,6 +1034,19 @@ struct PACKED log_Performance {
     uint16_t load;
 };
 
+// per-task run time histogram, bucket 0 is under 16us and each
+// following bucket doubles, the last holds 1024us and over
+struct PACKED log_TaskPerf {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    char name[16];
+    uint16_t tick_count;
+    uint16_t max_time;
+    uint16_t overrun_count;
+    uint16_t slip_count;
+    uint16_t hist[8];
+};
+
 struct PACKED log_SRTL {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -1276,6 +1289,8 @@ Format characters in the format string for binary log messages
       "PRX", "QBfffffffffff", "TimeUS,Health,D0,D45,D90,D135,D180,D225,D270,D315,DUp,CAn,CDis", "s-mmmmmmmmmhm", "F-BBBBBBBBB00" }, \
     { LOG_PERFORMANCE_MSG, sizeof(log_Performance),                     \
       "PM",  "QHHIIH", "TimeUS,NLon,NLoop,MaxT,Mem,Load", "s---b%", "F---0A" }, \
+    { LOG_TASK_PERF_MSG, sizeof(log_TaskPerf),                     \
+      "TASK", "QNHHHHHHHHHHHH", "TimeUS,Name,N,MaxT,Ovr,Slp,H0,H1,H2,H3,H4,H5,H6,H7", "s--s----------", "F--F----------" }, \
     { LOG_SRTL_MSG, sizeof(log_SRTL), \
       "SRTL", "QBHHBfff", "TimeUS,Active,NumPts,MaxPts,Action,N,E,D", "s----mmm", "F----000" }
 
@@ -1602,6 +1617,7 @@ enum LogMessages : uint8_t {
     LOG_ISBD_MSG,
     LOG_ASP2_MSG,
     LOG_PERFORMANCE_MSG,
+    LOG_TASK_PERF_MSG,
     _LOG_LAST_MSG_
 };
 
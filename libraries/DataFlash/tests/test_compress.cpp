@@ -0,0 +1,67 @@
+#include <AP_gtest.h>
+
+#include <DataFlash/DataFlash_Compress.h>
+#include <string.h>
+
+static uint8_t raw[DF_COMPRESS_BLOCK_MAX];
+static uint8_t block[DF_COMPRESS_BLOCK_MAX + DF_COMPRESS_BOUND(DF_COMPRESS_BLOCK_MAX)];
+static uint8_t decoded[DF_COMPRESS_BLOCK_MAX];
+static uint16_t hash_table[DF_COMPRESS_HASH_SIZE];
+
+static int32_t round_trip(uint16_t len, uint32_t &block_len)
+{
+    block_len = DataFlash_Compress::encode_block(raw, len, 1234, block, sizeof(block), hash_table);
+    DataFlash_Compress_Header hdr;
+    memcpy(&hdr, block, sizeof(hdr));
+    EXPECT_EQ(1234U, hdr.raw_offset);
+    memset(decoded, 0, sizeof(decoded));
+    return DataFlash_Compress::decode_block(hdr, &block[sizeof(hdr)], decoded, sizeof(decoded));
+}
+
+TEST(DataFlashCompressTest, RepetitiveData)
+{
+    // looks like a stream of similar log messages
+    for (uint32_t i=0; i<sizeof(raw); i++) {
+        raw[i] = (i % 32 < 3) ? 0xA3 : (i / 64) & 0xFF;
+    }
+    uint32_t block_len;
+    EXPECT_EQ((int32_t)sizeof(raw), round_trip(sizeof(raw), block_len));
+    EXPECT_EQ(0, memcmp(raw, decoded, sizeof(raw)));
+    EXPECT_LT(block_len, sizeof(raw) / 3);
+}
+
+TEST(DataFlashCompressTest, RandomDataIsStored)
+{
+    uint32_t v = 1;
+    for (uint32_t i=0; i<sizeof(raw); i++) {
+        v = v * 1103515245 + 12345;
+        raw[i] = v >> 16;
+    }
+    uint32_t block_len;
+    EXPECT_EQ(1000, round_trip(1000, block_len));
+    EXPECT_EQ(0, memcmp(raw, decoded, 1000));
+    EXPECT_LE(block_len, 1000 + sizeof(DataFlash_Compress_Header));
+}
+
+TEST(DataFlashCompressTest, ShortBlocks)
+{
+    for (uint16_t len=0; len<20; len++) {
+        memset(raw, 'x', len);
+        uint32_t block_len;
+        EXPECT_EQ(len, round_trip(len, block_len));
+        EXPECT_EQ(0, memcmp(raw, decoded, len));
+    }
+}
+
+TEST(DataFlashCompressTest, CorruptBlockRejected)
+{
+    memset(raw, 7, 4000);
+    uint32_t block_len;
+    EXPECT_EQ(4000, round_trip(4000, block_len));
+    block[block_len - 1] ^= 0x55;
+    DataFlash_Compress_Header hdr;
+    memcpy(&hdr, block, sizeof(hdr));
+    EXPECT_EQ(-1, DataFlash_Compress::decode_block(hdr, &block[sizeof(hdr)], decoded, sizeof(decoded)));
+}
+
+AP_GTEST_MAIN()
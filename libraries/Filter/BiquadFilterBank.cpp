@@ -0,0 +1,63 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BiquadFilterBank.h"
+
+/*
+  calculate low pass coefficients, using the same arithmetic as
+  DigitalBiquadFilter::compute_params() so results match exactly
+ */
+bool BiquadCoefficients::lowpass(float sample_freq, float cutoff_freq, BiquadCoefficients &ret)
+{
+    if (is_zero(cutoff_freq) || is_zero(sample_freq)) {
+        return false;
+    }
+
+    float fr = sample_freq/cutoff_freq;
+    float ohm = tanf(M_PI/fr);
+    float c = 1.0f+2.0f*cosf(M_PI/4.0f)*ohm + ohm*ohm;
+
+    ret.b0 = ohm*ohm/c;
+    ret.b1 = 2.0f*ret.b0;
+    ret.b2 = ret.b0;
+    ret.a1 = 2.0f*(ohm*ohm-1.0f)/c;
+    ret.a2 = (1.0f-2.0f*cosf(M_PI/4.0f)*ohm+ohm*ohm)/c;
+    return true;
+}
+
+/*
+  calculate notch coefficients as NotchFilter::init(), divided through
+  by a0
+ */
+bool BiquadCoefficients::notch(float sample_freq, float center_freq, float bandwidth, float attenuation_dB, BiquadCoefficients &ret)
+{
+    if (sample_freq <= 0 || bandwidth <= 0 || center_freq - bandwidth/2 <= 0) {
+        return false;
+    }
+
+    float omega = 2.0 * M_PI * center_freq / sample_freq;
+    float octaves = log2f(center_freq / (center_freq - bandwidth/2)) * 2;
+    float A = powf(10, -attenuation_dB/40);
+    float Q = sqrtf(powf(2, octaves)) / (powf(2,octaves) - 1);
+    float alpha = sinf(omega) / (2 * Q/A);
+    float a0_inv = 1.0/(1.0 + alpha/A);
+
+    ret.b0 = (1.0 + alpha*A) * a0_inv;
+    ret.b1 = -2.0 * cosf(omega) * a0_inv;
+    ret.b2 = (1.0 - alpha*A) * a0_inv;
+    ret.a1 = ret.b1;
+    ret.a2 = (1.0 - alpha/A) * a0_inv;
+    return true;
+}
@@ -0,0 +1,118 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  a bank of cascaded biquad filters run over many channels at once,
+  for example every axis of every gyro.
+
+  Each section's coefficients are shared by all channels, and the
+  filter state is stored as structure-of-arrays. Each section is
+  then a single loop over the channels with no data-dependent
+  branches, so the compiler can vectorise it with SSE or NEON where
+  available and leave plain scalar code elsewhere. Sections are
+  applied in order with no virtual call per sample.
+
+  The sections use the same direct form II arithmetic as
+  DigitalBiquadFilter.
+ */
+
+#include <AP_Math/AP_Math.h>
+#include <string.h>
+
+struct BiquadCoefficients {
+    // normalised so that a0 is 1
+    float b0, b1, b2, a1, a2;
+
+    // second order Butterworth low pass, as LowPassFilter2p. Returns
+    // false for a zero frequency, which LowPassFilter2p passes through
+    static bool lowpass(float sample_freq, float cutoff_freq, BiquadCoefficients &ret);
+
+    // notch, as NotchFilter
+    static bool notch(float sample_freq, float center_freq, float bandwidth, float attenuation_dB, BiquadCoefficients &ret);
+};
+
+template <uint8_t CHANNELS, uint8_t MAX_SECTIONS>
+class BiquadFilterBank {
+public:
+    BiquadFilterBank() :
+        _num_sections(0)
+    {
+        reset();
+    }
+
+    /*
+      replace the filter sections. The state of sections that remain
+      is kept so that changing a frequency does not cause a step
+     */
+    void set_sections(const BiquadCoefficients *coeffs, uint8_t count) {
+        count = MIN(count, MAX_SECTIONS);
+        for (uint8_t s=0; s<count; s++) {
+            _coeffs[s] = coeffs[s];
+        }
+        for (uint8_t s=_num_sections; s<count; s++) {
+            reset_section(s);
+        }
+        _num_sections = count;
+    }
+
+    uint8_t num_sections(void) const { return _num_sections; }
+
+    /*
+      filter the first nchannels channels in place. A bank with no
+      sections passes data through unchanged
+     */
+    void apply(float *data, uint8_t nchannels) {
+        nchannels = MIN(nchannels, CHANNELS);
+        for (uint8_t s=0; s<_num_sections; s++) {
+            const float b0 = _coeffs[s].b0;
+            const float b1 = _coeffs[s].b1;
+            const float b2 = _coeffs[s].b2;
+            const float a1 = _coeffs[s].a1;
+            const float a2 = _coeffs[s].a2;
+            float *z1 = _z1[s];
+            float *z2 = _z2[s];
+            for (uint8_t i=0; i<nchannels; i++) {
+                const float w = data[i] - z1[i] * a1 - z2[i] * a2;
+                data[i] = w * b0 + z1[i] * b1 + z2[i] * b2;
+                z2[i] = z1[i];
+                z1[i] = w;
+            }
+        }
+    }
+
+    // convenience for a three channel bank holding one vector
+    Vector3f apply(const Vector3f &sample) {
+        float data[3] { sample.x, sample.y, sample.z };
+        apply(data, 3);
+        return Vector3f(data[0], data[1], data[2]);
+    }
+
+    void reset(void) {
+        memset(_z1, 0, sizeof(_z1));
+        memset(_z2, 0, sizeof(_z2));
+    }
+
+private:
+    void reset_section(uint8_t s) {
+        memset(_z1[s], 0, sizeof(_z1[s]));
+        memset(_z2[s], 0, sizeof(_z2[s]));
+    }
+
+    uint8_t _num_sections;
+    BiquadCoefficients _coeffs[MAX_SECTIONS];
+    float _z1[MAX_SECTIONS][CHANNELS];
+    float _z2[MAX_SECTIONS][CHANNELS];
+};
@@ -105,7 +105,12 @@ NotchFilterVector3fParam::NotchFilterVector3fParam(void)
  */
 void NotchFilterVector3fParam::init(float _sample_freq_hz)
 {
-    filter.init(_sample_freq_hz, center_freq_hz, bandwidth_hz, attenuation_dB);
+    BiquadCoefficients notch;
+    if (BiquadCoefficients::notch(_sample_freq_hz, center_freq_hz, bandwidth_hz, attenuation_dB, notch)) {
+        filter.set_sections(&notch, 1);
+    } else {
+        filter.set_sections(nullptr, 0);
+    }
 
     sample_freq_hz = _sample_freq_hz;
     last_center_freq = center_freq_hz;
@@ -117,10 +122,20 @@ void NotchFilterVector3fParam::init(float _sample_freq_hz)
   apply a filter sample
  */
 Vector3f NotchFilterVector3fParam::apply(const Vector3f &sample)
+{
+    Vector3f ret = sample;
+    apply(&ret, 1);
+    return ret;
+}
+
+/*
+  filter count vectors in place, in a single pass over all their axes
+ */
+void NotchFilterVector3fParam::apply(Vector3f *samples, uint8_t count)
 {
     if (!enable) {
         // when not enabled it is a simple pass-through
-        return sample;
+        return;
     }
 
     // check for changed parameters
@@ -131,8 +146,18 @@ Vector3f NotchFilterVector3fParam::apply(const Vector3f &sample)
             init(sample_freq_hz);
         }
     }
-    
-    return filter.apply(sample);
+
+    count = MIN(count, NOTCH_FILTER_MAX_VECTORS);
+    float data[3*NOTCH_FILTER_MAX_VECTORS];
+    for (uint8_t i=0; i<count; i++) {
+        data[3*i+0] = samples[i].x;
+        data[3*i+1] = samples[i].y;
+        data[3*i+2] = samples[i].z;
+    }
+    filter.apply(data, 3*count);
+    for (uint8_t i=0; i<count; i++) {
+        samples[i] = Vector3f(data[3*i+0], data[3*i+1], data[3*i+2]);
+    }
 }
 
 /* 
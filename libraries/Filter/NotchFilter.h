@@ -24,7 +24,12 @@
 #include <cmath>
 #include <inttypes.h>
 #include <AP_Param/AP_Param.h>
+#include "BiquadFilterBank.h"
 
+// number of vectors NotchFilterVector3fParam can filter together
+#ifndef NOTCH_FILTER_MAX_VECTORS
+#define NOTCH_FILTER_MAX_VECTORS 3
+#endif
 
 template <class T>
 class NotchFilter {
@@ -40,13 +45,16 @@ private:
 };
 
 /*
-  a notch filter with enable and filter parameters
+  a notch filter with enable and filter parameters. Up to
+  NOTCH_FILTER_MAX_VECTORS vectors can be filtered in one pass, each
+  with its own filter state
  */
 class NotchFilterVector3fParam {
 public:
     NotchFilterVector3fParam(void);
     void init(float sample_freq_hz);
     Vector3f apply(const Vector3f &sample);
+    void apply(Vector3f *samples, uint8_t count);
 
     static const struct AP_Param::GroupInfo var_info[];
     
@@ -61,8 +69,8 @@ private:
     float last_center_freq;
     float last_bandwidth;
     float last_attenuation;
-    
-    NotchFilter<Vector3f> filter;
+
+    BiquadFilterBank<3*NOTCH_FILTER_MAX_VECTORS, 1> filter;
 };
 
 typedef NotchFilter<float> NotchFilterFloat;
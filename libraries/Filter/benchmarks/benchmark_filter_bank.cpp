@@ -0,0 +1,92 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  cost of filtering one sample of every axis of three gyros with a low
+  pass and a number of notches, using the per-vector filter classes
+  against one BiquadFilterBank pass
+ */
+#include <AP_gbenchmark.h>
+
+#include <Filter/BiquadFilterBank.h>
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/NotchFilter.h>
+
+#define NUM_GYROS 3
+#define MAX_NOTCHES 4
+#define SAMPLE_FREQ 1000.0f
+
+static Vector3f gyro_sample(uint32_t n, uint8_t gyro)
+{
+    const float t = n / SAMPLE_FREQ;
+    return Vector3f(sinf(t + gyro), cosf(t + gyro), sinf(2 * t + gyro));
+}
+
+static void BM_FilterPerVector(benchmark::State& state)
+{
+    const uint8_t notches = state.range(0);
+    LowPassFilter2pVector3f lpf[NUM_GYROS];
+    NotchFilterVector3f notch[NUM_GYROS][MAX_NOTCHES];
+    for (uint8_t g=0; g<NUM_GYROS; g++) {
+        lpf[g].set_cutoff_frequency(SAMPLE_FREQ, 40);
+        for (uint8_t i=0; i<notches; i++) {
+            notch[g][i].init(SAMPLE_FREQ, 80 * (i + 1), 20, 15);
+        }
+    }
+
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        for (uint8_t g=0; g<NUM_GYROS; g++) {
+            Vector3f v = gyro_sample(n, g);
+            for (uint8_t i=0; i<notches; i++) {
+                v = notch[g][i].apply(v);
+            }
+            v = lpf[g].apply(v);
+            gbenchmark_escape(&v);
+        }
+        n++;
+    }
+}
+
+static void BM_FilterBank(benchmark::State& state)
+{
+    const uint8_t notches = state.range(0);
+    BiquadFilterBank<3*NUM_GYROS, MAX_NOTCHES+1> bank;
+    BiquadCoefficients coeffs[MAX_NOTCHES+1];
+    for (uint8_t i=0; i<notches; i++) {
+        BiquadCoefficients::notch(SAMPLE_FREQ, 80 * (i + 1), 20, 15, coeffs[i]);
+    }
+    BiquadCoefficients::lowpass(SAMPLE_FREQ, 40, coeffs[notches]);
+    bank.set_sections(coeffs, notches+1);
+
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        float data[3*NUM_GYROS];
+        for (uint8_t g=0; g<NUM_GYROS; g++) {
+            const Vector3f v = gyro_sample(n, g);
+            data[3*g+0] = v.x;
+            data[3*g+1] = v.y;
+            data[3*g+2] = v.z;
+        }
+        bank.apply(data, 3*NUM_GYROS);
+        gbenchmark_escape(data);
+        n++;
+    }
+}
+
+// argument is the number of notches ahead of the low pass
+BENCHMARK(BM_FilterPerVector)->Arg(0)->Arg(1)->Arg(2)->Arg(4);
+BENCHMARK(BM_FilterBank)->Arg(0)->Arg(1)->Arg(2)->Arg(4);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,128 @@
+#include <AP_gtest.h>
+
+#include <Filter/BiquadFilterBank.h>
+#include <Filter/LowPassFilter2p.h>
+#include <Filter/NotchFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+#define NUM_SAMPLES 4000
+#define SAMPLE_FREQ 1000.0f
+
+// a gyro-like signal: slow motion plus a motor vibration line and noise
+static float test_signal(uint16_t n, uint8_t channel)
+{
+    const float t = n / SAMPLE_FREQ;
+    const float noise = ((n * 7919 + channel * 104729) % 1000) * 0.0002f - 0.1f;
+    return 0.5f * sinf(2 * M_PI * 2.0f * t + channel) +
+           0.3f * sinf(2 * M_PI * 80.0f * t + 0.5f * channel) +
+           noise;
+}
+
+TEST(BiquadFilterBank, LowPassMatchesLowPassFilter2p)
+{
+    LowPassFilter2pVector3f lpf[3];
+    BiquadFilterBank<9, 1> bank;
+    BiquadCoefficients coeffs;
+    ASSERT_TRUE(BiquadCoefficients::lowpass(SAMPLE_FREQ, 20, coeffs));
+    bank.set_sections(&coeffs, 1);
+    for (uint8_t v=0; v<3; v++) {
+        lpf[v].set_cutoff_frequency(SAMPLE_FREQ, 20);
+    }
+
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        float data[9];
+        for (uint8_t i=0; i<9; i++) {
+            data[i] = test_signal(n, i);
+        }
+        bank.apply(data, 9);
+        for (uint8_t v=0; v<3; v++) {
+            const Vector3f out = lpf[v].apply(Vector3f(test_signal(n, 3*v), test_signal(n, 3*v+1), test_signal(n, 3*v+2)));
+            EXPECT_NEAR(out.x, data[3*v+0], 1.0e-6f);
+            EXPECT_NEAR(out.y, data[3*v+1], 1.0e-6f);
+            EXPECT_NEAR(out.z, data[3*v+2], 1.0e-6f);
+        }
+    }
+}
+
+TEST(BiquadFilterBank, NotchMatchesNotchFilter)
+{
+    NotchFilterVector3f notch;
+    notch.init(SAMPLE_FREQ, 80, 20, 15);
+    BiquadFilterBank<3, 1> bank;
+    BiquadCoefficients coeffs;
+    ASSERT_TRUE(BiquadCoefficients::notch(SAMPLE_FREQ, 80, 20, 15, coeffs));
+    bank.set_sections(&coeffs, 1);
+
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        const Vector3f sample(test_signal(n, 0), test_signal(n, 1), test_signal(n, 2));
+        const Vector3f expected = notch.apply(sample);
+        const Vector3f out = bank.apply(sample);
+        // direct form I and II round differently
+        EXPECT_NEAR(expected.x, out.x, 1.0e-4f);
+        EXPECT_NEAR(expected.y, out.y, 1.0e-4f);
+        EXPECT_NEAR(expected.z, out.z, 1.0e-4f);
+    }
+}
+
+TEST(BiquadFilterBank, CascadeMatchesSeparateFilters)
+{
+    NotchFilterFloat notch1 {}, notch2 {};
+    LowPassFilter2pFloat lpf;
+    notch1.init(SAMPLE_FREQ, 80, 20, 30);
+    notch2.init(SAMPLE_FREQ, 160, 40, 30);
+    lpf.set_cutoff_frequency(SAMPLE_FREQ, 40);
+
+    BiquadCoefficients coeffs[3];
+    ASSERT_TRUE(BiquadCoefficients::notch(SAMPLE_FREQ, 80, 20, 30, coeffs[0]));
+    ASSERT_TRUE(BiquadCoefficients::notch(SAMPLE_FREQ, 160, 40, 30, coeffs[1]));
+    ASSERT_TRUE(BiquadCoefficients::lowpass(SAMPLE_FREQ, 40, coeffs[2]));
+    BiquadFilterBank<1, 3> bank;
+    bank.set_sections(coeffs, 3);
+    EXPECT_EQ(3, bank.num_sections());
+
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        float data = test_signal(n, 0);
+        const float expected = lpf.apply(notch2.apply(notch1.apply(data)));
+        bank.apply(&data, 1);
+        EXPECT_NEAR(expected, data, 1.0e-4f);
+    }
+}
+
+TEST(BiquadFilterBank, PassThrough)
+{
+    BiquadCoefficients coeffs;
+    EXPECT_FALSE(BiquadCoefficients::lowpass(SAMPLE_FREQ, 0, coeffs));
+    EXPECT_FALSE(BiquadCoefficients::notch(SAMPLE_FREQ, 80, 0, 15, coeffs));
+    EXPECT_FALSE(BiquadCoefficients::notch(SAMPLE_FREQ, 10, 20, 15, coeffs));
+
+    BiquadFilterBank<3, 2> bank;
+    for (uint16_t n=0; n<100; n++) {
+        const Vector3f sample(test_signal(n, 0), test_signal(n, 1), test_signal(n, 2));
+        const Vector3f out = bank.apply(sample);
+        EXPECT_FLOAT_EQ(sample.x, out.x);
+        EXPECT_FLOAT_EQ(sample.y, out.y);
+        EXPECT_FLOAT_EQ(sample.z, out.z);
+    }
+}
+
+TEST(BiquadFilterBank, NotchAttenuates)
+{
+    BiquadCoefficients coeffs;
+    ASSERT_TRUE(BiquadCoefficients::notch(SAMPLE_FREQ, 80, 20, 30, coeffs));
+    BiquadFilterBank<1, 1> bank;
+    bank.set_sections(&coeffs, 1);
+
+    float peak = 0;
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        float data = sinf(2 * M_PI * 80.0f * n / SAMPLE_FREQ);
+        bank.apply(&data, 1);
+        if (n > NUM_SAMPLES / 2) {
+            peak = MAX(peak, fabsf(data));
+        }
+    }
+    // 30dB is a factor of 31.6
+    EXPECT_LT(peak, 0.05f);
+}
+
+AP_GTEST_MAIN()
@@ -29,6 +29,10 @@
 #define CHECK_PAYLOAD_SIZE(id) if (comm_get_txspace(chan) < packet_overhead()+MAVLINK_MSG_ID_ ## id ## _LEN) return false
 #define CHECK_PAYLOAD_SIZE2(id) if (!HAVE_PAYLOAD_SPACE(chan, id)) return false
 
+// scheduled message intervals which are not a time in milliseconds
+#define MESSAGE_INTERVAL_STREAM         0       // send at the rate of its stream
+#define MESSAGE_INTERVAL_DISABLED       0xFFFF  // don't send
+
 //  GCS Message ID's
 /// NOTE: to ensure we never block on sending MAVLink messages
 /// please keep each MSG_ to a single MAVLink message. If need be
@@ -147,6 +151,11 @@ public:
     // see if we should send a stream now. Called at 50Hz
     bool        stream_trigger(enum streams stream_num);
 
+    // number of times a message has been sent on this link, and the
+    // number of its scheduled sends skipped because it fell a whole
+    // interval behind, for whatever reason
+    void get_message_stats(enum ap_message id, uint32_t &sent, uint32_t &skipped) const;
+
     bool is_high_bandwidth() { return chan == MAVLINK_COMM_0; }
     // return true if this channel has hardware flow control
     bool have_flow_control();
@@ -271,8 +280,9 @@ protected:
     uint16_t        waypoint_request_i; // request index
     uint16_t        waypoint_request_last; // last request index
 
-    AP_Param *                  _queued_parameter;      ///< next parameter to
-                                                        // be sent in queue
+    AP_Param *                  _queued_parameter;      ///< first parameter, and
+                                                        // non-null while a
+                                                        // download is queued
     mavlink_channel_t           chan;
     uint8_t packet_overhead(void) const { return packet_overhead_chan(chan); }
 
@@ -362,6 +372,8 @@ protected:
     virtual MAV_RESULT handle_command_long_packet(const mavlink_command_long_t &packet);
     MAV_RESULT handle_command_camera(const mavlink_command_long_t &packet);
     MAV_RESULT handle_command_do_send_banner(const mavlink_command_long_t &packet);
+    MAV_RESULT handle_command_task_stats(const mavlink_command_long_t &packet);
+    MAV_RESULT handle_command_set_message_interval(const mavlink_command_long_t &packet);
     MAV_RESULT handle_command_do_set_roi(const mavlink_command_int_t &packet);
     MAV_RESULT handle_command_do_set_roi(const mavlink_command_long_t &packet);
     virtual MAV_RESULT handle_command_do_set_roi(const Location &roi_loc);
@@ -408,10 +420,10 @@ private:
 
     /// Perform queued sending operations
     ///
-    enum ap_var_type            _queued_parameter_type; ///< type of the next
-                                                        // parameter
+    enum ap_var_type            _queued_parameter_type; ///< type of the last
+                                                        // parameter sent
     AP_Param::ParamToken        _queued_parameter_token; ///AP_Param token for
-                                                         // next() call
+                                                         // next_scalar() call
     uint16_t                    _queued_parameter_index; ///< next queued
                                                          // parameter's index
     uint16_t                    _queued_parameter_count; ///< saved count of
@@ -456,6 +468,44 @@ private:
     enum ap_message deferred_messages[MSG_LAST];
     uint8_t next_deferred_message;
     uint8_t num_deferred_messages;
+    // bit for each ap_message in deferred_messages
+    uint64_t deferred_mask;
+
+    // streamed message scheduler. Each message of each stream has its
+    // own next due time, kept in a min-heap so a call only looks at
+    // the messages that are due. The vehicles stream fewer than
+    // MSG_LAST messages between them. A message given an interval by
+    // MAV_CMD_SET_MESSAGE_INTERVAL uses it in place of its stream
+    // rate, and one in no stream is added with a stream of NUM_STREAMS
+    struct scheduled_message {
+        uint32_t next_due_ms;
+        uint8_t id;         // enum ap_message
+        uint8_t stream;     // enum streams
+        uint16_t interval_ms; // MESSAGE_INTERVAL_STREAM, MESSAGE_INTERVAL_DISABLED or ms
+    };
+    scheduled_message schedule[MSG_LAST];
+    uint8_t schedule_size;
+
+    // bytes the streams may still send. It grows at the link's data
+    // rate and is capped at the UART's free transmit space
+    int32_t stream_bytes_allowed;
+    uint32_t stream_budget_ms;
+
+    struct {
+        uint32_t sent;
+        uint32_t skipped;
+    } message_stats[MSG_LAST];
+    uint32_t last_message_stats_log_ms;
+
+    void init_message_schedule(void);
+    uint16_t stream_interval_ms(enum streams stream_num);
+    uint16_t message_interval_ms(const scheduled_message &m);
+    bool set_message_interval(enum ap_message id, uint16_t interval_ms);
+    static bool ap_message_for_mavlink_id(uint32_t mavlink_id, enum ap_message &id);
+    void schedule_sift_down(uint8_t i);
+    void schedule_sift_up(uint8_t i);
+    void send_scheduled_messages(void);
+    void log_message_stats(void);
 
     // time when we missed sending a parameter for GCS
     static uint32_t reserve_param_space_start_ms;
@@ -489,9 +539,11 @@ private:
         char param_name[AP_MAX_NAME_SIZE+1];
     };
 
-    // queue of pending parameter requests and replies
-    static ObjectBuffer<pending_param_request> param_requests;
-    static ObjectBuffer<pending_param_reply> param_replies;
+    // queue of pending parameter requests and replies. Requests are
+    // only pushed by the main thread and popped by the IO thread, and
+    // replies the other way round
+    static SPSCObjectBuffer<pending_param_request> param_requests;
+    static SPSCObjectBuffer<pending_param_reply> param_replies;
 
     // have we registered the IO timer callback?
     static bool param_timer_registered;
@@ -556,6 +608,14 @@ private:
         bool active;
     } alternative;
 
+    // bytes read from the port but not yet parsed. They are kept for
+    // the next update() if its time budget runs out part way through
+    struct {
+        uint8_t buf[64];
+        uint8_t ofs;
+        uint8_t len;
+    } receive_chunk;
+
     // state associated with offboard transport lag correction
     struct {
         bool initialised;
@@ -23,6 +23,7 @@
 #include <AP_Gripper/AP_Gripper.h>
 #include <AP_BLHeli/AP_BLHeli.h>
 #include <AP_Common/Semaphore.h>
+#include <AP_Scheduler/AP_Scheduler.h>
 
 #include "GCS.h"
 
@@ -76,6 +77,8 @@ GCS_MAVLINK::init(AP_HAL::UARTDriver *port, mavlink_channel_t mav_chan)
     snprintf(_perf_update_name, sizeof(_perf_update_name), "GCS_Update_%u", chan);
     _perf_update = hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, _perf_update_name);
 
+    init_message_schedule();
+
     initialised = true;
 }
 
@@ -836,9 +839,12 @@ mission_ack:
 void GCS_MAVLINK::push_deferred_messages()
 {
     while (num_deferred_messages != 0) {
-        if (!try_send_message(deferred_messages[next_deferred_message])) {
+        const ap_message id = deferred_messages[next_deferred_message];
+        if (!try_send_message(id)) {
             break;
         }
+        deferred_mask &= ~(1ULL << id);
+        message_stats[id].sent++;
         next_deferred_message++;
         if (next_deferred_message == ARRAY_SIZE(deferred_messages)) {
             next_deferred_message = 0;
@@ -855,7 +861,7 @@ void GCS_MAVLINK::retry_deferred()
 // send a message using mavlink, handling message queueing
 void GCS_MAVLINK::send_message(enum ap_message id)
 {
-    uint8_t i, nextid;
+    static_assert(MSG_LAST <= 64, "deferred_mask needs a bit per ap_message");
 
     if (id == MSG_HEARTBEAT) {
         save_signing_timestamp(false);
@@ -868,34 +874,38 @@ void GCS_MAVLINK::send_message(enum ap_message id)
     if (num_deferred_messages == 0) {
         if (try_send_message(id)) {
             // yay, we sent it!
+            message_stats[id].sent++;
             return;
         }
     }
 
     // we failed to send the message this time around, so try to defer:
-    if (num_deferred_messages == ARRAY_SIZE(deferred_messages)) {
-        // the defer buffer is full, discard this attempt to send.
-        // Note that the message *may* already be in the defer buffer
+    if (deferred_mask & (1ULL << id)) {
+        // it's already deferred
         return;
     }
 
-    // check if this message is deferred:
-    for (i=0, nextid = next_deferred_message; i < num_deferred_messages; i++) {
-        if (deferred_messages[nextid] == id) {
-            // it's already deferred
-            return;
-        }
-        nextid++;
-        if (nextid == ARRAY_SIZE(deferred_messages)) {
-            nextid = 0;
-        }
+    // not already deferred, defer it. There is room for every
+    // ap_message so the buffer can't be full
+    uint8_t nextid = next_deferred_message + num_deferred_messages;
+    if (nextid >= ARRAY_SIZE(deferred_messages)) {
+        nextid -= ARRAY_SIZE(deferred_messages);
     }
-
-    // not already deferred, defer it
     deferred_messages[nextid] = id;
+    deferred_mask |= (1ULL << id);
     num_deferred_messages++;
 }
 
+void GCS_MAVLINK::get_message_stats(enum ap_message id, uint32_t &sent, uint32_t &skipped) const
+{
+    if (id >= MSG_LAST) {
+        sent = skipped = 0;
+        return;
+    }
+    sent = message_stats[id].sent;
+    skipped = message_stats[id].skipped;
+}
+
 void GCS_MAVLINK::packetReceived(const mavlink_status_t &status,
                                  mavlink_message_t &msg)
 {
@@ -935,11 +945,23 @@ GCS_MAVLINK::update(uint32_t max_time_us)
 
     status.packet_rx_drop_count = 0;
 
-    // process received bytes
+    // process received bytes, reading them from the port a chunk at a
+    // time
     uint16_t nbytes = comm_get_available(chan);
-    for (uint16_t i=0; i<nbytes; i++)
+    for (uint16_t i=0; ; i++)
     {
-        const uint8_t c = (uint8_t)_port->read();
+        if (receive_chunk.ofs == receive_chunk.len) {
+            if (nbytes == 0) {
+                break;
+            }
+            receive_chunk.ofs = 0;
+            receive_chunk.len = _port->read(receive_chunk.buf, MIN(nbytes, sizeof(receive_chunk.buf)));
+            if (receive_chunk.len == 0) {
+                break;
+            }
+            nbytes -= receive_chunk.len;
+        }
+        const uint8_t c = receive_chunk.buf[receive_chunk.ofs++];
         const uint32_t protocol_timeout = 4000;
         
         if (alternative.handler &&
@@ -2689,6 +2711,113 @@ MAV_RESULT GCS_MAVLINK::handle_command_do_send_banner(const mavlink_command_long
     return MAV_RESULT_ACCEPTED;
 }
 
+/*
+  the ap_message which sends a MAVLink message, for the streamed
+  messages. Messages sent on request or as replies have no entry
+ */
+bool GCS_MAVLINK::ap_message_for_mavlink_id(uint32_t mavlink_id, enum ap_message &id)
+{
+    static const struct {
+        uint32_t mavlink_id;
+        enum ap_message msg_id;
+    } map[] {
+        { MAVLINK_MSG_ID_ATTITUDE,                 MSG_ATTITUDE},
+        { MAVLINK_MSG_ID_GLOBAL_POSITION_INT,      MSG_LOCATION},
+        { MAVLINK_MSG_ID_SYS_STATUS,               MSG_EXTENDED_STATUS1},
+        { MAVLINK_MSG_ID_MEMINFO,                  MSG_EXTENDED_STATUS2},
+        { MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT,    MSG_NAV_CONTROLLER_OUTPUT},
+        { MAVLINK_MSG_ID_MISSION_CURRENT,          MSG_CURRENT_WAYPOINT},
+        { MAVLINK_MSG_ID_VFR_HUD,                  MSG_VFR_HUD},
+        { MAVLINK_MSG_ID_SERVO_OUTPUT_RAW,         MSG_SERVO_OUTPUT_RAW},
+        { MAVLINK_MSG_ID_RC_CHANNELS_RAW,          MSG_RADIO_IN},
+        { MAVLINK_MSG_ID_RC_CHANNELS,              MSG_RADIO_IN},
+        { MAVLINK_MSG_ID_RAW_IMU,                  MSG_RAW_IMU1},
+        { MAVLINK_MSG_ID_SCALED_PRESSURE,          MSG_RAW_IMU2},
+        { MAVLINK_MSG_ID_SENSOR_OFFSETS,           MSG_RAW_IMU3},
+        { MAVLINK_MSG_ID_GPS_RAW_INT,              MSG_GPS_RAW},
+        { MAVLINK_MSG_ID_GPS_RTK,                  MSG_GPS_RTK},
+        { MAVLINK_MSG_ID_GPS2_RAW,                 MSG_GPS2_RAW},
+        { MAVLINK_MSG_ID_GPS2_RTK,                 MSG_GPS2_RTK},
+        { MAVLINK_MSG_ID_SYSTEM_TIME,              MSG_SYSTEM_TIME},
+        { MAVLINK_MSG_ID_RC_CHANNELS_SCALED,       MSG_SERVO_OUT},
+        { MAVLINK_MSG_ID_FENCE_STATUS,             MSG_FENCE_STATUS},
+        { MAVLINK_MSG_ID_AHRS,                     MSG_AHRS},
+        { MAVLINK_MSG_ID_SIMSTATE,                 MSG_SIMSTATE},
+        { MAVLINK_MSG_ID_HWSTATUS,                 MSG_HWSTATUS},
+        { MAVLINK_MSG_ID_WIND,                     MSG_WIND},
+        { MAVLINK_MSG_ID_RANGEFINDER,              MSG_RANGEFINDER},
+        { MAVLINK_MSG_ID_TERRAIN_REQUEST,          MSG_TERRAIN},
+        { MAVLINK_MSG_ID_BATTERY2,                 MSG_BATTERY2},
+        { MAVLINK_MSG_ID_CAMERA_FEEDBACK,          MSG_CAMERA_FEEDBACK},
+        { MAVLINK_MSG_ID_MOUNT_STATUS,             MSG_MOUNT_STATUS},
+        { MAVLINK_MSG_ID_OPTICAL_FLOW,             MSG_OPTICAL_FLOW},
+        { MAVLINK_MSG_ID_GIMBAL_REPORT,            MSG_GIMBAL_REPORT},
+        { MAVLINK_MSG_ID_MAG_CAL_PROGRESS,         MSG_MAG_CAL_PROGRESS},
+        { MAVLINK_MSG_ID_MAG_CAL_REPORT,           MSG_MAG_CAL_REPORT},
+        { MAVLINK_MSG_ID_EKF_STATUS_REPORT,        MSG_EKF_STATUS_REPORT},
+        { MAVLINK_MSG_ID_LOCAL_POSITION_NED,       MSG_LOCAL_POSITION},
+        { MAVLINK_MSG_ID_PID_TUNING,               MSG_PID_TUNING},
+        { MAVLINK_MSG_ID_VIBRATION,                MSG_VIBRATION},
+        { MAVLINK_MSG_ID_RPM,                      MSG_RPM},
+        { MAVLINK_MSG_ID_POSITION_TARGET_GLOBAL_INT, MSG_POSITION_TARGET_GLOBAL_INT},
+        { MAVLINK_MSG_ID_ADSB_VEHICLE,             MSG_ADSB_VEHICLE},
+        { MAVLINK_MSG_ID_BATTERY_STATUS,           MSG_BATTERY_STATUS},
+        { MAVLINK_MSG_ID_AOA_SSA,                  MSG_AOA_SSA},
+        { MAVLINK_MSG_ID_ESC_TELEMETRY_1_TO_4,     MSG_ESC_TELEMETRY},
+        { MAVLINK_MSG_ID_NAMED_VALUE_FLOAT,        MSG_NAMED_FLOAT},
+    };
+    for (uint8_t i=0; i<ARRAY_SIZE(map); i++) {
+        if (map[i].mavlink_id == mavlink_id) {
+            id = map[i].msg_id;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  set the interval of a streamed message on this link. param1 is the
+  MAVLink message id and param2 the interval in microseconds, -1 to
+  stop sending it or 0 to return it to the rate of its stream
+ */
+MAV_RESULT GCS_MAVLINK::handle_command_set_message_interval(const mavlink_command_long_t &packet)
+{
+    enum ap_message id;
+    if (!ap_message_for_mavlink_id((uint32_t)packet.param1, id)) {
+        return MAV_RESULT_UNSUPPORTED;
+    }
+    uint16_t interval_ms;
+    if (packet.param2 < -0.5f) {
+        interval_ms = MESSAGE_INTERVAL_DISABLED;
+    } else if (packet.param2 < 0.5f) {
+        interval_ms = MESSAGE_INTERVAL_STREAM;
+    } else {
+        interval_ms = constrain_float(packet.param2 * 0.001f, 1, MESSAGE_INTERVAL_DISABLED - 1);
+    }
+    if (!set_message_interval(id, interval_ms)) {
+        return MAV_RESULT_FAILED;
+    }
+    return MAV_RESULT_ACCEPTED;
+}
+
+/*
+  reply with the run time statistics of the most expensive scheduler
+  tasks. param1 is the number of tasks, 3 if zero
+ */
+MAV_RESULT GCS_MAVLINK::handle_command_task_stats(const mavlink_command_long_t &packet)
+{
+    const AP_Scheduler *scheduler = AP_Scheduler::get_instance();
+    if (scheduler == nullptr) {
+        return MAV_RESULT_UNSUPPORTED;
+    }
+    uint8_t num_report = 3;
+    if (packet.param1 >= 1) {
+        num_report = MIN(packet.param1, (float)SCHEDULER_TASK_STATS_MAX_REPORT);
+    }
+    scheduler->send_task_stats(num_report, this);
+    return MAV_RESULT_ACCEPTED;
+}
+
 MAV_RESULT GCS_MAVLINK::handle_command_do_set_mode(const mavlink_command_long_t &packet)
 {
     const MAV_MODE _base_mode = (MAV_MODE)packet.param1;
@@ -2773,6 +2902,14 @@ MAV_RESULT GCS_MAVLINK::handle_command_long_packet(const mavlink_command_long_t
         result = handle_command_do_send_banner(packet);
         break;
 
+    case MAV_CMD_USER_1:
+        result = handle_command_task_stats(packet);
+        break;
+
+    case MAV_CMD_SET_MESSAGE_INTERVAL:
+        result = handle_command_set_message_interval(packet);
+        break;
+
     case MAV_CMD_PREFLIGHT_REBOOT_SHUTDOWN:
         result = handle_preflight_reboot(packet);
         break;
@@ -3314,19 +3451,255 @@ void GCS_MAVLINK::data_stream_send(void)
         return;
     }
 
+    send_scheduled_messages();
+
+    log_message_stats();
+}
+
+/*
+  build the message schedule from the vehicle's stream definitions,
+  with every message due now
+ */
+void GCS_MAVLINK::init_message_schedule(void)
+{
+    const uint32_t now = AP_HAL::millis();
+    schedule_size = 0;
     for (uint8_t i=0; all_stream_entries[i].ap_message_ids != nullptr; i++) {
-        const streams id = (streams)all_stream_entries[i].stream_id;
-        if (!stream_trigger(id)) {
+        for (uint8_t j=0; j<all_stream_entries[i].num_ap_message_ids; j++) {
+            if (schedule_size == ARRAY_SIZE(schedule)) {
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+                AP_HAL::panic("Too many streamed messages");
+#else
+                // the remaining messages will never be streamed
+                gcs().send_text(MAV_SEVERITY_CRITICAL, "Too many streamed messages");
+#endif
+                return;
+            }
+            scheduled_message &m = schedule[schedule_size++];
+            m.next_due_ms = now;
+            m.id = (uint8_t)all_stream_entries[i].ap_message_ids[j];
+            m.stream = (uint8_t)all_stream_entries[i].stream_id;
+            m.interval_ms = MESSAGE_INTERVAL_STREAM;
+        }
+    }
+    // equal due times are already in heap order
+    stream_bytes_allowed = 0;
+    stream_budget_ms = now;
+}
+
+/*
+  milliseconds between sends of a message in a stream, or zero if the
+  stream is off. Each step of stream_slowdown adds 20ms, as it used to
+  add a 50Hz tick
+ */
+uint16_t GCS_MAVLINK::stream_interval_ms(enum streams stream_num)
+{
+    float rate = (uint8_t)streamRates[stream_num].get();
+    rate *= adjust_rate_for_stream_trigger(stream_num);
+    if (rate <= 0) {
+        return 0;
+    }
+    if (rate > 50) {
+        rate = 50;
+    }
+    return 1000 / rate + stream_slowdown * 20;
+}
+
+/*
+  milliseconds between sends of a scheduled message, or zero if it is
+  not to be sent
+ */
+uint16_t GCS_MAVLINK::message_interval_ms(const scheduled_message &m)
+{
+    switch (m.interval_ms) {
+    case MESSAGE_INTERVAL_STREAM:
+        if (m.stream >= NUM_STREAMS) {
+            return 0;
+        }
+        return stream_interval_ms((enum streams)m.stream);
+    case MESSAGE_INTERVAL_DISABLED:
+        return 0;
+    default:
+        return m.interval_ms + stream_slowdown * 20;
+    }
+}
+
+/*
+  give a message its own interval, or return it to its stream rate
+  with MESSAGE_INTERVAL_STREAM. The message is made due now so the
+  new interval takes effect at once. Returns false if the message
+  isn't streamed and there is no room to schedule it
+ */
+bool GCS_MAVLINK::set_message_interval(enum ap_message id, uint16_t interval_ms)
+{
+    const uint32_t now = AP_HAL::millis();
+    bool found = false;
+    for (uint8_t i=0; i<schedule_size; i++) {
+        if (schedule[i].id != id) {
             continue;
         }
-        const ap_message *msg_ids = all_stream_entries[i].ap_message_ids;
-        for (uint8_t j=0; j<all_stream_entries[i].num_ap_message_ids; j++) {
-            const ap_message msg_id = msg_ids[j];
-            send_message(msg_id);
+        schedule[i].interval_ms = interval_ms;
+        schedule[i].next_due_ms = now;
+        schedule_sift_up(i);
+        found = true;
+    }
+    if (found ||
+        interval_ms == MESSAGE_INTERVAL_STREAM ||
+        interval_ms == MESSAGE_INTERVAL_DISABLED) {
+        // a message in no stream already isn't sent
+        return true;
+    }
+    if (schedule_size == ARRAY_SIZE(schedule)) {
+        return false;
+    }
+    scheduled_message &m = schedule[schedule_size];
+    m.next_due_ms = now;
+    m.id = (uint8_t)id;
+    m.stream = NUM_STREAMS;
+    m.interval_ms = interval_ms;
+    schedule_sift_up(schedule_size++);
+    return true;
+}
+
+// restore heap order after the due time of schedule[i] moved earlier
+void GCS_MAVLINK::schedule_sift_up(uint8_t i)
+{
+    const scheduled_message m = schedule[i];
+    while (i > 0) {
+        const uint8_t parent = (i - 1) / 2;
+        if ((int32_t)(m.next_due_ms - schedule[parent].next_due_ms) >= 0) {
+            break;
+        }
+        schedule[i] = schedule[parent];
+        i = parent;
+    }
+    schedule[i] = m;
+}
+
+// restore heap order after the due time of schedule[i] moved later
+void GCS_MAVLINK::schedule_sift_down(uint8_t i)
+{
+    const scheduled_message m = schedule[i];
+    while (true) {
+        uint8_t child = 2 * i + 1;
+        if (child >= schedule_size) {
+            break;
+        }
+        if (child + 1 < schedule_size &&
+            (int32_t)(schedule[child+1].next_due_ms - schedule[child].next_due_ms) < 0) {
+            child++;
         }
-        if (gcs().out_of_time()) {
+        if ((int32_t)(schedule[child].next_due_ms - m.next_due_ms) >= 0) {
             break;
         }
+        schedule[i] = schedule[child];
+        i = child;
+    }
+    schedule[i] = m;
+}
+
+/*
+  send the streamed messages that are due, most overdue first, until
+  the byte budget or the UART's transmit space runs out. A message
+  that can't be sent stays at the front for the next call
+ */
+void GCS_MAVLINK::send_scheduled_messages(void)
+{
+    const uint32_t now = AP_HAL::millis();
+
+    // kilobytes per second is close enough to bytes per millisecond
+    stream_bytes_allowed += _port->bw_in_kilobytes_per_second() * (now - stream_budget_ms);
+    stream_budget_ms = now;
+    const int32_t txspace = comm_get_txspace(chan);
+    if (stream_bytes_allowed > txspace) {
+        stream_bytes_allowed = txspace;
+    }
+
+    bool streaming = false;
+    for (uint8_t i=0; i<NUM_STREAMS; i++) {
+        if (streamRates[i] > 0) {
+            streaming = true;
+        }
+    }
+    if (streaming) {
+        chan_is_streaming |= (1U<<(chan-MAVLINK_COMM_0));
+    } else {
+        chan_is_streaming &= ~(1U<<(chan-MAVLINK_COMM_0));
+    }
+
+    // messages that send_message() couldn't send go first
+    push_deferred_messages();
+    if (num_deferred_messages != 0) {
+        return;
+    }
+
+    while (schedule_size > 0 && !gcs().out_of_time()) {
+        scheduled_message &m = schedule[0];
+        if ((int32_t)(m.next_due_ms - now) > 0) {
+            // nothing else is due
+            break;
+        }
+        const uint16_t interval_ms = message_interval_ms(m);
+        if (interval_ms == 0) {
+            // the message or its stream is off; check again later in
+            // case it is turned on
+            m.next_due_ms = now + 200;
+            schedule_sift_down(0);
+            continue;
+        }
+        if (stream_bytes_allowed <= 0) {
+            break;
+        }
+        const int32_t space_before = comm_get_txspace(chan);
+        if (!try_send_message((enum ap_message)m.id)) {
+            break;
+        }
+        stream_bytes_allowed -= space_before - (int32_t)comm_get_txspace(chan);
+        message_stats[m.id].sent++;
+
+        m.next_due_ms += interval_ms;
+        if ((int32_t)(m.next_due_ms - now) <= 0) {
+            // a whole interval behind; skip the missed sends rather
+            // than bursting to catch up
+            message_stats[m.id].skipped += (now - m.next_due_ms) / interval_ms + 1;
+            m.next_due_ms = now + interval_ms;
+        }
+        schedule_sift_down(0);
+    }
+}
+
+/*
+  log the send and skip counts of each message sent on this link every
+  ten seconds, to show which streams the link can't keep up with
+ */
+void GCS_MAVLINK::log_message_stats(void)
+{
+    const uint32_t now = AP_HAL::millis();
+    if (now - last_message_stats_log_ms < 10000) {
+        return;
+    }
+    last_message_stats_log_ms = now;
+
+    DataFlash_Class *df = DataFlash_Class::instance();
+    if (df == nullptr) {
+        return;
+    }
+    for (uint8_t i=0; i<MSG_LAST; i++) {
+        uint32_t sent, skipped;
+        get_message_stats((enum ap_message)i, sent, skipped);
+        if (sent == 0 && skipped == 0) {
+            continue;
+        }
+        df->Log_Write("MSGS",
+                      "TimeUS,Chan,Id,Sent,Skip",
+                      "s----",
+                      "F----",
+                      "QBBII",
+                      AP_HAL::micros64(),
+                      (uint8_t)chan,
+                      i,
+                      sent,
+                      skipped);
     }
 }
 
@@ -23,11 +23,14 @@
 extern const AP_HAL::HAL& hal;
 
 // queue of pending parameter requests and replies
-ObjectBuffer<GCS_MAVLINK::pending_param_request> GCS_MAVLINK::param_requests(20);
-ObjectBuffer<GCS_MAVLINK::pending_param_reply> GCS_MAVLINK::param_replies(5);
+SPSCObjectBuffer<GCS_MAVLINK::pending_param_request> GCS_MAVLINK::param_requests(20);
+SPSCObjectBuffer<GCS_MAVLINK::pending_param_reply> GCS_MAVLINK::param_replies(5);
 
 bool GCS_MAVLINK::param_timer_registered;
 
+// name a GCS requests to get the hash of all parameters
+#define PARAM_HASH_CHECK_NAME "_HASH_CHECK"
+
 /**
  * @brief Send the next pending parameter, called from deferred message
  * handling code
@@ -74,16 +77,30 @@ GCS_MAVLINK::queued_param_send()
     while (_queued_parameter != nullptr && count--) {
         AP_Param      *vp;
         float value;
+        char param_name[AP_MAX_NAME_SIZE+1];
 
-        // copy the current parameter and prepare to move to the next
-        vp = _queued_parameter;
+        // the scalar index gives the parameter with its name. Without
+        // it, walk on from the parameter sent last
+        vp = AP_Param::find_by_index_with_name(_queued_parameter_index, &_queued_parameter_type,
+                                               &_queued_parameter_token, param_name);
+        if (vp == nullptr) {
+            if (_queued_parameter_index == 0) {
+                // the token and type are from AP_Param::first()
+                vp = _queued_parameter;
+            } else {
+                vp = AP_Param::next_scalar(&_queued_parameter_token, &_queued_parameter_type);
+            }
+            if (vp == nullptr) {
+                // all sent
+                _queued_parameter = nullptr;
+                break;
+            }
+            vp->copy_name_token(_queued_parameter_token, param_name, sizeof(param_name), true);
+        }
 
         // if the parameter can be cast to float, report it here and break out of the loop
         value = vp->cast_to_float(_queued_parameter_type);
 
-        char param_name[AP_MAX_NAME_SIZE];
-        vp->copy_name_token(_queued_parameter_token, param_name, sizeof(param_name), true);
-
         mavlink_msg_param_value_send(
             chan,
             param_name,
@@ -92,8 +109,10 @@ GCS_MAVLINK::queued_param_send()
             _queued_parameter_count,
             _queued_parameter_index);
 
-        _queued_parameter = AP_Param::next_scalar(&_queued_parameter_token, &_queued_parameter_type);
         _queued_parameter_index++;
+        if (_queued_parameter_index >= _queued_parameter_count) {
+            _queued_parameter = nullptr;
+        }
 
         if (AP_HAL::micros() - tstart > 1000) {
             // don't use more than 1ms sending blocks of parameters
@@ -406,6 +425,22 @@ void GCS_MAVLINK::param_io_timer(void)
             return;
         }
         vp->copy_name_token(token, reply.param_name, AP_MAX_NAME_SIZE, true);
+    } else if (strncmp(req.param_name, PARAM_HASH_CHECK_NAME, AP_MAX_NAME_SIZE) == 0) {
+        /*
+          the 24 bit hash of all parameters, sent as an int32 value
+          like any other. A GCS with a cached copy of the parameters
+          with the same hash can skip the download
+         */
+        const uint32_t hash = AP_Param::parameter_set_hash();
+        strncpy(reply.param_name, PARAM_HASH_CHECK_NAME, AP_MAX_NAME_SIZE+1);
+        reply.p_type = AP_PARAM_INT32;
+        reply.value = hash;
+        reply.chan = req.chan;
+        reply.param_name[AP_MAX_NAME_SIZE] = 0;
+        reply.param_index = -1;
+        reply.count = AP_Param::count_parameters();
+        param_replies.push(reply);
+        return;
     } else {
         strncpy(reply.param_name, req.param_name, AP_MAX_NAME_SIZE+1);
         vp = AP_Param::find(req.param_name, &reply.p_type);
@@ -27,7 +27,13 @@ extern const AP_HAL::HAL& hal;
 #define ROUTING_DEBUG 0
 
 // constructor
-MAVLink_routing::MAVLink_routing(void) : num_routes(0) {}
+MAVLink_routing::MAVLink_routing(void) :
+    num_routes(0),
+    all_channel_mask(0)
+{
+    memset(route_table, 0, sizeof(route_table));
+    memset(sysid_channel_mask, 0, sizeof(sysid_channel_mask));
+}
 
 /*
   forward a MAVLink message to the right port. This also
@@ -135,32 +141,28 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
     }
 
     // forward on any channels matching the targets
-    bool forwarded = false;
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (broadcast_system || (target_system == routes[i].sysid &&
-                                 (broadcast_component || 
-                                  target_component == routes[i].compid ||
-                                  !match_system))) {
-            if (in_channel != routes[i].channel && !sent_to_chan[routes[i].channel]) {
-                if (comm_get_txspace(routes[i].channel) >= ((uint16_t)msg->len) +
-                    GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
+    uint8_t mask;
+    if (broadcast_system) {
+        mask = all_channel_mask;
+    } else if (broadcast_component || !match_system) {
+        mask = sysid_channel_mask[target_system];
+    } else {
+        const route *r = find_route(target_system, target_component);
+        mask = (r != nullptr) ? r->channel_mask : 0;
+    }
+    mask &= ~(1U<<(in_channel-MAVLINK_COMM_0));
+    const bool forwarded = (mask != 0);
 #if ROUTING_DEBUG
-                    ::printf("fwd msg %u from chan %u on chan %u sysid=%d compid=%d\n",
-                             msg->msgid,
-                             (unsigned)in_channel,
-                             (unsigned)routes[i].channel,
-                             (int)target_system,
-                             (int)target_component);
-#endif
-                    _mavlink_resend_uart(routes[i].channel, msg);
-                }
-                sent_to_chan[routes[i].channel] = true;
-                forwarded = true;
-            }
-        }
+    if (forwarded) {
+        ::printf("fwd msg %u from chan %u on mask 0x%02x sysid=%d compid=%d\n",
+                 msg->msgid,
+                 (unsigned)in_channel,
+                 (unsigned)mask,
+                 (int)target_system,
+                 (int)target_component);
     }
+#endif
+    resend(mask, msg);
     if (!forwarded && match_system) {
         process_locally = true;
     }
@@ -175,24 +177,22 @@ bool MAVLink_routing::check_and_forward(mavlink_channel_t in_channel, const mavl
 */
 void MAVLink_routing::send_to_components(const mavlink_message_t* msg)
 {
-    bool sent_to_chan[MAVLINK_COMM_NUM_BUFFERS];
-    memset(sent_to_chan, 0, sizeof(sent_to_chan));
+    resend(sysid_channel_mask[mavlink_system.sysid], msg);
+}
 
-    // check learned routes
-    for (uint8_t i=0; i<num_routes; i++) {
-        if ((routes[i].sysid == mavlink_system.sysid) && !sent_to_chan[routes[i].channel]) {
-            if (comm_get_txspace(routes[i].channel) >= ((uint16_t)msg->len) +
-                GCS_MAVLINK::packet_overhead_chan(routes[i].channel)) {
-#if ROUTING_DEBUG
-                ::printf("send msg %u on chan %u sysid=%u compid=%u\n",
-                         msg->msgid,
-                         (unsigned)routes[i].channel,
-                         (unsigned)routes[i].sysid,
-                         (unsigned)routes[i].compid);
-#endif
-                _mavlink_resend_uart(routes[i].channel, msg);
-                sent_to_chan[routes[i].channel] = true;
-            }
+/*
+  send a message on each channel in mask that has room for it
+*/
+void MAVLink_routing::resend(uint8_t mask, const mavlink_message_t* msg) const
+{
+    for (uint8_t i=0; mask != 0; i++, mask >>= 1) {
+        if (!(mask & 1)) {
+            continue;
+        }
+        const mavlink_channel_t channel = (mavlink_channel_t)(MAVLINK_COMM_0 + i);
+        if (comm_get_txspace(channel) >= ((uint16_t)msg->len) +
+            GCS_MAVLINK::packet_overhead_chan(channel)) {
+            _mavlink_resend_uart(channel, msg);
         }
     }
 }
@@ -217,35 +217,65 @@ bool MAVLink_routing::find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &
     return false;
 }
 
+uint8_t MAVLink_routing::route_slot(uint8_t sysid, uint8_t compid) const
+{
+    static_assert(MAVLINK_ROUTE_TABLE_SIZE <= 256, "route table slots must fit in a uint8_t");
+    static_assert(MAVLINK_ROUTE_TABLE_SIZE >= 2 * MAVLINK_MAX_ROUTES, "route table needs at least twice MAVLINK_MAX_ROUTES slots");
+
+    // Fibonacci hash of the sysid/compid pair, taking the top
+    // MAVLINK_ROUTE_TABLE_BITS bits as the slot
+    const uint16_t key = (sysid << 8) | compid;
+    uint8_t slot = (uint32_t)(key * 2654435769U) >> (32 - MAVLINK_ROUTE_TABLE_BITS);
+    while (route_table[slot] != 0) {
+        const route &r = routes[route_table[slot]-1];
+        if (r.sysid == sysid && r.compid == compid) {
+            break;
+        }
+        slot = (slot + 1) % MAVLINK_ROUTE_TABLE_SIZE;
+    }
+    return slot;
+}
+
+MAVLink_routing::route *MAVLink_routing::find_route(uint8_t sysid, uint8_t compid)
+{
+    const uint8_t slot = route_slot(sysid, compid);
+    if (route_table[slot] == 0) {
+        return nullptr;
+    }
+    return &routes[route_table[slot]-1];
+}
+
 /*
   see if the message is for a new route and learn it
 */
 void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_message_t* msg)
 {
-    uint8_t i;
     if (msg->sysid == 0 || 
         (msg->sysid == mavlink_system.sysid && 
          msg->compid == mavlink_system.compid)) {
         return;
     }
-    for (i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg->sysid && 
-            routes[i].compid == msg->compid &&
-            routes[i].channel == in_channel) {
-            if (routes[i].mavtype == 0 && msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                routes[i].mavtype = mavlink_msg_heartbeat_get_type(msg);
-            }
-            break;
-        }
+    const uint8_t slot = route_slot(msg->sysid, msg->compid);
+    route *r;
+    if (route_table[slot] != 0) {
+        r = &routes[route_table[slot]-1];
+    } else if (num_routes < MAVLINK_MAX_ROUTES) {
+        r = &routes[num_routes++];
+        r->sysid = msg->sysid;
+        r->compid = msg->compid;
+        r->channel = in_channel;
+        r->channel_mask = 0;
+        r->mavtype = 0;
+        route_table[slot] = num_routes;
+    } else {
+        return;
     }
-    if (i == num_routes && i<MAVLINK_MAX_ROUTES) {
-        routes[i].sysid = msg->sysid;
-        routes[i].compid = msg->compid;
-        routes[i].channel = in_channel;
-        if (msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-            routes[i].mavtype = mavlink_msg_heartbeat_get_type(msg);
-        }
-        num_routes++;
+
+    const uint8_t chan_bit = 1U<<(in_channel-MAVLINK_COMM_0);
+    if (!(r->channel_mask & chan_bit)) {
+        r->channel_mask |= chan_bit;
+        sysid_channel_mask[r->sysid] |= chan_bit;
+        all_channel_mask |= chan_bit;
 #if ROUTING_DEBUG
         ::printf("learned route %u %u via %u\n",
                  (unsigned)msg->sysid, 
@@ -253,6 +283,10 @@ void MAVLink_routing::learn_route(mavlink_channel_t in_channel, const mavlink_me
                  (unsigned)in_channel);
 #endif
     }
+    if (r->mavtype == 0 && msg->msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        r->mavtype = mavlink_msg_heartbeat_get_type(msg);
+        r->channel = in_channel;
+    }
 }
 
 
@@ -273,10 +307,9 @@ void MAVLink_routing::handle_heartbeat(mavlink_channel_t in_channel, const mavli
     mask &= ~no_route_mask;
     
     // mask out channels that are known sources for this sysid/compid
-    for (uint8_t i=0; i<num_routes; i++) {
-        if (routes[i].sysid == msg->sysid && routes[i].compid == msg->compid) {
-            mask &= ~(1U<<((unsigned)(routes[i].channel-MAVLINK_COMM_0)));
-        }
+    const route *r = find_route(msg->sysid, msg->compid);
+    if (r != nullptr) {
+        mask &= ~r->channel_mask;
     }
 
     if (mask == 0) {
@@ -10,6 +10,11 @@
 // we make more extensive use of MAVLink forwarding
 #define MAVLINK_MAX_ROUTES 20
 
+// slots in the route lookup table. A power of two at least twice
+// MAVLINK_MAX_ROUTES keeps probe runs short
+#define MAVLINK_ROUTE_TABLE_BITS 6
+#define MAVLINK_ROUTE_TABLE_SIZE (1U << MAVLINK_ROUTE_TABLE_BITS)
+
 /*
   object to handle MAVLink packet routing
  */
@@ -42,16 +47,37 @@ public:
     bool find_by_mavtype(uint8_t mavtype, uint8_t &sysid, uint8_t &compid, mavlink_channel_t &channel);
 
 private:
-    // a simple linear routing table. We don't expect to have a lot of
-    // routes, so a scalable structure isn't worthwhile yet.
+    // one route per sysid/compid we have heard from, with a mask of
+    // the channels it was heard on. Routes are never removed
     uint8_t num_routes;
     struct route {
         uint8_t sysid;
         uint8_t compid;
-        mavlink_channel_t channel;
+        mavlink_channel_t channel; // channel its mavtype was learned on
+        uint8_t channel_mask;
         uint8_t mavtype;
     } routes[MAVLINK_MAX_ROUTES];
-    
+
+    // open addressing table from sysid/compid to one more than the
+    // index in routes[], zero for an empty slot
+    uint8_t route_table[MAVLINK_ROUTE_TABLE_SIZE];
+
+    // channels any component of each sysid was heard on
+    uint8_t sysid_channel_mask[256];
+
+    // channels any route was heard on, for broadcast forwarding
+    uint8_t all_channel_mask;
+
+    // slot in route_table holding the route for a sysid/compid, or
+    // the empty slot where it would go
+    uint8_t route_slot(uint8_t sysid, uint8_t compid) const;
+
+    // find the route for a sysid/compid, or nullptr if none is known
+    route *find_route(uint8_t sysid, uint8_t compid);
+
+    // send msg on each channel in mask that has room for it
+    void resend(uint8_t mask, const mavlink_message_t* msg) const;
+
     // a channel mask to block routing as required
     uint8_t no_route_mask;
     
@@ -41,6 +41,14 @@ public:
      */
     void set_speedup(float speedup);
 
+    /*
+      disable synchronisation with the wall clock, so the simulation
+      runs as fast as the CPU allows
+     */
+    void disable_time_sync(void) {
+        use_time_sync = false;
+    }
+
     /*
       set instance number
      */
@@ -0,0 +1,208 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  write-back journal in front of a StorageAccess
+ */
+
+#include "StorageJournal.h"
+
+#include <AP_Math/AP_Math.h>
+
+#include <string.h>
+
+StorageJournal::StorageJournal(const StorageAccess &backend) :
+    _backend(backend),
+    _backend_writes(0)
+{
+#if STORAGE_JOURNAL_ENABLED
+    _num_used = 0;
+    _first_write_ms = 0;
+#endif
+}
+
+bool StorageJournal::write_backend(uint16_t dst, const void *src, size_t n)
+{
+    _backend_writes++;
+    return _backend.write_block(dst, src, n);
+}
+
+#if STORAGE_JOURNAL_ENABLED
+
+/*
+  return true if a write overlaps or is adjacent to a held range
+ */
+bool StorageJournal::touches(const struct entry &e, uint16_t ofs, uint16_t n) const
+{
+    return ofs <= e.offset + e.length && ofs + n >= e.offset;
+}
+
+/*
+  replace the held ranges from index oldest onwards with one range
+  holding them and the write. Bytes between them come from the
+  backend. Returns false if the result would not fit in one range, or
+  would cover part of an older range
+ */
+bool StorageJournal::merge(uint8_t oldest, uint16_t ofs, const uint8_t *b, uint16_t n)
+{
+    uint16_t start = ofs;
+    uint16_t end = ofs + n;
+    for (uint8_t i=oldest; i<_num_used; i++) {
+        start = MIN(start, _entries[i].offset);
+        end = MAX(end, _entries[i].offset + _entries[i].length);
+    }
+    if (end - start > STORAGE_JOURNAL_ENTRY_SIZE) {
+        return false;
+    }
+    for (uint8_t i=0; i<oldest; i++) {
+        if (start < _entries[i].offset + _entries[i].length && end > _entries[i].offset) {
+            return false;
+        }
+    }
+
+    uint8_t data[STORAGE_JOURNAL_ENTRY_SIZE];
+    _backend.read_block(data, start, end - start);
+    for (uint8_t i=oldest; i<_num_used; i++) {
+        const struct entry &e = _entries[i];
+        memcpy(&data[e.offset - start], e.data, e.length);
+    }
+    memcpy(&data[ofs - start], b, n);
+
+    struct entry &e = _entries[oldest];
+    e.offset = start;
+    e.length = end - start;
+    memcpy(e.data, data, e.length);
+    _num_used = oldest + 1;
+    return true;
+}
+
+void StorageJournal::add(uint16_t ofs, const uint8_t *b, uint16_t n)
+{
+    if (_num_used == STORAGE_JOURNAL_NUM_ENTRIES) {
+        flush_locked();
+    }
+    if (_num_used == 0) {
+        _first_write_ms = AP_HAL::millis();
+    }
+    struct entry &e = _entries[_num_used++];
+    e.offset = ofs;
+    e.length = n;
+    memcpy(e.data, b, n);
+}
+
+void StorageJournal::flush_locked(void)
+{
+    for (uint8_t i=0; i<_num_used; i++) {
+        const struct entry &e = _entries[i];
+        write_backend(e.offset, e.data, e.length);
+    }
+    _num_used = 0;
+}
+
+bool StorageJournal::read_block(void *dst, uint16_t src, size_t n)
+{
+    uint8_t *b = (uint8_t *)dst;
+    const uint16_t src_end = src + n;
+    _sem.take_blocking();
+    bool ret = _backend.read_block(dst, src, n);
+    for (uint8_t i=0; i<_num_used; i++) {
+        const struct entry &e = _entries[i];
+        const uint16_t start = MAX(e.offset, src);
+        const uint16_t end = MIN(e.offset + e.length, src_end);
+        if (start < end) {
+            memcpy(&b[start - src], &e.data[start - e.offset], end - start);
+        }
+    }
+    _sem.give();
+    return ret;
+}
+
+bool StorageJournal::write_block(uint16_t dst, const void *src, size_t n)
+{
+    const uint8_t *b = (const uint8_t *)src;
+    if (n == 0) {
+        return true;
+    }
+    if (dst + n > size()) {
+        return false;
+    }
+
+    _sem.take_blocking();
+
+    if (n > STORAGE_JOURNAL_ENTRY_SIZE) {
+        // too large to hold, so write it after the held ranges
+        flush_locked();
+        bool ret = write_backend(dst, src, n);
+        _sem.give();
+        return ret;
+    }
+
+    // a write can only join a held range if every range held after
+    // that one joins too, otherwise it would reach the backend before
+    // writes journalled ahead of it
+    uint8_t oldest = _num_used;
+    for (uint8_t i=0; i<_num_used; i++) {
+        if (touches(_entries[i], dst, n)) {
+            oldest = i;
+            break;
+        }
+    }
+    if (oldest == _num_used) {
+        add(dst, b, n);
+    } else if (!merge(oldest, dst, b, n)) {
+        flush_locked();
+        add(dst, b, n);
+    }
+
+    _sem.give();
+    return true;
+}
+
+void StorageJournal::update(void)
+{
+    if (_num_used == 0 ||
+        AP_HAL::millis() - _first_write_ms < STORAGE_JOURNAL_FLUSH_MS) {
+        return;
+    }
+    flush();
+}
+
+void StorageJournal::flush(void)
+{
+    _sem.take_blocking();
+    flush_locked();
+    _sem.give();
+}
+
+#else // STORAGE_JOURNAL_ENABLED
+
+bool StorageJournal::read_block(void *dst, uint16_t src, size_t n)
+{
+    return _backend.read_block(dst, src, n);
+}
+
+bool StorageJournal::write_block(uint16_t dst, const void *src, size_t n)
+{
+    return write_backend(dst, src, n);
+}
+
+void StorageJournal::update(void)
+{
+}
+
+void StorageJournal::flush(void)
+{
+}
+
+#endif // STORAGE_JOURNAL_ENABLED
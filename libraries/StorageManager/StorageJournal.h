@@ -0,0 +1,103 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  write-back journal in front of a StorageAccess
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#include "StorageManager.h"
+
+#ifndef STORAGE_JOURNAL_ENABLED
+#define STORAGE_JOURNAL_ENABLED !HAL_MINIMIZE_FEATURES
+#endif
+
+// number of ranges held, and the maximum length of each range
+#define STORAGE_JOURNAL_NUM_ENTRIES 8
+#define STORAGE_JOURNAL_ENTRY_SIZE  64
+
+// maximum time a write is held before it goes to the backend
+#define STORAGE_JOURNAL_FLUSH_MS    500
+
+/*
+  A StorageJournal holds writes in RAM, merging overlapping and
+  adjacent writes into one range, so that a burst of small writes
+  becomes a few larger backend writes and bytes overwritten while held
+  (such as the sentinal after each new parameter) never reach the
+  backend. Reads see the held writes.
+
+  Held writes go to the backend when the journal is full, from
+  update() once the oldest has been held for STORAGE_JOURNAL_FLUSH_MS,
+  or from flush(). Each range goes to the backend as one write, in the
+  order the ranges were journalled, and a write is only merged into a
+  range if no later range has to be written before it. So no byte
+  reaches the backend in an earlier write than a byte journalled
+  before it, which keeps the order AP_Param relies on, where the
+  sentinal after a new parameter reaches storage no later than the
+  header that replaces the old sentinal
+ */
+class StorageJournal {
+public:
+    StorageJournal(const StorageAccess &backend);
+
+    // return total size of the backend
+    uint16_t size(void) const { return _backend.size(); }
+
+    bool read_block(void *dst, uint16_t src, size_t n);
+    bool write_block(uint16_t dst, const void *src, size_t n);
+
+    // write held data to the backend if the oldest write is due
+    void update(void);
+
+    // write all held data to the backend
+    void flush(void);
+
+    // true if there are writes not yet in the backend
+    bool pending(void) const {
+#if STORAGE_JOURNAL_ENABLED
+        return _num_used != 0;
+#else
+        return false;
+#endif
+    }
+
+    // number of writes made to the backend
+    uint32_t backend_writes(void) const { return _backend_writes; }
+
+protected:
+    // write to the backend, overridden by tests to see the order of
+    // writes
+    virtual bool write_backend(uint16_t dst, const void *src, size_t n);
+
+private:
+    const StorageAccess &_backend;
+    uint32_t _backend_writes;
+
+#if STORAGE_JOURNAL_ENABLED
+    struct entry {
+        uint16_t offset;
+        uint16_t length;
+        uint8_t data[STORAGE_JOURNAL_ENTRY_SIZE];
+    } _entries[STORAGE_JOURNAL_NUM_ENTRIES];
+    uint8_t _num_used;
+    uint32_t _first_write_ms;
+    HAL_Semaphore _sem;
+
+    bool touches(const struct entry &e, uint16_t ofs, uint16_t n) const;
+    bool merge(uint8_t oldest, uint16_t ofs, const uint8_t *b, uint16_t n);
+    void add(uint16_t ofs, const uint8_t *b, uint16_t n);
+    void flush_locked(void);
+#endif
+};
@@ -0,0 +1,245 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_gtest.h>
+
+#include <StorageManager/StorageJournal.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+/*
+  the SITL storage backend keeps eeprom.bin in the current directory,
+  so run the tests in a temporary directory
+ */
+class TempDirEnvironment : public ::testing::Environment {
+public:
+    void SetUp() override
+    {
+        ASSERT_NE(nullptr, mkdtemp(_dir));
+        ASSERT_EQ(0, chdir(_dir));
+    }
+
+    void TearDown() override
+    {
+        unlink("eeprom.bin");
+        if (chdir("/") == 0) {
+            rmdir(_dir);
+        }
+    }
+
+private:
+    char _dir[32] = "/tmp/storage_journal.XXXXXX";
+};
+
+static ::testing::Environment *const temp_dir_env = ::testing::AddGlobalTestEnvironment(new TempDirEnvironment);
+
+// the mission area is used as it is large enough for a 500 parameter
+// upload on all layouts used for tests
+static StorageAccess backend(StorageManager::StorageMission);
+
+#define PARAM_HEADER_SIZE 4
+#define PARAM_VALUE_SIZE  4
+#define PARAM_RECORD_SIZE (PARAM_HEADER_SIZE+PARAM_VALUE_SIZE)
+
+/*
+  write parameter records the way AP_Param::save_sync() adds a new
+  parameter: a sentinal after the record, then the value, then the
+  header over the previous sentinal
+ */
+static uint32_t upload(StorageJournal &journal, uint16_t count)
+{
+    uint32_t writes = 0;
+    uint16_t ofs = PARAM_HEADER_SIZE;
+    for (uint16_t i=0; i<count; i++) {
+        const uint32_t sentinal = 0xFFFFFFFF;
+        const uint32_t header = 0x10000 | i;
+        const float value = i * 0.5f;
+        journal.write_block(ofs + PARAM_RECORD_SIZE, &sentinal, sizeof(sentinal));
+        journal.write_block(ofs + PARAM_HEADER_SIZE, &value, sizeof(value));
+        journal.write_block(ofs, &header, sizeof(header));
+        writes += 3;
+        ofs += PARAM_RECORD_SIZE;
+    }
+    return writes;
+}
+
+static void check_upload(const StorageAccess &storage, uint16_t count)
+{
+    uint16_t ofs = PARAM_HEADER_SIZE;
+    for (uint16_t i=0; i<count; i++) {
+        uint32_t header;
+        float value;
+        storage.read_block(&header, ofs, sizeof(header));
+        storage.read_block(&value, ofs + PARAM_HEADER_SIZE, sizeof(value));
+        ASSERT_EQ(0x10000U | i, header);
+        ASSERT_FLOAT_EQ(i * 0.5f, value);
+        ofs += PARAM_RECORD_SIZE;
+    }
+    uint32_t sentinal;
+    storage.read_block(&sentinal, ofs, sizeof(sentinal));
+    ASSERT_EQ(0xFFFFFFFFU, sentinal);
+}
+
+TEST(StorageJournal, ParamUpload)
+{
+    StorageJournal journal(backend);
+
+    const uint32_t writes = upload(journal, 500);
+    journal.flush();
+    EXPECT_FALSE(journal.pending());
+
+    check_upload(backend, 500);
+
+#if STORAGE_JOURNAL_ENABLED
+    // each backend write should carry several parameters
+    EXPECT_LT(journal.backend_writes() * 5, writes);
+#else
+    EXPECT_EQ(writes, journal.backend_writes());
+#endif
+}
+
+/*
+  a journal which keeps a copy of what its backend writes leave in
+  storage, and checks after each one that the copy is a valid chain of
+  the records written by upload(), so the order of backend writes
+  never leaves a header without its value and a sentinal after it
+ */
+class OrderCheckJournal : public StorageJournal {
+public:
+    OrderCheckJournal(const StorageAccess &storage) :
+        StorageJournal(storage),
+        bad_states(0)
+    {
+        storage.read_block(image, 0, sizeof(image));
+    }
+
+    uint16_t bad_states;
+
+protected:
+    bool write_backend(uint16_t dst, const void *src, size_t n) override
+    {
+        if (dst + n <= sizeof(image)) {
+            memcpy(&image[dst], src, n);
+            if (!chain_valid()) {
+                bad_states++;
+            }
+        }
+        return StorageJournal::write_backend(dst, src, n);
+    }
+
+private:
+    uint8_t image[1024];
+
+    bool chain_valid() const
+    {
+        uint16_t ofs = PARAM_HEADER_SIZE;
+        for (uint16_t i=0; ofs <= sizeof(image) - PARAM_RECORD_SIZE; i++) {
+            uint32_t header;
+            memcpy(&header, &image[ofs], sizeof(header));
+            if (header == 0xFFFFFFFF) {
+                return true;
+            }
+            const float value = i * 0.5f;
+            if (header != (0x10000U | i) ||
+                memcmp(&image[ofs + PARAM_HEADER_SIZE], &value, sizeof(value)) != 0) {
+                return false;
+            }
+            ofs += PARAM_RECORD_SIZE;
+        }
+        return false;
+    }
+};
+
+TEST(StorageJournal, SaveOrder)
+{
+    // start from an empty chain
+    uint8_t empty[1024];
+    memset(empty, 0, sizeof(empty));
+    memset(&empty[PARAM_HEADER_SIZE], 0xFF, PARAM_HEADER_SIZE);
+    backend.write_block(0, empty, sizeof(empty));
+
+    // 100 records cross many range boundaries, and records are split
+    // between ranges in every possible place
+    OrderCheckJournal journal(backend);
+    upload(journal, 100);
+    journal.flush();
+
+    EXPECT_EQ(0, journal.bad_states);
+    check_upload(backend, 100);
+}
+
+TEST(StorageJournal, RepeatedSave)
+{
+    StorageJournal journal(backend);
+
+    // a tuning session saving the same parameter many times
+    for (uint16_t i=0; i<200; i++) {
+        const float value = i;
+        journal.write_block(100, &value, sizeof(value));
+    }
+    journal.flush();
+
+    float value;
+    backend.read_block(&value, 100, sizeof(value));
+    EXPECT_FLOAT_EQ(199, value);
+#if STORAGE_JOURNAL_ENABLED
+    EXPECT_EQ(1U, journal.backend_writes());
+#endif
+}
+
+TEST(StorageJournal, ReadsSeePendingWrites)
+{
+    StorageJournal journal(backend);
+    uint8_t expected[512];
+    uint8_t buf[sizeof(expected)];
+
+    memset(expected, 0, sizeof(expected));
+    backend.write_block(0, expected, sizeof(expected));
+
+    // scattered overlapping writes of varying length, checked against
+    // a copy after each one
+    uint32_t seed = 1;
+    for (uint16_t i=0; i<2000; i++) {
+        seed = seed * 1103515245 + 12345;
+        const uint16_t len = 1 + (seed >> 8) % 80;
+        const uint16_t ofs = (seed >> 16) % (sizeof(expected) - len);
+        uint8_t data[80];
+        for (uint8_t j=0; j<len; j++) {
+            data[j] = i + j;
+        }
+        memcpy(&expected[ofs], data, len);
+        ASSERT_TRUE(journal.write_block(ofs, data, len));
+
+        ASSERT_TRUE(journal.read_block(buf, 0, sizeof(buf)));
+        ASSERT_EQ(0, memcmp(expected, buf, sizeof(buf)));
+    }
+
+    journal.flush();
+    backend.read_block(buf, 0, sizeof(buf));
+    ASSERT_EQ(0, memcmp(expected, buf, sizeof(buf)));
+}
+
+TEST(StorageJournal, OutOfRange)
+{
+    StorageJournal journal(backend);
+    uint8_t data[8] {};
+
+    EXPECT_FALSE(journal.write_block(journal.size() - 4, data, sizeof(data)));
+    EXPECT_FALSE(journal.pending());
+}
+
+AP_GTEST_MAIN()